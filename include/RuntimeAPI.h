@@ -83,6 +83,20 @@ typedef struct {
     size_t    sizeBytes;
 } NeuronTensorInfo;
 
+/* NeuronTensorInfo.type values beyond the documented first three are a
+ * neuron-shim extension. */
+typedef enum {
+    NEURON_SHIM_TYPE_FLOAT32 = 0,
+    NEURON_SHIM_TYPE_UINT8   = 1,
+    NEURON_SHIM_TYPE_INT8    = 2,
+    NEURON_SHIM_TYPE_FLOAT16 = 3,
+    NEURON_SHIM_TYPE_INT16   = 4,
+    NEURON_SHIM_TYPE_INT32   = 5,
+    NEURON_SHIM_TYPE_INT64   = 6,
+    NEURON_SHIM_TYPE_BOOL    = 7,
+    NEURON_SHIM_TYPE_UNKNOWN = 255,
+} NeuronShimTensorType;
+
 /* Opaque handle */
 typedef void* NeuronRuntime;
 
@@ -134,12 +148,80 @@ int NeuronRuntime_getOutputSize(NeuronRuntime runtime, int index, size_t* size);
 int NeuronRuntime_inference(NeuronRuntime runtime);
 
 /* ------------------------------------------------------------------ */
-/* QoS (all no-ops in shim, return success)                            */
+/* QoS (priority gating + abortTime; see scheduler.h)                  */
 /* ------------------------------------------------------------------ */
 int NeuronRuntime_setQoSOption(NeuronRuntime runtime, const QoSOptions* qos);
 int NeuronRuntime_getProfiledQoSData(NeuronRuntime runtime,
                                       QoSOptions* qos);
 
+/* ------------------------------------------------------------------ */
+/* neuron-shim extension: asynchronous inference                       */
+/*                                                                     */
+/* inferenceAsync starts an inference on the runtime's own worker      */
+/* thread and returns at once; wait blocks until it is done and        */
+/* returns what NeuronRuntime_inference would have. In between, the    */
+/* bound buffers belong to the shim: setInput, setOutput, inference    */
+/* and a second inferenceAsync fail with NEURONRUNTIME_BAD_STATE. Use  */
+/* one runtime per frame in flight.                                    */
+/*                                                                     */
+/* Apps that can't be changed get the same overlap from pipeline mode  */
+/* ('pipeline = true' in the model's [model] section): inference       */
+/* copies the inputs, starts the frame and returns the previous        */
+/* frame's outputs and result, so the app sees one frame of latency.   */
+/* The first call returns zeroed outputs.                              */
+/* ------------------------------------------------------------------ */
+int NeuronRuntime_inferenceAsync(NeuronRuntime runtime);
+int NeuronRuntime_wait(NeuronRuntime runtime);
+
+/* ------------------------------------------------------------------ */
+/* neuron-shim extension: profiled QoS data                            */
+/*                                                                     */
+/* getProfiledQoSData sets qos->profiledQoSData to a                   */
+/* NeuronShimProfiledQoSData owned by the runtime (valid until the     */
+/* next call or NeuronRuntime_release) and profiledQoSDataSize to its  */
+/* size. Check 'version' before reading. On real Neuron hardware the   */
+/* pointer is a vendor ProfiledQoSData instead.                        */
+/*                                                                     */
+/* Version 2 appends 'memory'. Runtimes that share a model share its   */
+/* arenas, so they report the same figures. All zero if the backend    */
+/* can't tell (tflite, stub).                                          */
+/*                                                                     */
+/* Version 3 appends 'eps': the execution providers (onnx) or delegate */
+/* (tflite) that actually registered for the runtime's model, after    */
+/* fallbacks and ep = auto, e.g. "cuda+cpu" or "xnnpack+cpu". Empty    */
+/* until a model is loaded, and for the stub.                          */
+/* ------------------------------------------------------------------ */
+#define NEURON_SHIM_QOS_DATA_VERSION 3
+
+typedef struct {
+    uint64_t count;
+    uint64_t mean_ns;
+    uint64_t p50_ns;
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t max_ns;
+} NeuronShimLatencyStats;
+
+/* Bytes held by the backend's allocators for a runtime's model */
+typedef struct {
+    uint64_t host_bytes;     /* in use now */
+    uint64_t host_peak;      /* most ever in use */
+    uint64_t device_bytes;
+    uint64_t device_peak;
+} NeuronShimMemoryStats;
+
+typedef struct {
+    uint32_t version;       /* NEURON_SHIM_QOS_DATA_VERSION */
+    uint32_t size;          /* sizeof(NeuronShimProfiledQoSData) */
+    char     backend[16];   /* "onnx", "tflite", "stub" */
+    NeuronShimLatencyStats inference;    /* NeuronRuntime_inference */
+    NeuronShimLatencyStats set_input;    /* NeuronRuntime_setInput */
+    NeuronShimLatencyStats set_output;   /* NeuronRuntime_setOutput */
+    NeuronShimLatencyStats load;         /* NeuronRuntime_loadNetwork* */
+    NeuronShimMemoryStats  memory;       /* version >= 2 */
+    char     eps[64];       /* version >= 3, '+'-separated */
+} NeuronShimProfiledQoSData;
+
 #ifdef __cplusplus
 }
 #endif
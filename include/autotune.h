@@ -0,0 +1,59 @@
+/*
+ * neuron-shim: Load-time autotuning
+ *
+ * 'threads = auto' and 'ep = auto' make a backend time a few candidate
+ * settings with synthetic inputs while it loads the model, and keep the
+ * fastest. The winner is stored per (model hash, hardware fingerprint)
+ * under <cache_dir>/tune/, so later starts on the same box apply it
+ * without tuning again. The fingerprint covers the CPU model, the CPUs
+ * the process may use and whatever the backend adds (runtime version,
+ * affinity, delegate), so a different SKU or runtime tunes afresh.
+ */
+
+#ifndef NEURON_SHIM_AUTOTUNE_H
+#define NEURON_SHIM_AUTOTUNE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NEURON_SHIM_TUNE_MAX_THREADS 8   /* thread-count candidates */
+
+typedef struct {
+    int  threads;       /* 0 = not tuned */
+    char ep[64];        /* onnx EP list, empty = not tuned */
+} NeuronShimTuning;
+
+/*
+ * Thread counts worth trying on the CPUs 'cpu_affinity' selects (every
+ * CPU the process may use if empty): 1, 2, 4, ... and the CPU count.
+ * @return number written to 'out'
+ */
+int neuron_shim_tune_threads(const char* cpu_affinity, int* out, int max);
+
+/*
+ * Result file for a model on this machine. 'variant' names the backend
+ * and anything else the result depends on, e.g. "onnx-1.20.0".
+ * @return 0, or -1 if cache_dir is unset or can't be created
+ */
+int neuron_shim_tune_file(uint64_t model_hash, const char* variant,
+                          char* out, size_t len);
+
+/* @return 0 if 'file' holds a result, -1 otherwise */
+int neuron_shim_tune_load(const char* file, NeuronShimTuning* t);
+int neuron_shim_tune_save(const char* file, const NeuronShimTuning* t);
+
+/*
+ * Median wall time of 'run' in microseconds, after one untimed run.
+ * @return 0, or -1 if any run failed
+ */
+int neuron_shim_tune_measure(int (*run)(void* arg), void* arg, double* us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NEURON_SHIM_AUTOTUNE_H */
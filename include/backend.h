@@ -4,6 +4,12 @@
  * Each backend implements this interface. The shim selects which
  * backend to use at runtime based on the NEURON_SHIM_BACKEND env var
  * or auto-detects from available libraries.
+ *
+ * Only the stub is built into libneuronrt.so. The others are plugins,
+ * libneuronrt-<name>.so, each linked against its own runtime and
+ * dlopened the first time a backend of that name is wanted, so a
+ * stub-only run never maps ONNX Runtime or TFLite, and e.g. a CUDA and
+ * a CPU ORT build can be installed side by side as onnx-cuda/onnx-cpu.
  */
 
 #ifndef NEURON_SHIM_BACKEND_H
@@ -12,16 +18,33 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "RuntimeAPI.h"
+#include "config.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Full description of one model tensor (see get_input_info) */
+typedef struct {
+    uint32_t dims[8];
+    uint32_t rank;
+    uint32_t type;          /* NeuronShimTensorType */
+    float    scale;         /* quantized tensors; 0 = not quantized */
+    int32_t  zero_point;
+    size_t   size;          /* bytes */
+} ShimTensorDesc;
+
 /* ------------------------------------------------------------------ */
 /* Backend interface — every backend implements these                   */
 /* ------------------------------------------------------------------ */
 typedef struct NeuronShimBackend {
     const char* name;
 
+    /* Process-wide setup, called once from shim init before the first
+     * create(). Optional (may be NULL). */
+    int  (*init)(const NeuronShimConfig* cfg);
+
     /* Lifecycle */
     int  (*create)(void** ctx);
     void (*destroy)(void* ctx);
@@ -33,12 +56,28 @@ typedef struct NeuronShimBackend {
     int  (*load_from_file)(void* ctx, const char* path);
     int  (*load_from_buffer)(void* ctx, const void* buf, size_t size);
 
+    /* Shared models (optional).
+     * A model is the heavyweight, read-only part of a loaded network
+     * (parsed graph, weights, optimized session) and can back many
+     * contexts at once. model_load() builds one from a resolved path,
+     * attach() binds a fresh context to it; the context keeps its own
+     * I/O binding state and must not outlive the model.
+     * If model_load is NULL the shim uses load_from_file per runtime. */
+    int  (*model_load)(const char* path, void** model);
+    void (*model_release)(void* model);
+    int  (*attach)(void* ctx, void* model);
+
     /* Tensor metadata */
     int  (*get_input_count)(void* ctx, uint32_t* count);
     int  (*get_output_count)(void* ctx, uint32_t* count);
     int  (*get_input_size)(void* ctx, int index, size_t* size);
     int  (*get_output_size)(void* ctx, int index, size_t* size);
 
+    /* Shape, element type and quantization. Optional (may be NULL);
+     * without them the shim only knows tensor sizes. */
+    int  (*get_input_info)(void* ctx, int index, ShimTensorDesc* desc);
+    int  (*get_output_info)(void* ctx, int index, ShimTensorDesc* desc);
+
     /* I/O binding */
     int  (*set_input)(void* ctx, int index, const void* buf, size_t size);
     int  (*set_output)(void* ctx, int index, void* buf, size_t size);
@@ -46,15 +85,46 @@ typedef struct NeuronShimBackend {
     /* Inference */
     int  (*invoke)(void* ctx);
 
+    /* Ask a running invoke() on ctx to stop early; it then returns an
+     * error. Called from another thread. A request that arrives before
+     * invoke() starts may be dropped. Optional (may be NULL). */
+    void (*abort)(void* ctx);
+
+    /* Current and peak allocator usage of ctx's model. Called from
+     * other threads, e.g. the stats dump. Optional (may be NULL). */
+    int  (*memory_usage)(void* ctx, NeuronShimMemoryStats* out);
+
+    /* Execution providers / delegate in use for ctx's model, most
+     * preferred first and '+'-separated ("tensorrt+cuda+cpu"). Called
+     * from other threads. Optional (may be NULL). */
+    int  (*providers)(void* ctx, char* out, size_t len);
+
 } NeuronShimBackend;
 
 /* ------------------------------------------------------------------ */
 /* Built-in backends                                                   */
 /* ------------------------------------------------------------------ */
-extern const NeuronShimBackend* neuron_shim_backend_tflite(void);
-extern const NeuronShimBackend* neuron_shim_backend_onnx(void);
 extern const NeuronShimBackend* neuron_shim_backend_stub(void);
 
+/* ------------------------------------------------------------------ */
+/* Plugins                                                             */
+/*                                                                     */
+/* A plugin exports NEURON_SHIM_PLUGIN_ENTRY, returning its table, or  */
+/* NULL if it was built against another NEURON_SHIM_BACKEND_ABI. Bump  */
+/* the ABI whenever NeuronShimBackend changes.                         */
+/* ------------------------------------------------------------------ */
+#define NEURON_SHIM_BACKEND_ABI  3
+#define NEURON_SHIM_PLUGIN_ENTRY "neuron_shim_plugin_backend"
+
+typedef const NeuronShimBackend* (*NeuronShimPluginFn)(uint32_t abi);
+
+/*
+ * Backend 'name': the stub, or the plugin libneuronrt-<name>.so from
+ * plugin_dir, else next to libneuronrt.so, else the library path.
+ * @return NULL if it isn't installed or can't be loaded
+ */
+const NeuronShimBackend* neuron_shim_load_backend(const char* name);
+
 /* Select backend by name or auto-detect */
 const NeuronShimBackend* neuron_shim_select_backend(const char* name);
 
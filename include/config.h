@@ -12,14 +12,107 @@
 #define NEURON_SHIM_CONFIG_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define NEURON_SHIM_MAX_MODELS 16   /* [model ...] sections */
+#define NEURON_SHIM_MAX_IO     8    /* tensors per model with per-tensor settings */
+#define NEURON_SHIM_MAX_SHAPES 4    /* shape hints per input */
+#define NEURON_SHIM_MAX_BATCH  32   /* runtimes coalesced into one run */
+
+#define NEURON_SHIM_THREADS_AUTO (-1)  /* threads = auto: tuned at load (autotune.h) */
+
+/*
+ * App-side view of one tensor, when it differs from the model's
+ * (see convert.h). Written in a [model] section as e.g.
+ *   input.0 = uint8,nhwc,scale=0.0078125,zero_point=128
+ */
+typedef struct {
+    bool     enabled;
+    uint32_t type;          /* NeuronShimTensorType of the app buffer */
+    bool     nhwc;          /* app buffer is NHWC, model tensor NCHW */
+    float    scale;         /* quantized app types; 0 = use the model's */
+    int32_t  zero_point;
+} NeuronShimTensorConv;
+
+/* One concrete shape for an input with symbolic dims; dims <= 0 are
+ * still inferred from the buffer size. */
+typedef struct {
+    uint32_t rank;
+    int64_t  dims[8];
+} NeuronShimShapeHint;
+
+/* Settings from a [model <glob>] section */
+typedef struct {
+    char pattern[256];      /* matched against the .dla path (basename if no '/') */
+    NeuronShimTensorConv inputs[NEURON_SHIM_MAX_IO];
+    NeuronShimTensorConv outputs[NEURON_SHIM_MAX_IO];
+
+    /* input_shape.N = 1x3x480x640,1x3x720x1280 */
+    NeuronShimShapeHint input_shapes[NEURON_SHIM_MAX_IO][NEURON_SHIM_MAX_SHAPES];
+    int                 input_shape_count[NEURON_SHIM_MAX_IO];
+
+    /* Routing; empty / 0 = the global setting */
+    char backend[32];       /* onnx | tflite | stub */
+    char suffix[32];        /* default: derived from 'backend' */
+    char ep[64];            /* onnx: EPs to try, e.g. "cuda,cpu", or "auto" */
+    int  threads;           /* or NEURON_SHIM_THREADS_AUTO */
+    char cpu_affinity[64];  /* see cpu_affinity.h */
+    bool cuda_graph;        /* onnx: replay a captured CUDA graph */
+
+    /* onnx: coalesce concurrent runtimes' inferences into one batch */
+    int  batch_window_us;   /* how long a batch collects, 0 = off */
+    int  max_batch;         /* 0 = NEURON_SHIM_MAX_BATCH */
+
+    bool pipeline;          /* inference returns the previous frame's outputs */
+    int  profile_runs;      /* inferences to profile (profile.h) */
+} NeuronShimModelConfig;
 
 typedef struct {
-    char backend[32];       /* auto | onnx | tflite | stub */
+    char backend[32];       /* auto | onnx | tflite | stub | other plugin */
+    char plugin_dir[512];   /* backend plugins, empty = next to libneuronrt.so */
     char suffix[32];        /* auto | .onnx | .tflite */
     char model_dir[512];    /* empty = use original path, else redirect */
-    int  threads;           /* CPU thread count */
+    int  threads;           /* CPU thread count, or NEURON_SHIM_THREADS_AUTO */
+    char cpu_affinity[64];  /* core list | big | little | numa:N, empty = any */
     bool force_cpu;         /* skip GPU execution providers */
+    char gpu_placement[16]; /* fixed | round_robin | least_loaded */
+    int  gpu_device;        /* device for 'fixed' */
+    int  gpu_count;         /* GPUs to spread over, 0 = detect */
     int  log_level;         /* 0=off 1=err 2=warn 3=info 4=debug */
+    int  log_rate_limit;    /* max messages/sec per log call site, 0 = off */
+    bool global_thread_pool;/* onnx: one process-wide intra-op pool */
+    char arena_extend_strategy[24]; /* onnx: next_power_of_two | same_as_requested, empty = ORT's */
+    size_t arena_max_memory;    /* onnx: bytes per arena, 0 = unlimited */
+    size_t arena_initial_chunk; /* onnx: first arena chunk in bytes, 0 = ORT default */
+    bool memory_pattern;        /* onnx: pre-plan activation memory per input shape */
+    bool arena_shrinkage;       /* onnx: hand idle arena chunks back after every run */
+    bool model_cache;       /* share loaded models across runtimes */
+    bool hot_swap;          /* reload cached models when their files change */
+    bool pinned_memory;     /* GPU backends: APU buffers in pinned host memory */
+    bool tflite_zero_copy;  /* tflite: map tensors onto app buffers */
+    char tflite_delegate[16];   /* auto | none | xnnpack | gpu */
+    bool xnnpack_fp16;          /* xnnpack: fp16 inference if supported */
+    char xnnpack_cache_dir[512];/* xnnpack weight cache dir, empty = off */
+    char cache_dir[512];        /* root for shim-managed caches, empty = off */
+    bool optimized_model_cache; /* onnx: persist graph-optimized models */
+    bool trt_engine_cache;      /* trt: persist built engines */
+    char trt_engine_cache_path[512]; /* empty = <cache_dir>/trt/<model hash> */
+    bool trt_timing_cache;      /* trt: persist kernel timing cache */
+    bool trt_fp16;              /* trt: allow fp16 kernels */
+    bool trt_int8;              /* trt: allow int8 kernels (needs calibration) */
+    size_t trt_max_workspace;   /* trt: builder workspace bytes, 0 = EP default */
+    char preload[512];          /* comma-separated .dla paths to load at init */
+    int  warmup_runs;           /* synthetic inferences per preloaded model */
+    bool qos_scheduler;         /* gate inferences by QoS priority */
+    char stats_dump[512];       /* SIGUSR1 stats dump file, "-" = stderr, empty = off */
+    char trace_file[512];       /* binary call trace for shim_replay, empty = off */
+    int  trace_sample_inputs;   /* record input bytes every Nth setInput, 0 = never */
+    char profile_file[512];     /* Chrome trace JSON, "%p" = pid, empty = off */
+    int  profile_runs;          /* inferences profiled per model, 0 = per-model only */
+
+    NeuronShimModelConfig models[NEURON_SHIM_MAX_MODELS];
+    int  model_count;
 } NeuronShimConfig;
 
 /*
@@ -28,10 +121,40 @@ typedef struct {
  */
 const NeuronShimConfig* neuron_shim_config_load(void);
 
+/*
+ * Get the global config without reloading it.
+ * Only valid after neuron_shim_config_load() has run.
+ */
+const NeuronShimConfig* neuron_shim_config_get(void);
+
 /*
  * Get the resolved suffix for model files.
  * If config says "auto", returns suffix based on backend.
  */
 const char* neuron_shim_config_get_suffix(const NeuronShimConfig* cfg);
 
+/*
+ * Settings for the model loaded from 'dla_path' (the path the app
+ * passed in, or the resolved model file — the model suffix is stripped
+ * before matching): the first [model] section whose glob matches, or
+ * NULL.
+ */
+const NeuronShimModelConfig* neuron_shim_config_model(const NeuronShimConfig* cfg,
+                                                      const char* dla_path);
+
+/*
+ * Suffix for models matching 'mc': its own suffix, else the one its
+ * backend implies, else neuron_shim_config_get_suffix(). mc may be NULL.
+ */
+const char* neuron_shim_config_model_suffix(const NeuronShimConfig* cfg,
+                                            const NeuronShimModelConfig* mc);
+
+/*
+ * Resolve <cache_dir>/<sub> into 'out', creating it (and any parents)
+ * if needed. 'sub' may contain slashes.
+ * @return 0 on success, -1 if cache_dir is unset or can't be created
+ */
+int neuron_shim_config_cache_subdir(const NeuronShimConfig* cfg, const char* sub,
+                                    char* out, size_t len);
+
 #endif /* NEURON_SHIM_CONFIG_H */
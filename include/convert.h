@@ -0,0 +1,86 @@
+/*
+ * neuron-shim: Tensor conversion between app buffers and the model
+ *
+ * Apps built for the MDLA often hand over quantized NHWC buffers while
+ * the converted model wants float NCHW (or fp16). When a [model]
+ * section describes the app side of a tensor, the shim gives the
+ * backend a staging buffer in the model's format and converts between
+ * it and the app buffer around every inference: inputs just before
+ * invoke, outputs right after.
+ *
+ * Element conversions (quantize, dequantize, fp32 <-> fp16) have
+ * AVX2/F16C and NEON kernels selected at runtime, with scalar fallbacks
+ * that produce bit-identical results. Layout changes are a cache-tiled
+ * transpose done on whichever side has the narrower element type.
+ */
+
+#ifndef NEURON_SHIM_CONVERT_H
+#define NEURON_SHIM_CONVERT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RuntimeAPI.h"
+#include "backend.h"
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* One converted tensor of a runtime */
+typedef struct {
+    NeuronTensorInfo app;       /* what getInputInfo/getOutputInfo report */
+    ShimTensorDesc   model;     /* what the backend works on */
+    bool             transpose; /* app NHWC <-> model NCHW */
+    void*            app_buf;   /* bound by setInput/setOutput, NULL = not yet */
+    void*            staging;   /* model-format buffer bound to the backend */
+    void*            scratch;   /* intermediate when both type and layout change */
+} ShimTensorConv;
+
+/* Element size of a NeuronShimTensorType, 0 if unknown */
+size_t neuron_shim_type_size(uint32_t type);
+
+/*
+ * Plan the conversion for one tensor and allocate its buffers.
+ * @return 0 on success, -1 if the combination isn't supported (logged)
+ */
+int  neuron_shim_conv_setup(ShimTensorConv* t, const NeuronShimTensorConv* spec,
+                            const ShimTensorDesc* model, const char* what);
+void neuron_shim_conv_free(ShimTensorConv* t);
+
+/* app_buf -> staging (inputs) and staging -> app_buf (outputs) */
+void neuron_shim_conv_to_model(const ShimTensorConv* t);
+void neuron_shim_conv_to_app(const ShimTensorConv* t);
+
+/* ------------------------------------------------------------------ */
+/* Kernels                                                             */
+/* ------------------------------------------------------------------ */
+/* real = (q - zero_point) * scale */
+void neuron_shim_dequantize_u8(const uint8_t* src, float* dst, size_t n,
+                               float scale, int32_t zero_point);
+void neuron_shim_dequantize_s8(const int8_t* src, float* dst, size_t n,
+                               float scale, int32_t zero_point);
+
+/* q = saturate(round_half_even(real * (1 / scale)) + zero_point) */
+void neuron_shim_quantize_u8(const float* src, uint8_t* dst, size_t n,
+                             float scale, int32_t zero_point);
+void neuron_shim_quantize_s8(const float* src, int8_t* dst, size_t n,
+                             float scale, int32_t zero_point);
+
+/* IEEE binary16, round to nearest even */
+void neuron_shim_f32_to_f16(const float* src, uint16_t* dst, size_t n);
+void neuron_shim_f16_to_f32(const uint16_t* src, float* dst, size_t n);
+
+/* [N,H,W,C] <-> [N,C,H,W] for elements of 'elem' bytes (1, 2, 4 or 8) */
+void neuron_shim_nhwc_to_nchw(const void* src, void* dst, size_t n, size_t h,
+                              size_t w, size_t c, size_t elem);
+void neuron_shim_nchw_to_nhwc(const void* src, void* dst, size_t n, size_t h,
+                              size_t w, size_t c, size_t elem);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NEURON_SHIM_CONVERT_H */
@@ -0,0 +1,57 @@
+/*
+ * neuron-shim: CPU sets for inference threads
+ *
+ * Backend worker threads otherwise float across every core and end up
+ * on little cores (big.LITTLE SoCs) or remote NUMA nodes, which roughly
+ * doubles latency jitter. A cpu_affinity spec names where they may run:
+ *
+ *   0-3,6     explicit logical CPUs
+ *   big       the fastest cores, from /sys/.../cpuN/cpu_capacity
+ *             (every CPU on machines without capacity info, e.g. x86)
+ *   little    the rest
+ *   numa:1    the CPUs of NUMA node 1
+ *
+ * The result is always limited to the CPUs the process may use.
+ */
+
+#ifndef NEURON_SHIM_CPU_AFFINITY_H
+#define NEURON_SHIM_CPU_AFFINITY_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NEURON_SHIM_MAX_CPUS 1024
+
+typedef struct {
+    int count;
+    int cpus[NEURON_SHIM_MAX_CPUS];   /* ascending logical CPU ids */
+} NeuronShimCpuSet;
+
+/* A thread's saved affinity mask (same size as glibc's cpu_set_t) */
+typedef struct {
+    unsigned long bits[NEURON_SHIM_MAX_CPUS / (8 * sizeof(unsigned long))];
+} NeuronShimCpuMask;
+
+/*
+ * Parse a spec. Empty specs leave *out empty and succeed.
+ * @return 0 on success, -1 if the spec is malformed or selects no CPU
+ */
+int  neuron_shim_cpuset_parse(const char* spec, NeuronShimCpuSet* out);
+
+/*
+ * Move the calling thread onto 'set' (saving its mask in *saved), so
+ * threads it spawns meanwhile inherit the set. No-op for empty sets.
+ * @return true if the mask was changed and neuron_shim_cpuset_leave()
+ *         must be called
+ */
+bool neuron_shim_cpuset_enter(const NeuronShimCpuSet* set, NeuronShimCpuMask* saved);
+void neuron_shim_cpuset_leave(const NeuronShimCpuMask* saved);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NEURON_SHIM_CPU_AFFINITY_H */
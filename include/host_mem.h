@@ -0,0 +1,60 @@
+/*
+ * neuron-shim: Host memory allocator for APU buffers
+ *
+ * Apps get their I/O buffers from libapusys (apusys_mem_alloc) and then
+ * hand those same pointers to NeuronRuntime_setInput/setOutput. The
+ * apusys stub allocates them here instead of with plain calloc, which
+ * buys two things:
+ *
+ *   - Buffers are pooled in power-of-two size classes and really freed,
+ *     so apps that cycle APU buffers reuse memory instead of leaking it.
+ *   - Once a GPU backend is active, new blocks come from the GPU
+ *     runtime's pinned host allocator (cudaHostAlloc / hipHostMalloc).
+ *     Backends can ask whether a bound buffer is a pinned shim block and
+ *     describe it to the GPU as such, so host<->device copies are async
+ *     DMA instead of staged pageable copies.
+ *
+ * All functions are thread-safe.
+ */
+
+#ifndef NEURON_SHIM_HOST_MEM_H
+#define NEURON_SHIM_HOST_MEM_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    NEURON_SHIM_MEM_PAGEABLE = 0,   /* ordinary page-aligned heap memory */
+    NEURON_SHIM_MEM_CUDA     = 1,   /* cudaHostAlloc */
+    NEURON_SHIM_MEM_HIP      = 2,   /* hipHostMalloc */
+} NeuronShimMemKind;
+
+/* Zeroed, page-aligned block of at least 'size' bytes; NULL on failure */
+void* neuron_shim_mem_alloc(size_t size);
+
+/* Return a block to the pool. -1 if 'p' isn't a live shim block. */
+int   neuron_shim_mem_free(void* p);
+
+/*
+ * Kind of the shim block that contains all of [p, p + size), or -1 if
+ * the range isn't (entirely) shim-owned memory. Interior pointers are
+ * fine: apps often carve several tensors out of one APU buffer.
+ */
+int   neuron_shim_mem_kind(const void* p, size_t size);
+
+/*
+ * Back future allocations with pinned memory from the given GPU runtime,
+ * whose library the backend has already loaded. Blocks allocated before
+ * keep their kind. Safe to call repeatedly.
+ * @return 0 on success, -1 if the runtime's host allocator isn't found
+ */
+int   neuron_shim_mem_enable_pinned(NeuronShimMemKind kind);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NEURON_SHIM_HOST_MEM_H */
@@ -0,0 +1,81 @@
+/*
+ * neuron-shim: Logging
+ *
+ * All shim and backend logging goes through SHIM_LOG. The level check
+ * happens before any argument is evaluated or formatted, so disabled
+ * levels cost one compare.
+ *
+ * Enabled messages are formatted into a lock-free ring and written to
+ * stderr by a background thread, so inference threads never block on
+ * log I/O (e.g. a stalled journald pipe). If the ring is full the
+ * message is dropped and counted. Each call site is also rate-limited
+ * to log_rate_limit messages per second; suppressed counts are
+ * reported with the site's next message.
+ *
+ * Until neuron_shim_log_init() runs (e.g. while parsing config),
+ * messages are written synchronously.
+ */
+
+#ifndef NEURON_SHIM_LOG_H
+#define NEURON_SHIM_LOG_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    SHIM_LOG_ERROR = 1,
+    SHIM_LOG_WARN  = 2,
+    SHIM_LOG_INFO  = 3,
+    SHIM_LOG_DEBUG = 4,
+};
+
+/* Current level (0=off .. 4=debug); set by neuron_shim_log_init */
+extern int neuron_shim_log_level;
+
+/* Per-call-site rate limiter state; one static instance per SHIM_LOG */
+typedef struct {
+    _Atomic uint64_t window;      /* second the count applies to */
+    _Atomic uint32_t count;
+    _Atomic uint32_t suppressed;
+} ShimLogSite;
+
+/*
+ * Log "[neuron-shim][tag] <message>" (or "[neuron-shim] <message>" if
+ * tag is NULL). A trailing newline is added.
+ */
+#define SHIM_LOG(level, tag, fmt, ...) \
+    do { \
+        if (neuron_shim_log_level >= (level)) { \
+            static ShimLogSite shim_log_site_; \
+            neuron_shim_log_write(&shim_log_site_, (tag), \
+                                  fmt, ##__VA_ARGS__); \
+        } \
+    } while(0)
+
+#define SHIM_ERR(tag, fmt, ...)  SHIM_LOG(SHIM_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define SHIM_WARN(tag, fmt, ...) SHIM_LOG(SHIM_LOG_WARN,  tag, fmt, ##__VA_ARGS__)
+#define SHIM_INFO(tag, fmt, ...) SHIM_LOG(SHIM_LOG_INFO,  tag, fmt, ##__VA_ARGS__)
+#define SHIM_DBG(tag, fmt, ...)  SHIM_LOG(SHIM_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+
+void neuron_shim_log_write(ShimLogSite* site, const char* tag,
+                           const char* fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/*
+ * Set the level and rate limit (messages per second per call site,
+ * 0 = unlimited) and start the writer thread. Call once at init.
+ */
+void neuron_shim_log_init(int level, int rate_limit);
+
+/* Write out everything queued so far (also runs at exit) */
+void neuron_shim_log_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NEURON_SHIM_LOG_H */
@@ -0,0 +1,89 @@
+/*
+ * neuron-shim: Shared model cache
+ *
+ * Many apps load the same .dla once per camera stream. The cache makes
+ * sure each resolved model file is parsed and optimized only once per
+ * backend; every runtime that loads it attaches its own I/O binding
+ * state to the one shared backend model.
+ *
+ * Entries are keyed by (backend, resolved path, file mtime, file size)
+ * and refcounted. The backend model is freed when the last reference
+ * is released.
+ *
+ * With hot swap on, a replaced model file is loaded and warmed up in
+ * the background and published as the newer version of its entry;
+ * runtimes poll for it with neuron_shim_cache_stale() (lock-free) and
+ * move over between inferences.
+ */
+
+#ifndef NEURON_SHIM_MODEL_CACHE_H
+#define NEURON_SHIM_MODEL_CACHE_H
+
+#include <stdbool.h>
+
+#include "backend.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ShimModelEntry ShimModelEntry;
+
+/*
+ * Find or load the model at 'path' for 'backend'.
+ * The backend must implement model_load/model_release.
+ *
+ * If another thread is already loading the same model, waits for it
+ * instead of loading a second copy.
+ *
+ * @return entry with one reference held, or NULL if loading failed
+ */
+ShimModelEntry* neuron_shim_cache_acquire(const NeuronShimBackend* backend,
+                                          const char* path);
+
+/*
+ * Preloading, step 1: publish a LOADING entry for 'path' without
+ * loading it, so later acquire() calls wait for it instead of starting
+ * their own load. Cheap; safe to call from init.
+ *
+ * @return entry with one reference held, or NULL if the file is missing
+ *         or an entry for it already exists
+ */
+ShimModelEntry* neuron_shim_cache_reserve(const NeuronShimBackend* backend,
+                                          const char* path);
+
+/*
+ * Preloading, step 2: load a reserved entry and run 'warmup_runs'
+ * synthetic inferences on it before waking waiters. Slow; call from a
+ * background thread.
+ *
+ * @return 0 on success; on failure the reservation's reference has
+ *         already been dropped and the entry must not be used again
+ */
+int neuron_shim_cache_fill(ShimModelEntry* entry, int warmup_runs);
+
+/* Backend model handle for an acquired entry (pass to backend->attach) */
+void* neuron_shim_cache_model(const ShimModelEntry* entry);
+
+/* Drop one reference; frees the backend model on the last one */
+void neuron_shim_cache_release(ShimModelEntry* entry);
+
+/*
+ * Hot swap: watch the files of every cached model, now and later ones.
+ * Replacements get 'warmup_runs' synthetic inferences before they are
+ * published. @return 0, or -1 if inotify is unavailable
+ */
+int  neuron_shim_cache_watch(int warmup_runs);
+
+/* A newer version of entry's file has been loaded. Lock-free. */
+bool neuron_shim_cache_stale(const ShimModelEntry* entry);
+
+/* The newest published version of entry (entry itself if there is
+ * none), with a reference held */
+ShimModelEntry* neuron_shim_cache_newest(ShimModelEntry* entry);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NEURON_SHIM_MODEL_CACHE_H */
@@ -0,0 +1,32 @@
+/*
+ * neuron-shim: Model content hashing
+ *
+ * Fast 64-bit non-cryptographic hash used to key on-disk caches
+ * (TensorRT engines, ...) by model content rather than by path, so a
+ * replaced model never picks up a stale artifact.
+ */
+
+#ifndef NEURON_SHIM_MODEL_HASH_H
+#define NEURON_SHIM_MODEL_HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Hash an in-memory buffer */
+uint64_t neuron_shim_hash_buffer(const void* data, size_t len);
+
+/*
+ * Hash a file's contents (mmapped, not read into heap).
+ * @return 0 on success, -1 if the file can't be opened or mapped
+ */
+int neuron_shim_hash_file(const char* path, uint64_t* hash);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NEURON_SHIM_MODEL_HASH_H */
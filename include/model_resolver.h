@@ -3,12 +3,18 @@
  *
  *   model_dir empty:  /path/to/model.dla → /path/to/model.dla.onnx
  *   model_dir set:    /path/to/model.dla → <model_dir>/model.dla.onnx
+ *
+ * Models handed over as a buffer (loadNetworkFromBuffer) have no path;
+ * they are named by content hash instead:
+ *
+ *   <buffer>          → <model_dir>/<16 hex digit hash>.dla.onnx
  */
 
 #ifndef NEURON_SHIM_MODEL_RESOLVER_H
 #define NEURON_SHIM_MODEL_RESOLVER_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -31,6 +37,24 @@ int neuron_shim_resolve_model(const char* original_path,
                                char* resolved,
                                size_t resolved_len);
 
+/*
+ * Name of a model blob with content hash 'hash': "<hash>.dla", which is
+ * also what [model] sections match it by.
+ */
+void neuron_shim_blob_name(uint64_t hash, char* name, size_t name_len);
+
+/*
+ * Resolve a model blob to <model_dir>/<hash>.dla<suffix>.
+ *
+ * @return 0 if that file exists, -1 if it doesn't or model_dir is
+ *         unset (quietly: callers fall back to the buffer itself)
+ */
+int neuron_shim_resolve_blob(uint64_t hash,
+                             const char* suffix,
+                             const char* model_dir,
+                             char* resolved,
+                             size_t resolved_len);
+
 #ifdef __cplusplus
 }
 #endif
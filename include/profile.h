@@ -0,0 +1,74 @@
+/*
+ * neuron-shim: Chrome trace profiling
+ *
+ * With profile_file set, models whose profile_runs (global or from
+ * their [model] section) is nonzero are profiled for their first
+ * profile_runs inferences. Everything lands in one Chrome trace JSON
+ * per process (chrome://tracing, ui.perfetto.dev):
+ *
+ *   cat "shim"    resolve, load, setInput/setOutput, tensor conversion,
+ *                 pipeline copies and the whole inference, per runtime
+ *   cat "onnx"    output copies out of ORT-allocated tensors, plus ORT's
+ *                 own profile (EnableProfiling): session setup and one
+ *                 event per node with its EP in args.provider, so nodes
+ *                 that fell back to the CPU EP stand out
+ *   cat "tflite"  tensor copies, and with SHIM_TFLITE_PROFILER one event
+ *                 per op (delegated subgraphs show as the delegate's op)
+ *
+ * Events are written as they happen under one lock; the closing ']' is
+ * added at exit (viewers accept the file without it after a crash).
+ * Timestamps are neuron_shim_now_ns(), i.e. CLOCK_MONOTONIC.
+ */
+
+#ifndef NEURON_SHIM_PROFILE_H
+#define NEURON_SHIM_PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Open cfg->profile_file ("%p" is replaced with the process id). Does
+ * nothing if it is empty.
+ * @return 0 if profiling, -1 otherwise
+ */
+int neuron_shim_profile_open(const NeuronShimConfig* cfg);
+
+/* The trace being written, NULL if profiling is off */
+const char* neuron_shim_profile_path(void);
+
+/* Inferences to profile for a model with settings 'mc' (may be NULL):
+ * its profile_runs, else the global one; 0 if profiling is off */
+int neuron_shim_profile_runs(const NeuronShimConfig* cfg,
+                             const NeuronShimModelConfig* mc);
+
+/*
+ * Add a complete event on the calling thread. 'name' is escaped;
+ * 'args_fmt', if not NULL, formats the body of the args object
+ * (e.g. "\"bytes\":%zu") and must produce valid JSON itself.
+ */
+void neuron_shim_profile_span(const char* cat, const char* name,
+                              uint64_t start_ns, uint64_t end_ns,
+                              const char* args_fmt, ...)
+    __attribute__((format(printf, 5, 6)));
+
+/*
+ * Append the events of a Chrome trace JSON written by a runtime's own
+ * profiler, one event object per line (ORT's format), shifting their
+ * "ts" from microseconds since 'base_ns' onto the shim's clock.
+ * 'base_ns' may be CLOCK_REALTIME or CLOCK_MONOTONIC (told apart by
+ * magnitude). The file is removed afterwards.
+ * @return events merged, or -1 if the file can't be read
+ */
+int neuron_shim_profile_merge(const char* file, uint64_t base_ns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NEURON_SHIM_PROFILE_H */
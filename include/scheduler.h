@@ -0,0 +1,56 @@
+/*
+ * neuron-shim: QoS-aware inference scheduling
+ *
+ * Two independent pieces, both driven by the app's QoSOptions:
+ *
+ *   Priority gate — an inference may only start while no inference of
+ *   a higher priority is queued or running, so background models yield
+ *   the GPU/CPU to latency-critical ones. Inferences can't be preempted
+ *   once started; the gate only controls when they begin.
+ *
+ *   Watchdog — a single thread that calls backend->abort() on any
+ *   inference still running past its abort time.
+ */
+
+#ifndef NEURON_SHIM_SCHEDULER_H
+#define NEURON_SHIM_SCHEDULER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "backend.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Block until no higher-priority inference is pending, then register
+ * this one as running. 'priority' is a NeuronRuntimePriority. */
+void neuron_shim_sched_enter(int priority);
+
+/* Mark an inference started with neuron_shim_sched_enter() as done */
+void neuron_shim_sched_leave(int priority);
+
+/* One armed watchdog timer; lives on the caller's stack */
+typedef struct ShimWatch {
+    struct ShimWatch*        next;
+    const NeuronShimBackend* backend;
+    void*                    ctx;
+    struct timespec          abort_at;   /* CLOCK_MONOTONIC */
+    bool                     fired;
+} ShimWatch;
+
+/* Abort ctx's inference if it is still running 'timeout_ns' from now.
+ * The backend must implement abort. */
+void neuron_shim_watch_arm(ShimWatch* w, const NeuronShimBackend* backend,
+                           void* ctx, uint64_t timeout_ns);
+
+/* Cancel the timer. @return true if it already fired */
+bool neuron_shim_watch_disarm(ShimWatch* w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NEURON_SHIM_SCHEDULER_H */
@@ -0,0 +1,88 @@
+/*
+ * neuron-shim: Per-runtime latency statistics
+ *
+ * Every timed call records into a log-linear histogram (4 buckets per
+ * power of two, so percentiles are within ~12%). Recording is a few
+ * relaxed atomic adds — no locks on the inference path.
+ *
+ * Snapshots are exposed to apps through getProfiledQoSData (see the
+ * extension section of RuntimeAPI.h) and, if stats_dump is set, written
+ * for all live runtimes on SIGUSR1.
+ */
+
+#ifndef NEURON_SHIM_STATS_H
+#define NEURON_SHIM_STATS_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "RuntimeAPI.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SHIM_HIST_BUCKETS 160   /* covers 0 .. ~2^41 ns (~36 min) */
+
+typedef struct {
+    _Atomic uint64_t buckets[SHIM_HIST_BUCKETS];
+    _Atomic uint64_t sum_ns;
+    _Atomic uint64_t max_ns;
+} ShimHistogram;
+
+/* Everything timed for one NeuronRuntime */
+typedef struct ShimRuntimeStats {
+    struct ShimRuntimeStats* next;    /* registry link, owned by stats.c */
+    const void*   runtime;            /* for dump output only */
+    const char*   backend;
+    char          model[1024];        /* resolved path, empty until loaded */
+
+    ShimHistogram inference;
+    ShimHistogram set_input;
+    ShimHistogram set_output;
+    ShimHistogram load;
+
+    /* Backend allocator usage and providers in use, read whenever a
+     * snapshot is taken. Optional; may be called from the stats dump
+     * thread. Both get 'hook_arg'. */
+    int         (*memory)(void* arg, NeuronShimMemoryStats* out);
+    int         (*providers)(void* arg, char* out, size_t len);
+    void*         hook_arg;
+
+    NeuronShimProfiledQoSData snapshot;   /* handed out by getProfiledQoSData */
+} ShimRuntimeStats;
+
+static inline uint64_t neuron_shim_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Record one sample. Lock-free, safe from any thread. */
+void neuron_shim_hist_record(ShimHistogram* h, uint64_t ns);
+
+/* Summarize a histogram (percentiles are bucket midpoints) */
+void neuron_shim_hist_summary(const ShimHistogram* h, NeuronShimLatencyStats* out);
+
+/* Fill s->snapshot from the live histograms */
+void neuron_shim_stats_snapshot(ShimRuntimeStats* s);
+
+/* Track a runtime for SIGUSR1 dumps. Call register after create and
+ * unregister before freeing. */
+void neuron_shim_stats_register(ShimRuntimeStats* s);
+void neuron_shim_stats_unregister(ShimRuntimeStats* s);
+
+/*
+ * Dump all registered runtimes to 'path' (truncated each time; "-" for
+ * stderr) whenever the process gets SIGUSR1. Does nothing if the app
+ * already handles SIGUSR1.
+ * @return 0 if installed, -1 otherwise
+ */
+int neuron_shim_stats_install_dump(const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NEURON_SHIM_STATS_H */
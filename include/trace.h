@@ -0,0 +1,81 @@
+/*
+ * neuron-shim: Call trace recording
+ *
+ * With trace_file set, the active backend is wrapped so every vtable
+ * call is appended to a compact binary trace; tools/shim_replay.c
+ * drives the same sequence (runtimes, cadence, tensor sizes) against
+ * any backend on another machine.
+ *
+ * File layout (host byte order — traces are replayed on the same
+ * architecture family):
+ *
+ *   NeuronShimTraceHeader
+ *   { NeuronShimTraceRecord, <record.payload bytes> }*
+ *
+ * Payloads: the model path for LOAD_FILE/ATTACH, sampled tensor bytes
+ * for SET_INPUT (every trace_sample_inputs-th call), otherwise none.
+ */
+
+#ifndef NEURON_SHIM_TRACE_H
+#define NEURON_SHIM_TRACE_H
+
+#include <stdint.h>
+
+#include "backend.h"
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NEURON_SHIM_TRACE_MAGIC   "NSTRACE\0"
+#define NEURON_SHIM_TRACE_VERSION 1
+
+typedef enum {
+    TRACE_CREATE      = 1,
+    TRACE_DESTROY     = 2,
+    TRACE_LOAD_FILE   = 3,   /* payload: resolved model path */
+    TRACE_LOAD_BUFFER = 4,   /* value: buffer size (bytes not recorded) */
+    TRACE_ATTACH      = 5,   /* shared model; payload: resolved model path */
+    TRACE_SET_INPUT   = 6,   /* value: size; payload: sampled bytes or none */
+    TRACE_SET_OUTPUT  = 7,   /* value: size */
+    TRACE_INVOKE      = 8,   /* t_ns: start; value: duration in ns */
+    TRACE_ABORT       = 9,
+} NeuronShimTraceEvent;
+
+typedef struct {
+    char     magic[8];        /* NEURON_SHIM_TRACE_MAGIC */
+    uint32_t version;         /* NEURON_SHIM_TRACE_VERSION */
+    uint32_t record_size;     /* sizeof(NeuronShimTraceRecord) */
+    char     backend[16];     /* backend that was recorded */
+    char     suffix[32];      /* model suffix stripped from paths on replay */
+    uint64_t start_unix_ns;   /* wall clock at t_ns == 0 */
+} NeuronShimTraceHeader;
+
+typedef struct {
+    uint8_t  type;            /* NeuronShimTraceEvent */
+    uint8_t  reserved;
+    uint16_t index;           /* tensor index for SET_INPUT/SET_OUTPUT */
+    uint32_t runtime;         /* context id, unique within the trace */
+    uint64_t t_ns;            /* monotonic time since trace start */
+    uint64_t value;           /* see NeuronShimTraceEvent */
+    uint32_t payload;         /* bytes following this record */
+    int32_t  status;          /* backend return code */
+} NeuronShimTraceRecord;
+
+/*
+ * Return a backend that records every call before forwarding it to
+ * 'inner'. The first call opens cfg->trace_file and writes the header
+ * (with this backend and suffix); backends wrapped later, for models
+ * routed elsewhere, record into the same file. Returns 'inner'
+ * unchanged if the file can't be opened.
+ */
+const NeuronShimBackend* neuron_shim_trace_wrap(const NeuronShimBackend* inner,
+                                                const NeuronShimConfig* cfg,
+                                                const char* suffix);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NEURON_SHIM_TRACE_H */
@@ -0,0 +1,42 @@
+/*
+ * neuron-shim: Per-runtime inference worker
+ *
+ * A thread that runs one job at a time on behalf of a runtime: submit
+ * hands it the job and returns at once, wait blocks until the job is
+ * done and collects its result. Backs NeuronRuntime_inferenceAsync and
+ * pipeline mode, so the app's thread can capture and preprocess the
+ * next frame while the backend runs this one.
+ */
+
+#ifndef NEURON_SHIM_WORKER_H
+#define NEURON_SHIM_WORKER_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ShimWorker ShimWorker;
+
+/* @return NULL if the thread can't be started */
+ShimWorker* neuron_shim_worker_create(int (*job)(void* arg), void* arg);
+
+/* Waits for a submitted job to finish first */
+void neuron_shim_worker_destroy(ShimWorker* w);
+
+/* Start the job. @return 0, or -1 if the last one hasn't been collected */
+int  neuron_shim_worker_submit(ShimWorker* w);
+
+/* Submitted and not yet collected with neuron_shim_worker_wait() */
+bool neuron_shim_worker_pending(ShimWorker* w);
+
+/* Block until the job is done. @return its result in *result and 0,
+ * or -1 if nothing was submitted */
+int  neuron_shim_worker_wait(ShimWorker* w, int* result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NEURON_SHIM_WORKER_H */
@@ -0,0 +1,194 @@
+/*
+ * neuron-shim: Load-time autotuning
+ */
+
+#define _GNU_SOURCE
+#include "autotune.h"
+#include "config.h"
+#include "cpu_affinity.h"
+#include "log.h"
+#include "model_hash.h"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TAG "tune"
+
+#define TIMED_RUNS 5
+
+int neuron_shim_tune_threads(const char* cpu_affinity, int* out, int max) {
+    NeuronShimCpuSet set;
+    int cpus = 0;
+    if (cpu_affinity && cpu_affinity[0] &&
+        neuron_shim_cpuset_parse(cpu_affinity, &set) == 0)
+        cpus = set.count;
+    if (cpus <= 0) {
+        cpu_set_t mask;
+        cpus = sched_getaffinity(0, sizeof(mask), &mask) == 0 ? CPU_COUNT(&mask) : 1;
+    }
+
+    int n = 0;
+    for (int t = 1; t < cpus && n < max - 1; t *= 2)
+        out[n++] = t;
+    if (n < max) out[n++] = cpus;
+    return n;
+}
+
+/* ------------------------------------------------------------------ */
+/* Hardware fingerprint                                                */
+/* ------------------------------------------------------------------ */
+static uint64_t mix(uint64_t h, const char* s) {
+    return neuron_shim_hash_buffer(s, strlen(s)) ^ (h * 0x9E3779B185EBCA87ull);
+}
+
+/* CPU model lines (x86 "model name", ARM "CPU implementer/part"), one
+ * per core, so the core count and big.LITTLE layout count too */
+static uint64_t cpu_identity(uint64_t h) {
+    FILE* f = fopen("/proc/cpuinfo", "r");
+    if (!f) return h;
+
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "model name", 10) == 0 ||
+            strncmp(line, "Hardware", 8) == 0 ||
+            strncmp(line, "CPU implementer", 15) == 0 ||
+            strncmp(line, "CPU part", 8) == 0)
+            h = mix(h, line);
+    }
+    fclose(f);
+    return h;
+}
+
+/* NVIDIA GPUs, when the driver is loaded */
+static uint64_t gpu_identity(uint64_t h) {
+    const char* root = "/proc/driver/nvidia/gpus";
+    DIR* d = opendir(root);
+    if (!d) return h;
+
+    struct dirent* e;
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.') continue;
+        char path[512], line[256];
+        snprintf(path, sizeof(path), "%s/%s/information", root, e->d_name);
+        FILE* f = fopen(path, "r");
+        if (!f) continue;
+        while (fgets(line, sizeof(line), f))
+            if (strncmp(line, "Model:", 6) == 0) h = mix(h, line);
+        fclose(f);
+    }
+    closedir(d);
+    return h;
+}
+
+/* Computed once: the hardware doesn't change under us, and models may
+ * load on several threads at once */
+static uint64_t       g_fingerprint;
+static pthread_once_t g_fingerprint_once = PTHREAD_ONCE_INIT;
+
+static void fingerprint_init(void) {
+    cpu_set_t mask;
+    char cpus[32];
+    snprintf(cpus, sizeof(cpus), "cpus=%d",
+             sched_getaffinity(0, sizeof(mask), &mask) == 0 ? CPU_COUNT(&mask) : 0);
+
+    g_fingerprint = gpu_identity(cpu_identity(mix(0, cpus)));
+}
+
+static uint64_t fingerprint(void) {
+    pthread_once(&g_fingerprint_once, fingerprint_init);
+    return g_fingerprint;
+}
+
+int neuron_shim_tune_file(uint64_t model_hash, const char* variant,
+                          char* out, size_t len) {
+    char dir[1024];
+    if (neuron_shim_config_cache_subdir(neuron_shim_config_get(), "tune",
+                                        dir, sizeof(dir)) != 0)
+        return -1;
+
+    int n = snprintf(out, len, "%s/%016llx-%016llx", dir,
+                     (unsigned long long)model_hash,
+                     (unsigned long long)mix(fingerprint(), variant));
+    return n < 0 || (size_t)n >= len ? -1 : 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* Result files: "threads=N" and "ep=list" lines                       */
+/* ------------------------------------------------------------------ */
+int neuron_shim_tune_load(const char* file, NeuronShimTuning* t) {
+    FILE* f = fopen(file, "r");
+    if (!f) return -1;
+
+    memset(t, 0, sizeof(*t));
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (strncmp(line, "threads=", 8) == 0)
+            t->threads = atoi(line + 8);
+        else if (strncmp(line, "ep=", 3) == 0 && strlen(line + 3) < sizeof(t->ep))
+            memcpy(t->ep, line + 3, strlen(line + 3) + 1);   /* longer = malformed */
+    }
+    fclose(f);
+
+    if (t->threads <= 0 && !t->ep[0]) {
+        SHIM_WARN(TAG, "WARNING: ignoring malformed tuning result %s", file);
+        return -1;
+    }
+    return 0;
+}
+
+int neuron_shim_tune_save(const char* file, const NeuronShimTuning* t) {
+    /* Models tuned on several threads may save the same result at once */
+    static _Atomic unsigned seq;
+    char tmp[1100];
+    snprintf(tmp, sizeof(tmp), "%s.%d.%u.tmp", file, (int)getpid(),
+             atomic_fetch_add(&seq, 1));
+
+    FILE* f = fopen(tmp, "w");
+    if (!f) return -1;
+    if (t->threads > 0) fprintf(f, "threads=%d\n", t->threads);
+    if (t->ep[0])       fprintf(f, "ep=%s\n", t->ep);
+
+    /* Readers see the old result or the new one, never half of it */
+    if (fclose(f) != 0 || rename(tmp, file) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* Timing                                                              */
+/* ------------------------------------------------------------------ */
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+int neuron_shim_tune_measure(int (*run)(void* arg), void* arg, double* us) {
+    /* The first run pays for lazy allocation and kernel selection */
+    if (run(arg) != 0) return -1;
+
+    double t[TIMED_RUNS];
+    for (int i = 0; i < TIMED_RUNS; i++) {
+        double start = now_us();
+        if (run(arg) != 0) return -1;
+        t[i] = now_us() - start;
+    }
+    qsort(t, TIMED_RUNS, sizeof(t[0]), cmp_double);
+    *us = t[TIMED_RUNS / 2];
+    return 0;
+}
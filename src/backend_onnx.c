@@ -27,12 +27,29 @@
  * Compile with: -lonnxruntime
  */
 
+#include "RuntimeAPI.h"
+#include "autotune.h"
 #include "backend.h"
-
+#include "cpu_affinity.h"
+#include "host_mem.h"
+#include "log.h"
+#include "model_hash.h"
+#include "profile.h"
+#include "stats.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 
 /* ------------------------------------------------------------------ */
 /* ONNX Runtime C API                                                  */
@@ -42,33 +59,95 @@
 #include <onnxruntime_c_api.h>
 
 #define MAX_TENSORS 32
+#define VALUE_CACHE 4    /* wrapped buffers kept per input */
+#define SHAPE_CACHE 4    /* input-shape combinations remembered per context */
+#define MAX_DEVICES 8    /* GPUs runtimes can be spread over */
+#define EPS_LEN     64   /* registered EPs, "cuda+cpu" */
 
 /* Helper macro for ORT error checking */
 #define ORT_CHECK(api, expr) \
     do { \
         OrtStatus* _s = (expr); \
         if (_s) { \
-            fprintf(stderr, "[neuron-shim][onnx] ERROR: %s\n", \
-                    (api)->GetErrorMessage(_s)); \
+            SHIM_ERR("onnx", "ERROR: %s", \
+                     (api)->GetErrorMessage(_s)); \
             (api)->ReleaseStatus(_s); \
             return -1; \
         } \
     } while(0)
 
+/* An mmapped file whose bytes a session uses in place */
 typedef struct {
-    const OrtApi*       api;
-    OrtEnv*             env;
-    OrtSessionOptions*  session_opts;
-    OrtSession*         session;
-    OrtMemoryInfo*      memory_info;
+    void*  addr;
+    size_t size;
+} OnnxMapping;
+
+/*
+ * CUDA graph replay state for one of a model's sessions. The graph ORT
+ * captures bakes in the device address of every input and output, so
+ * those live here in fixed device tensors bound once, and every runtime
+ * on the session copies its buffers through them, one run at a time.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    OrtAllocator*   allocator;   /* the session's CUDA allocator */
+    OrtIoBinding*   binding;
+    OrtValue*       inputs[MAX_TENSORS];
+    OrtValue*       outputs[MAX_TENSORS];
+    void*           input_ptr[MAX_TENSORS];
+    void*           output_ptr[MAX_TENSORS];
+} OnnxGraph;
+
+/*
+ * Micro-batching queue for one of a model's sessions: the batch that is
+ * collecting members, if any, and how many runtimes use the session.
+ */
+typedef struct OnnxBatch OnnxBatch;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;       /* a batch filled up or finished */
+    OnnxBatch*      open;       /* collecting, NULL = none */
+    _Atomic int     users;      /* contexts attached to the session */
+} OnnxBatcher;
+
+/*
+ * Shared, read-only part of a loaded model. One of these backs every
+ * runtime that loaded the same file (see model_cache.h); ORT sessions
+ * are safe to Run() from several threads at once.
+ *
+ * A GPU session is bound to one device, so with runtimes spread over
+ * several GPUs the model gets one session per device, built the first
+ * time a runtime placed there attaches.
+ */
+typedef struct {
+    OrtSession*         session;        /* first session: metadata; all runs if CPU only */
+    OrtSession*         device_sessions[MAX_DEVICES];
+    int                 home_device;    /* device 'session' was built for */
+    bool                gpu;            /* a GPU EP was registered */
+    char                path[1024];     /* source for more sessions, empty = buffer */
+    pthread_mutex_t     lock;           /* device_sessions, graphs */
+    const NeuronShimModelConfig* cfg;   /* [model] section, or NULL */
+    NeuronShimModelConfig tuned;        /* cfg with 'auto' resolved, when tuning */
+    const char*         pinned_name;    /* GPU EP's pinned OrtMemoryInfo name, NULL = CPU only */
+    char                eps[EPS_LEN];   /* EPs registered on 'session', "cuda+cpu" */
+    OnnxMapping         mapping;        /* cached ORT-format model backing 'session' */
+    bool                cuda_graph;     /* sessions replay a captured CUDA graph */
+    OnnxGraph*          graphs[MAX_DEVICES];    /* per device session, under 'lock' */
+    OnnxBatcher*        batchers[MAX_DEVICES];  /* likewise, micro-batching only */
+    int                 batch_window_us;        /* 0 = no micro-batching */
+    int                 max_batch;
+    _Atomic int         profile_left;   /* runs until 'session's ORT profile is merged */
 
     /* Input tensor metadata (populated after model load) */
     struct {
         char     name[256];
-        size_t   size;        /* total byte size */
-        int64_t  shape[8];
+        size_t   size;        /* byte size of default_shape */
+        int64_t  shape[8];    /* as declared; <= 0 = symbolic */
+        int64_t  default_shape[8];  /* first matching shape hint, else 1s */
         size_t   num_dims;
         ONNXTensorElementDataType type;
+        bool     dynamic;     /* has symbolic dims: shape comes from setInput */
     } inputs[MAX_TENSORS];
     size_t input_count;
 
@@ -79,22 +158,91 @@ typedef struct {
         int64_t  shape[8];
         size_t   num_dims;
         ONNXTensorElementDataType type;
+        bool     dynamic;     /* has symbolic dims: size is a guess */
     } outputs[MAX_TENSORS];
     size_t output_count;
+    bool   dynamic_outputs;   /* any output has symbolic dims */
+} OnnxModel;
+
+/* One app input buffer wrapped in an OrtValue of a concrete shape */
+typedef struct {
+    const void* buf;
+    size_t      size;
+    int64_t     shape[8];
+    OrtValue*   value;
+    uint64_t    used;         /* LRU stamp */
+} InputValue;
 
-    /* User-bound I/O buffers */
+/*
+ * What a context has learned about one combination of input shapes:
+ * the output shapes the first run produced, and OrtValues wrapping the
+ * app's output buffers at those shapes. Later runs with the same input
+ * shapes bind outputs zero-copy instead of letting ORT allocate them.
+ */
+typedef struct {
+    bool      valid;
+    bool      known;                   /* shapes/sizes filled in by a run */
+    uint64_t  key;                     /* hash of every input's shape */
+    uint64_t  used;
+    int64_t   shape[MAX_TENSORS][8];   /* per output */
+    size_t    size[MAX_TENSORS];
+    OrtValue* value[MAX_TENSORS];      /* wraps value_buf[i] at shape[i] */
+    void*     value_buf[MAX_TENSORS];
+} ShapeState;
+
+/* Per-runtime state */
+typedef struct {
+    const OrtApi*       api;
+    OnnxModel*          model;   /* attached model (shared or owned) */
+    OnnxModel*          owned;   /* set when this context loaded it privately */
+    OrtMemoryInfo*      memory_info;
+    OrtMemoryInfo*      pinned_info;    /* for pinned shim buffers (host_mem.h) */
+    OrtRunOptions*      run_options;   /* per context so abort() hits only us */
+    OrtIoBinding*       io_binding;  /* created on attach */
+    OrtSession*         session;     /* the model's session for 'device' */
+    int                 device;      /* GPU placed on at first load (onnx_place) */
+    bool                placed;      /* 'device' is chosen and counted */
+    OnnxGraph*          graph;       /* CUDA graph mode: the session's I/O, else NULL */
+    OnnxBatcher*        batcher;     /* micro-batching: the session's queue, else NULL */
+    bool                batch_done;  /* set by the batch leader, under batcher->lock */
+    int                 batch_rc;
+    int                 profile_left;   /* runs whose copies are profiled */
+
+    /*
+     * User-bound input buffers. Apps bind the same pointers every frame,
+     * so each (buffer, size) is wrapped in an OrtValue once and kept in a
+     * small per-input cache: alternating between a few resolutions or
+     * double buffers just rebinds an existing value.
+     */
     struct {
-        const void* buf;
+        const void* buf;      /* last set_input; bound on attach if early */
         size_t      size;
+        InputValue  cache[VALUE_CACHE];
+        InputValue* bound;    /* entry currently bound to io_binding */
     } input_bindings[MAX_TENSORS];
 
+    /*
+     * Outputs normally run zero-copy: 'value' wraps the user buffer and
+     * is bound once, so ORT writes results straight into it. When the
+     * buffer is too small or the shape is dynamic, value stays NULL and
+     * the output is bound to the CPU device instead — ORT allocates it
+     * and invoke copies the result out.
+     */
     struct {
-        void*  buf;
-        size_t size;
+        void*     buf;
+        size_t    size;
+        OrtValue* value;
     } output_bindings[MAX_TENSORS];
 
+    /* Models with symbolic output dims only */
+    ShapeState  shapes[SHAPE_CACHE];
+    ShapeState* shape;        /* state for the current input shapes */
+    uint64_t    tick;         /* LRU clock for both caches */
+
 } OnnxContext;
 
+static void onnx_model_release(void* model);
+
 /* ------------------------------------------------------------------ */
 /* Helper: get byte size of an ORT tensor element type                 */
 /* ------------------------------------------------------------------ */
@@ -114,6 +262,20 @@ static size_t ort_element_size(ONNXTensorElementDataType type) {
     }
 }
 
+static uint32_t ort_shim_type(ONNXTensorElementDataType type) {
+    switch (type) {
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:   return NEURON_SHIM_TYPE_FLOAT32;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:   return NEURON_SHIM_TYPE_UINT8;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:    return NEURON_SHIM_TYPE_INT8;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16: return NEURON_SHIM_TYPE_FLOAT16;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16:   return NEURON_SHIM_TYPE_INT16;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32:   return NEURON_SHIM_TYPE_INT32;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64:   return NEURON_SHIM_TYPE_INT64;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_BOOL:    return NEURON_SHIM_TYPE_BOOL;
+        default: return NEURON_SHIM_TYPE_UNKNOWN;
+    }
+}
+
 /* ------------------------------------------------------------------ */
 /* Helper: compute total byte size from shape + element type           */
 /* ------------------------------------------------------------------ */
@@ -129,39 +291,403 @@ static size_t compute_tensor_size(const int64_t* shape, size_t num_dims,
 }
 
 /* ------------------------------------------------------------------ */
-/* Lifecycle                                                           */
+/* Process-wide state                                                  */
+/*                                                                     */
+/* ORT only wants one OrtEnv per process. Every session shares it, and */
+/* in global_thread_pool mode the env also owns the intra-op pool so   */
+/* N runtimes don't spin up N competing pools.                         */
 /* ------------------------------------------------------------------ */
-static int onnx_create(void** ctx) {
-    OnnxContext* c = (OnnxContext*)calloc(1, sizeof(OnnxContext));
-    if (!c) return -1;
+static const OrtApi*           g_ort = NULL;
+static OrtEnv*                 g_env = NULL;
+static const NeuronShimConfig* g_cfg = NULL;
+static OrtArenaCfg*            g_arena_cfg = NULL;  /* arena_* settings, NULL = ORT's */
 
-    c->api = OrtGetApiBase()->GetApi(ORT_API_VERSION);
-    if (!c->api) {
-        fprintf(stderr, "[neuron-shim][onnx] failed to get ORT API v%d\n",
-                ORT_API_VERSION);
-        free(c);
-        return -1;
+/* ------------------------------------------------------------------ */
+/* Device placement                                                    */
+/*                                                                     */
+/* Each context is placed on a GPU when it gets its model: always      */
+/* gpu_device for 'fixed', in turn for 'round_robin', or on the device */
+/* with the fewest inferences in flight (then fewest runtimes) for     */
+/* 'least_loaded'. Without gpu_count the GPUs are counted once an EP   */
+/* has loaded the CUDA/HIP runtime; until then there is one.           */
+/* ------------------------------------------------------------------ */
+enum { PLACE_FIXED, PLACE_ROUND_ROBIN, PLACE_LEAST_LOADED };
+
+static struct {
+    _Atomic int contexts;     /* runtimes placed on the device */
+    _Atomic int inflight;     /* inferences running on it right now */
+} g_devices[MAX_DEVICES];
+
+static int               g_placement    = PLACE_FIXED;
+static _Atomic int       g_device_count = 1;
+static _Atomic bool      g_device_probe;       /* count not known yet */
+static int               g_home_device  = 0;   /* fixed device / shared-model default */
+static _Atomic unsigned  g_next_device;
+
+/*
+ * Ask the GPU runtime an EP loaded how many devices there are. Only
+ * looks (RTLD_NOLOAD): loading it, or creating a CUDA/HIP context, from
+ * here would cost a CPU-only ORT build the whole GPU stack.
+ * @return 0 if a loaded runtime answered
+ */
+static int onnx_detect_devices(int* count) {
+    static const struct { const char* lib; const char* sym; } rt[] = {
+        { "libcudart.so",      "cudaGetDeviceCount" },
+        { "libcudart.so.12",   "cudaGetDeviceCount" },
+        { "libcudart.so.11.0", "cudaGetDeviceCount" },
+        { "libamdhip64.so",    "hipGetDeviceCount"  },
+        { "libamdhip64.so.6",  "hipGetDeviceCount"  },
+    };
+    typedef int (*DeviceCountFn)(int*);
+
+    for (size_t i = 0; i < sizeof(rt) / sizeof(rt[0]); i++) {
+        void* h = dlopen(rt[i].lib, RTLD_LAZY | RTLD_NOLOAD);
+        if (!h) continue;
+        DeviceCountFn fn = (DeviceCountFn)dlsym(h, rt[i].sym);
+        int n = 0;
+        int rc = fn ? fn(&n) : -1;
+        dlclose(h);
+        if (rc == 0) {
+            *count = n > 0 ? n : 1;
+            return 0;
+        }
     }
+    return -1;
+}
 
-    /* Create environment */
-    ORT_CHECK(c->api,
-        c->api->CreateEnv(ORT_LOGGING_LEVEL_WARNING, "neuron-shim", &c->env));
+static int onnx_device_count(void) {
+    int n;
+    if (atomic_load(&g_device_probe) && onnx_detect_devices(&n) == 0) {
+        if (n > MAX_DEVICES) n = MAX_DEVICES;
+        atomic_store(&g_device_count, n);
+        if (atomic_exchange(&g_device_probe, false))
+            SHIM_INFO("onnx", "placing runtimes over %d GPU(s): %s", n,
+                      g_cfg->gpu_placement);
+    }
+    return atomic_load(&g_device_count);
+}
 
-    /* Session options — add execution providers in priority order */
-    ORT_CHECK(c->api,
-        c->api->CreateSessionOptions(&c->session_opts));
+static void onnx_init_placement(const NeuronShimConfig* cfg) {
+    g_home_device = cfg->gpu_device;
+    if (g_home_device < 0 || g_home_device >= MAX_DEVICES) {
+        SHIM_WARN("onnx", "WARNING: gpu_device %d out of range, using 0",
+                  g_home_device);
+        g_home_device = 0;
+    }
+
+    if (strcmp(cfg->gpu_placement, "round_robin") == 0)
+        g_placement = PLACE_ROUND_ROBIN;
+    else if (strcmp(cfg->gpu_placement, "least_loaded") == 0)
+        g_placement = PLACE_LEAST_LOADED;
+    else if (strcmp(cfg->gpu_placement, "fixed") != 0)
+        SHIM_WARN("onnx", "WARNING: unknown gpu_placement '%s', using fixed",
+                  cfg->gpu_placement);
+    if (g_placement == PLACE_FIXED || cfg->force_cpu) {
+        g_placement = PLACE_FIXED;
+        return;
+    }
+
+    g_home_device = 0;
+    if (cfg->gpu_count <= 0) {
+        atomic_store(&g_device_probe, true);   /* no EP has loaded yet */
+        return;
+    }
+    g_device_count = cfg->gpu_count < MAX_DEVICES ? cfg->gpu_count : MAX_DEVICES;
+    SHIM_INFO("onnx", "placing runtimes over %d GPU(s): %s",
+              g_device_count, cfg->gpu_placement);
+}
+
+static int onnx_place(void) {
+    if (g_placement == PLACE_FIXED) return g_home_device;
+    int count = onnx_device_count();
+    if (count <= 1) return g_home_device;
+    if (g_placement == PLACE_ROUND_ROBIN)
+        return (int)(atomic_fetch_add(&g_next_device, 1) % (unsigned)count);
+
+    int best = 0;
+    for (int d = 1; d < count; d++) {
+        int in_d = atomic_load(&g_devices[d].inflight);
+        int in_b = atomic_load(&g_devices[best].inflight);
+        if (in_d < in_b ||
+            (in_d == in_b && atomic_load(&g_devices[d].contexts) <
+                             atomic_load(&g_devices[best].contexts)))
+            best = d;
+    }
+    return best;
+}
 
-    /* Set thread count */
+static int onnx_thread_count(void) {
     int num_threads = 4;
-    const char* env_threads = getenv("NEURON_SHIM_NUM_THREADS");
-    if (env_threads) num_threads = atoi(env_threads);
-    ORT_CHECK(c->api,
-        c->api->SetIntraOpNumThreads(c->session_opts, num_threads));
+    if (g_cfg && g_cfg->threads > 0) num_threads = g_cfg->threads;
+    return num_threads;
+}
+
+/*
+ * ORT's thread affinity string: one entry per pool thread except the
+ * caller's (which runs a share of the work itself), ';'-separated, with
+ * 1-based processor ids. Each worker gets its own core from the set,
+ * wrapping when there are more workers than cores.
+ */
+static bool onnx_affinity_string(const char* spec, int threads,
+                                 char* out, size_t len) {
+    NeuronShimCpuSet set;
+    if (neuron_shim_cpuset_parse(spec, &set) != 0 || set.count == 0 ||
+        threads < 2)
+        return false;
+
+    size_t n = 0;
+    out[0] = '\0';
+    for (int i = 1; i < threads; i++) {
+        int w = snprintf(out + n, len - n, "%s%d", i > 1 ? ";" : "",
+                         set.cpus[i % set.count] + 1);
+        if (w < 0 || (size_t)w >= len - n) return false;
+        n += (size_t)w;
+    }
+    return true;
+}
+
+/*
+ * arena_* settings. The C API can't configure a session's own CPU
+ * arena, so the CPU arena is registered with the env and shared by all
+ * sessions (session.use_env_allocators); the CUDA EP gets the same
+ * config for its per-session device arenas.
+ */
+static void onnx_init_arenas(void) {
+    const char* strategy = g_cfg->arena_extend_strategy;
+    const char* keys[3];
+    size_t      values[3];
+    size_t      n = 0;
+
+    if (strcmp(strategy, "next_power_of_two") == 0 ||
+        strcmp(strategy, "same_as_requested") == 0) {
+        keys[n]     = "arena_extend_strategy";
+        values[n++] = strcmp(strategy, "same_as_requested") == 0;
+    } else if (strategy[0]) {
+        SHIM_WARN("onnx", "WARNING: unknown arena_extend_strategy '%s'", strategy);
+    }
+    if (g_cfg->arena_max_memory) {
+        keys[n]     = "max_mem";
+        values[n++] = g_cfg->arena_max_memory;
+    }
+    if (g_cfg->arena_initial_chunk) {
+        keys[n]     = "initial_chunk_size_bytes";
+        values[n++] = g_cfg->arena_initial_chunk;
+    }
+    if (n == 0) return;
+
+    OrtMemoryInfo* info = NULL;
+    OrtStatus* s = g_ort->CreateArenaCfgV2(keys, values, n, &g_arena_cfg);
+    if (!s) s = g_ort->CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &info);
+    if (!s) s = g_ort->CreateAndRegisterAllocator(g_env, info, g_arena_cfg);
+    if (info) g_ort->ReleaseMemoryInfo(info);
+    if (s) {
+        SHIM_WARN("onnx", "WARNING: arena settings ignored: %s",
+                  g_ort->GetErrorMessage(s));
+        g_ort->ReleaseStatus(s);
+        if (g_arena_cfg) g_ort->ReleaseArenaCfg(g_arena_cfg);
+        g_arena_cfg = NULL;
+        return;
+    }
+    SHIM_INFO("onnx", "memory arenas: extend=%s max=%zu initial chunk=%zu",
+              strategy[0] ? strategy : "default",
+              g_cfg->arena_max_memory, g_cfg->arena_initial_chunk);
+}
+
+static int onnx_init(const NeuronShimConfig* cfg) {
+    g_cfg = cfg;
+    onnx_init_placement(cfg);
+    g_ort = OrtGetApiBase()->GetApi(ORT_API_VERSION);
+    if (!g_ort) {
+        SHIM_ERR("onnx", "failed to get ORT API v%d",
+                 ORT_API_VERSION);
+        return -1;
+    }
+
+    if (!cfg->global_thread_pool) {
+        ORT_CHECK(g_ort,
+            g_ort->CreateEnv(ORT_LOGGING_LEVEL_WARNING, "neuron-shim", &g_env));
+        onnx_init_arenas();
+        return 0;
+    }
+
+    OrtThreadingOptions* tp = NULL;
+    ORT_CHECK(g_ort, g_ort->CreateThreadingOptions(&tp));
+
+    char affinity[4096];
+    OrtStatus* s = g_ort->SetGlobalIntraOpNumThreads(tp, onnx_thread_count());
+    if (!s) s = g_ort->SetGlobalInterOpNumThreads(tp, 1);
+    if (!s && onnx_affinity_string(cfg->cpu_affinity, onnx_thread_count(),
+                                   affinity, sizeof(affinity))) {
+        s = g_ort->SetGlobalIntraOpThreadAffinity(tp, affinity);
+        if (!s) SHIM_INFO("onnx", "intra-op threads pinned to %s", cfg->cpu_affinity);
+    }
+    if (!s) s = g_ort->CreateEnvWithGlobalThreadPools(
+                    ORT_LOGGING_LEVEL_WARNING, "neuron-shim", tp, &g_env);
+    g_ort->ReleaseThreadingOptions(tp);
+    ORT_CHECK(g_ort, s);
+
+    SHIM_INFO("onnx", "global thread pool: %d intra-op threads "
+              "shared by all sessions", onnx_thread_count());
+    onnx_init_arenas();
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* TensorRT options                                                    */
+/*                                                                     */
+/* Building TRT engines for a large model takes minutes, so engines    */
+/* are cached under <cache_dir>/trt/<model hash>/. Keying by content   */
+/* hash rather than path means a replaced model never loads a stale    */
+/* engine. TRT itself further keys engines by GPU and TRT version.     */
+/* ------------------------------------------------------------------ */
+static OrtStatus* onnx_configure_trt(OrtTensorRTProviderOptionsV2* trt_opts,
+                                     const char* path, const void* buf,
+                                     size_t size, const char* device) {
+    const char* keys[9];
+    const char* values[9];
+    size_t n = 0;
+
+    keys[n] = "device_id"; values[n++] = device;
+
+    char engine_dir[1024];
+    char timing_dir[1024];
+    char workspace[32];
+
+    if (g_cfg->trt_engine_cache) {
+        bool have_dir = false;
+        if (g_cfg->trt_engine_cache_path[0]) {
+            snprintf(engine_dir, sizeof(engine_dir), "%s",
+                     g_cfg->trt_engine_cache_path);
+            have_dir = true;
+        } else {
+            uint64_t hash = 0;
+            int rc = 0;
+            if (path)
+                rc = neuron_shim_hash_file(path, &hash);
+            else
+                hash = neuron_shim_hash_buffer(buf, size);
+
+            char sub[32];
+            snprintf(sub, sizeof(sub), "trt/%016llx", (unsigned long long)hash);
+            have_dir = rc == 0 &&
+                neuron_shim_config_cache_subdir(g_cfg, sub, engine_dir,
+                                                sizeof(engine_dir)) == 0;
+        }
+
+        if (have_dir) {
+            keys[n] = "trt_engine_cache_enable"; values[n++] = "1";
+            keys[n] = "trt_engine_cache_path";   values[n++] = engine_dir;
+            SHIM_INFO("onnx", "TensorRT engine cache: %s",
+                      engine_dir);
+        } else {
+            SHIM_WARN("onnx", "WARNING: TensorRT engine cache "
+                      "disabled (set cache_dir or trt_engine_cache_path)");
+        }
+    }
+
+    /* The timing cache is model-independent, so it's shared */
+    if (g_cfg->trt_timing_cache) {
+        if (neuron_shim_config_cache_subdir(g_cfg, "trt/timing", timing_dir,
+                                            sizeof(timing_dir)) == 0) {
+            keys[n] = "trt_timing_cache_enable"; values[n++] = "1";
+            keys[n] = "trt_timing_cache_path";   values[n++] = timing_dir;
+        } else {
+            SHIM_WARN("onnx", "WARNING: TensorRT timing cache "
+                      "disabled (set cache_dir)");
+        }
+    }
+
+    if (g_cfg->trt_fp16) {
+        keys[n] = "trt_fp16_enable"; values[n++] = "1";
+    }
+    if (g_cfg->trt_int8) {
+        keys[n] = "trt_int8_enable"; values[n++] = "1";
+    }
+    if (g_cfg->trt_max_workspace > 0) {
+        snprintf(workspace, sizeof(workspace), "%zu", g_cfg->trt_max_workspace);
+        keys[n] = "trt_max_workspace_size"; values[n++] = workspace;
+    }
+
+    return g_ort->UpdateTensorRTProviderOptions(trt_opts, keys, values, n);
+}
+
+/* ------------------------------------------------------------------ */
+/* Session options — built once per model (sessions are shared)       */
+/*                                                                     */
+/* The model source (path, or buf/size) is only used to key on-disk    */
+/* EP caches. GPU EPs are bound to 'device'; *pinned is set to the ORT */
+/* memory name of the GPU EP's pinned host memory if one registered,  */
+/* and 'eps' (EPS_LEN bytes) to the registered EPs, "cuda+cpu".        */
+/* *cuda_graph asks for CUDA graph mode and reports whether the CUDA   */
+/* EP took it; TensorRT is skipped then, it would claim the nodes.     */
+/* ------------------------------------------------------------------ */
+/* Per-model 'ep' list ("cuda,cpu"), else every EP */
+static bool onnx_ep_wanted(const NeuronShimModelConfig* mc, const char* ep) {
+    if (!mc || !mc->ep[0] || strcmp(mc->ep, "auto") == 0) return true;
+
+    char list[sizeof(mc->ep)];
+    snprintf(list, sizeof(list), "%s", mc->ep);
+    char* save = NULL;
+    for (char* p = strtok_r(list, ",", &save); p; p = strtok_r(NULL, ",", &save))
+        if (strcmp(p, ep) == 0) return true;
+    return false;
+}
+
+static void onnx_note_ep(char* eps, const char* ep) {
+    size_t n = strlen(eps);
+    snprintf(eps + n, EPS_LEN - n, "%s%s", n ? "+" : "", ep);
+}
+
+static int onnx_create_session_options(const char* path, const void* buf,
+                                       size_t size,
+                                       const NeuronShimModelConfig* mc,
+                                       int device, OrtSessionOptions** out,
+                                       const char** pinned, char* eps,
+                                       bool* cuda_graph, const char* profile) {
+    const OrtApi* api = g_ort;
+    OrtSessionOptions* opts = NULL;
+    char device_id[16];
+    snprintf(device_id, sizeof(device_id), "%d", device);
+    eps[0] = '\0';
+    bool graph = *cuda_graph;
+    *cuda_graph = false;
+
+    /* Session options — add execution providers in priority order */
+    ORT_CHECK(api, api->CreateSessionOptions(&opts));
+    *out = opts;
+
+    /* Threads: either the env's shared pool or a per-session pool */
+    const char* spec = mc && mc->cpu_affinity[0] ? mc->cpu_affinity
+                                                 : g_cfg->cpu_affinity;
+    if (g_cfg->global_thread_pool) {
+        ORT_CHECK(api, api->DisablePerSessionThreads(opts));
+        if (mc && mc->cpu_affinity[0])
+            SHIM_WARN("onnx", "WARNING: [model %s] cpu_affinity ignored, "
+                      "global_thread_pool is on", mc->pattern);
+    } else {
+        int  threads = mc && mc->threads > 0 ? mc->threads : onnx_thread_count();
+        char affinity[4096];
+        ORT_CHECK(api, api->SetIntraOpNumThreads(opts, threads));
+        if (onnx_affinity_string(spec, threads, affinity, sizeof(affinity))) {
+            ORT_CHECK(api, api->AddSessionConfigEntry(opts,
+                "session.intra_op_thread_affinities", affinity));
+            SHIM_DBG("onnx", "intra-op threads pinned: %s", affinity);
+        }
+    }
 
     /* Enable graph optimizations */
-    ORT_CHECK(c->api,
-        c->api->SetSessionGraphOptimizationLevel(c->session_opts,
-                                                  ORT_ENABLE_ALL));
+    ORT_CHECK(api,
+        api->SetSessionGraphOptimizationLevel(opts, ORT_ENABLE_ALL));
+
+    /* Memory: the env's CPU arena (onnx_init_arenas), activation plans */
+    if (g_arena_cfg)
+        ORT_CHECK(api, api->AddSessionConfigEntry(opts, "session.use_env_allocators", "1"));
+    if (!g_cfg->memory_pattern)
+        ORT_CHECK(api, api->DisableMemPattern(opts));
+
+    /* ORT's own per-node profile, merged into ours (profile.h) */
+    if (profile)
+        ORT_CHECK(api, api->EnableProfiling(opts, profile));
 
     /*
      * Execution provider registration.
@@ -170,44 +696,60 @@ static int onnx_create(void** ctx) {
      * (library not compiled with that EP), the call fails silently
      * and ORT falls back to CPU.
      *
-     * Priority: TensorRT > CUDA > MIGraphX > CPU
+     * Priority: TensorRT > CUDA > MIGraphX > CPU, limited to the
+     * model's 'ep' list if it has one.
      */
-    const char* force_cpu = getenv("NEURON_SHIM_FORCE_CPU");
-    if (!force_cpu || strcmp(force_cpu, "1") != 0) {
+    if (!g_cfg->force_cpu) {
 
         /* Try NVIDIA TensorRT (best perf on NVIDIA) */
-        {
+        if (onnx_ep_wanted(mc, "tensorrt") && !graph) {
             OrtTensorRTProviderOptionsV2* trt_opts = NULL;
-            OrtStatus* s = c->api->CreateTensorRTProviderOptions(&trt_opts);
+            OrtStatus* s = api->CreateTensorRTProviderOptions(&trt_opts);
             if (!s && trt_opts) {
-                s = c->api->SessionOptionsAppendExecutionProvider_TensorRT_V2(
-                        c->session_opts, trt_opts);
+                s = onnx_configure_trt(trt_opts, path, buf, size, device_id);
+                if (!s)
+                    s = api->SessionOptionsAppendExecutionProvider_TensorRT_V2(
+                            opts, trt_opts);
                 if (!s) {
-                    fprintf(stderr, "[neuron-shim][onnx] TensorRT EP: registered\n");
+                    SHIM_INFO("onnx", "TensorRT EP: registered");
+                    onnx_note_ep(eps, "tensorrt");
+                    *pinned = "CudaPinned";
                 } else {
-                    c->api->ReleaseStatus(s);
+                    api->ReleaseStatus(s);
                 }
-                c->api->ReleaseTensorRTProviderOptions(trt_opts);
+                api->ReleaseTensorRTProviderOptions(trt_opts);
             } else if (s) {
-                c->api->ReleaseStatus(s);
+                api->ReleaseStatus(s);
             }
         }
 
         /* Try NVIDIA CUDA */
-        {
+        if (onnx_ep_wanted(mc, "cuda")) {
             OrtCUDAProviderOptionsV2* cuda_opts = NULL;
-            OrtStatus* s = c->api->CreateCUDAProviderOptions(&cuda_opts);
+            OrtStatus* s = api->CreateCUDAProviderOptions(&cuda_opts);
             if (!s && cuda_opts) {
-                s = c->api->SessionOptionsAppendExecutionProvider_CUDA_V2(
-                        c->session_opts, cuda_opts);
+                const char* keys[]   = { "device_id", "enable_cuda_graph" };
+                const char* values[] = { device_id,   "1" };
+                s = api->UpdateCUDAProviderOptions(cuda_opts, keys, values,
+                                                   graph ? 2 : 1);
+                if (!s && g_arena_cfg)
+                    s = api->UpdateCUDAProviderOptionsWithValue(
+                            cuda_opts, "default_memory_arena_cfg", g_arena_cfg);
+                if (!s)
+                    s = api->SessionOptionsAppendExecutionProvider_CUDA_V2(
+                            opts, cuda_opts);
                 if (!s) {
-                    fprintf(stderr, "[neuron-shim][onnx] CUDA EP: registered\n");
+                    SHIM_INFO("onnx", "CUDA EP: registered%s",
+                              graph ? " (CUDA graph)" : "");
+                    onnx_note_ep(eps, "cuda");
+                    *cuda_graph = graph;
+                    *pinned = "CudaPinned";
                 } else {
-                    c->api->ReleaseStatus(s);
+                    api->ReleaseStatus(s);
                 }
-                c->api->ReleaseCUDAProviderOptions(cuda_opts);
+                api->ReleaseCUDAProviderOptions(cuda_opts);
             } else if (s) {
-                c->api->ReleaseStatus(s);
+                api->ReleaseStatus(s);
             }
         }
 
@@ -219,14 +761,18 @@ static int onnx_create(void** ctx) {
          */
         {
             typedef OrtStatus* (*MIGraphXFn)(OrtSessionOptions*, int);
-            MIGraphXFn migraphx_fn = (MIGraphXFn)dlsym(RTLD_DEFAULT,
-                "OrtSessionOptionsAppendExecutionProvider_MIGraphX");
+            MIGraphXFn migraphx_fn = onnx_ep_wanted(mc, "migraphx")
+                ? (MIGraphXFn)dlsym(RTLD_DEFAULT,
+                      "OrtSessionOptionsAppendExecutionProvider_MIGraphX")
+                : NULL;
             if (migraphx_fn) {
-                OrtStatus* s = migraphx_fn(c->session_opts, 0 /* device_id */);
+                OrtStatus* s = migraphx_fn(opts, device);
                 if (!s) {
-                    fprintf(stderr, "[neuron-shim][onnx] MIGraphX EP: registered\n");
+                    SHIM_INFO("onnx", "MIGraphX EP: registered");
+                    onnx_note_ep(eps, "migraphx");
+                    *pinned = "MIGraphXPinned";
                 } else {
-                    c->api->ReleaseStatus(s);
+                    api->ReleaseStatus(s);
                 }
             }
 
@@ -234,148 +780,1124 @@ static int onnx_create(void** ctx) {
             typedef OrtStatus* (*ROCmFn)(OrtSessionOptions*, int);
             ROCmFn rocm_fn = (ROCmFn)dlsym(RTLD_DEFAULT,
                 "OrtSessionOptionsAppendExecutionProvider_ROCM");
-            if (rocm_fn && !migraphx_fn) {
-                OrtStatus* s = rocm_fn(c->session_opts, 0);
+            if (rocm_fn && !migraphx_fn && onnx_ep_wanted(mc, "rocm")) {
+                OrtStatus* s = rocm_fn(opts, device);
                 if (!s) {
-                    fprintf(stderr, "[neuron-shim][onnx] ROCm EP: registered\n");
+                    SHIM_INFO("onnx", "ROCm EP: registered");
+                    onnx_note_ep(eps, "rocm");
+                    *pinned = "HipPinned";
                 } else {
-                    c->api->ReleaseStatus(s);
+                    api->ReleaseStatus(s);
                 }
             }
         }
     }
 
     /* CPU is always available as final fallback */
-    fprintf(stderr, "[neuron-shim][onnx] CPU EP: always available\n");
+    SHIM_INFO("onnx", "CPU EP: always available");
+    onnx_note_ep(eps, "cpu");
+
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* Lifecycle                                                           */
+/* ------------------------------------------------------------------ */
+static int onnx_create(void** ctx) {
+    if (!g_env) {
+        SHIM_ERR("onnx", "backend not initialized");
+        return -1;
+    }
+
+    OnnxContext* c = (OnnxContext*)calloc(1, sizeof(OnnxContext));
+    if (!c) return -1;
+
+    c->api = g_ort;
 
     /* Memory info for tensor creation */
     ORT_CHECK(c->api,
         c->api->CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault,
                                      &c->memory_info));
+    ORT_CHECK(c->api, c->api->CreateRunOptions(&c->run_options));
 
     *ctx = c;
     return 0;
 }
 
+/* Pick c's GPU, once, right before it needs a session */
+static void onnx_context_place(OnnxContext* c) {
+    if (c->placed) return;
+    c->device = onnx_place();
+    c->placed = true;
+    atomic_fetch_add(&g_devices[c->device].contexts, 1);
+}
+
 static void onnx_destroy(void* ctx) {
     OnnxContext* c = (OnnxContext*)ctx;
     if (!c) return;
 
-    if (c->session)      c->api->ReleaseSession(c->session);
-    if (c->session_opts) c->api->ReleaseSessionOptions(c->session_opts);
+    for (size_t i = 0; i < MAX_TENSORS; i++) {
+        for (size_t k = 0; k < VALUE_CACHE; k++)
+            if (c->input_bindings[i].cache[k].value)
+                c->api->ReleaseValue(c->input_bindings[i].cache[k].value);
+        if (c->output_bindings[i].value)
+            c->api->ReleaseValue(c->output_bindings[i].value);
+    }
+    for (size_t k = 0; k < SHAPE_CACHE; k++)
+        for (size_t i = 0; i < MAX_TENSORS; i++)
+            if (c->shapes[k].value[i])
+                c->api->ReleaseValue(c->shapes[k].value[i]);
+    if (c->batcher)      atomic_fetch_sub(&c->batcher->users, 1);
+    if (c->io_binding)   c->api->ReleaseIoBinding(c->io_binding);
+    if (c->owned)        onnx_model_release(c->owned);
     if (c->memory_info)  c->api->ReleaseMemoryInfo(c->memory_info);
-    if (c->env)          c->api->ReleaseEnv(c->env);
+    if (c->pinned_info)  c->api->ReleaseMemoryInfo(c->pinned_info);
+    if (c->run_options)  c->api->ReleaseRunOptions(c->run_options);
+    if (c->placed)       atomic_fetch_sub(&g_devices[c->device].contexts, 1);
     free(c);
 }
 
+/* ------------------------------------------------------------------ */
+/* Dynamic shapes                                                      */
+/*                                                                     */
+/* Symbolic input dims are resolved from the byte size the app passes  */
+/* to setInput: shape hints from the model's [model] section are tried */
+/* first (input_shape.N), then the declared shape; a candidate fits if */
+/* it has at most one unknown dim and the size divides evenly.         */
+/* ------------------------------------------------------------------ */
+static bool fill_from_size(const int64_t* shape, size_t rank, size_t elem,
+                           size_t size, int64_t* out) {
+    size_t known = elem;
+    int    unknown = -1;
+    for (size_t d = 0; d < rank; d++) {
+        if (shape[d] > 0) {
+            known *= (size_t)shape[d];
+        } else {
+            if (unknown >= 0) return false;
+            unknown = (int)d;
+        }
+    }
+    memcpy(out, shape, rank * sizeof(int64_t));
+    if (unknown < 0) return known == size;
+    if (size == 0 || size % known != 0) return false;
+    out[unknown] = (int64_t)(size / known);
+    return true;
+}
+
+/* Declared shape with its symbolic dims taken from 'h' */
+static bool merge_hint(const int64_t* shape, size_t rank,
+                       const NeuronShimShapeHint* h, int64_t* out) {
+    if (h->rank != rank) return false;
+    for (size_t d = 0; d < rank; d++)
+        out[d] = shape[d] > 0 ? shape[d] : h->dims[d];
+    return true;
+}
+
+static int onnx_infer_shape(const OnnxModel* m, size_t index, size_t size,
+                            int64_t* out) {
+    const int64_t* shape = m->inputs[index].shape;
+    size_t rank = m->inputs[index].num_dims;
+    size_t elem = ort_element_size(m->inputs[index].type);
+    int64_t cand[8];
+
+    if (m->cfg && index < NEURON_SHIM_MAX_IO) {
+        for (int h = 0; h < m->cfg->input_shape_count[index]; h++)
+            if (merge_hint(shape, rank, &m->cfg->input_shapes[index][h], cand) &&
+                fill_from_size(cand, rank, elem, size, out))
+                return 0;
+    }
+    return fill_from_size(shape, rank, elem, size, out) ? 0 : -1;
+}
+
+/* Shape reported before any setInput: the first fully concrete hint,
+ * else the declared shape with symbolic dims as 1 */
+static void onnx_default_shape(OnnxModel* m, size_t index) {
+    int64_t* out  = m->inputs[index].default_shape;
+    size_t   rank = m->inputs[index].num_dims;
+
+    m->inputs[index].dynamic = false;
+    for (size_t d = 0; d < rank; d++) {
+        out[d] = m->inputs[index].shape[d] > 0 ? m->inputs[index].shape[d] : 1;
+        if (m->inputs[index].shape[d] <= 0) m->inputs[index].dynamic = true;
+    }
+    if (!m->inputs[index].dynamic || !m->cfg || index >= NEURON_SHIM_MAX_IO)
+        return;
+
+    for (int h = 0; h < m->cfg->input_shape_count[index]; h++) {
+        int64_t cand[8];
+        if (!merge_hint(m->inputs[index].shape, rank,
+                        &m->cfg->input_shapes[index][h], cand))
+            continue;
+        bool concrete = true;
+        for (size_t d = 0; d < rank; d++) concrete &= cand[d] > 0;
+        if (concrete) {
+            memcpy(out, cand, rank * sizeof(int64_t));
+            return;
+        }
+    }
+}
+
 /* ------------------------------------------------------------------ */
 /* Helper: populate tensor metadata from a loaded session              */
 /* ------------------------------------------------------------------ */
-static int populate_tensor_info(OnnxContext* c) {
+static int populate_tensor_info(OnnxModel* m) {
+    const OrtApi* api = g_ort;
     OrtAllocator* allocator;
-    ORT_CHECK(c->api, c->api->GetAllocatorWithDefaultOptions(&allocator));
+    ORT_CHECK(api, api->GetAllocatorWithDefaultOptions(&allocator));
 
     /* Inputs */
-    ORT_CHECK(c->api, c->api->SessionGetInputCount(c->session, &c->input_count));
-    if (c->input_count > MAX_TENSORS) c->input_count = MAX_TENSORS;
+    ORT_CHECK(api, api->SessionGetInputCount(m->session, &m->input_count));
+    if (m->input_count > MAX_TENSORS) m->input_count = MAX_TENSORS;
 
-    for (size_t i = 0; i < c->input_count; i++) {
+    for (size_t i = 0; i < m->input_count; i++) {
         char* name;
-        ORT_CHECK(c->api, c->api->SessionGetInputName(c->session, i,
-                                                        allocator, &name));
-        snprintf(c->inputs[i].name, sizeof(c->inputs[i].name), "%s", name);
+        ORT_CHECK(api, api->SessionGetInputName(m->session, i,
+                                                  allocator, &name));
+        snprintf(m->inputs[i].name, sizeof(m->inputs[i].name), "%s", name);
         allocator->Free(allocator, name);
 
         OrtTypeInfo* type_info;
-        ORT_CHECK(c->api, c->api->SessionGetInputTypeInfo(c->session, i,
-                                                            &type_info));
+        ORT_CHECK(api, api->SessionGetInputTypeInfo(m->session, i,
+                                                      &type_info));
 
         const OrtTensorTypeAndShapeInfo* tensor_info;
-        ORT_CHECK(c->api, c->api->CastTypeInfoToTensorInfo(type_info,
-                                                             &tensor_info));
-
-        ORT_CHECK(c->api, c->api->GetTensorElementType(tensor_info,
-                                                         &c->inputs[i].type));
-        ORT_CHECK(c->api, c->api->GetDimensionsCount(tensor_info,
-                                                       &c->inputs[i].num_dims));
-        ORT_CHECK(c->api, c->api->GetDimensions(tensor_info,
-                                                  c->inputs[i].shape,
-                                                  c->inputs[i].num_dims));
-
-        c->inputs[i].size = compute_tensor_size(c->inputs[i].shape,
-                                                 c->inputs[i].num_dims,
-                                                 c->inputs[i].type);
-
-        c->api->ReleaseTypeInfo(type_info);
-
-        fprintf(stderr, "[neuron-shim][onnx] input[%zu]: '%s' %zu bytes\n",
-                i, c->inputs[i].name, c->inputs[i].size);
+        ORT_CHECK(api, api->CastTypeInfoToTensorInfo(type_info,
+                                                       &tensor_info));
+
+        ORT_CHECK(api, api->GetTensorElementType(tensor_info,
+                                                   &m->inputs[i].type));
+        ORT_CHECK(api, api->GetDimensionsCount(tensor_info,
+                                                 &m->inputs[i].num_dims));
+        if (m->inputs[i].num_dims > 8) m->inputs[i].num_dims = 8;
+        ORT_CHECK(api, api->GetDimensions(tensor_info,
+                                            m->inputs[i].shape,
+                                            m->inputs[i].num_dims));
+
+        onnx_default_shape(m, i);
+        m->inputs[i].size = compute_tensor_size(m->inputs[i].default_shape,
+                                                 m->inputs[i].num_dims,
+                                                 m->inputs[i].type);
+
+        api->ReleaseTypeInfo(type_info);
+
+        SHIM_INFO("onnx", "input[%zu]: '%s' %zu bytes%s",
+                  i, m->inputs[i].name, m->inputs[i].size,
+                  m->inputs[i].dynamic ? " (dynamic, sized by setInput)" : "");
     }
 
     /* Outputs */
-    ORT_CHECK(c->api, c->api->SessionGetOutputCount(c->session, &c->output_count));
-    if (c->output_count > MAX_TENSORS) c->output_count = MAX_TENSORS;
+    ORT_CHECK(api, api->SessionGetOutputCount(m->session, &m->output_count));
+    if (m->output_count > MAX_TENSORS) m->output_count = MAX_TENSORS;
 
-    for (size_t i = 0; i < c->output_count; i++) {
+    for (size_t i = 0; i < m->output_count; i++) {
         char* name;
-        ORT_CHECK(c->api, c->api->SessionGetOutputName(c->session, i,
-                                                         allocator, &name));
-        snprintf(c->outputs[i].name, sizeof(c->outputs[i].name), "%s", name);
+        ORT_CHECK(api, api->SessionGetOutputName(m->session, i,
+                                                   allocator, &name));
+        snprintf(m->outputs[i].name, sizeof(m->outputs[i].name), "%s", name);
         allocator->Free(allocator, name);
 
         OrtTypeInfo* type_info;
-        ORT_CHECK(c->api, c->api->SessionGetOutputTypeInfo(c->session, i,
-                                                             &type_info));
+        ORT_CHECK(api, api->SessionGetOutputTypeInfo(m->session, i,
+                                                       &type_info));
 
         const OrtTensorTypeAndShapeInfo* tensor_info;
-        ORT_CHECK(c->api, c->api->CastTypeInfoToTensorInfo(type_info,
-                                                             &tensor_info));
+        ORT_CHECK(api, api->CastTypeInfoToTensorInfo(type_info,
+                                                       &tensor_info));
+
+        ORT_CHECK(api, api->GetTensorElementType(tensor_info,
+                                                   &m->outputs[i].type));
+        ORT_CHECK(api, api->GetDimensionsCount(tensor_info,
+                                                 &m->outputs[i].num_dims));
+        if (m->outputs[i].num_dims > 8) m->outputs[i].num_dims = 8;
+        ORT_CHECK(api, api->GetDimensions(tensor_info,
+                                            m->outputs[i].shape,
+                                            m->outputs[i].num_dims));
+
+        m->outputs[i].size = compute_tensor_size(m->outputs[i].shape,
+                                                  m->outputs[i].num_dims,
+                                                  m->outputs[i].type);
+        m->outputs[i].dynamic = false;
+        for (size_t d = 0; d < m->outputs[i].num_dims; d++)
+            if (m->outputs[i].shape[d] <= 0) m->outputs[i].dynamic = true;
+        m->dynamic_outputs |= m->outputs[i].dynamic;
+
+        api->ReleaseTypeInfo(type_info);
+
+        SHIM_INFO("onnx", "output[%zu]: '%s' %zu bytes",
+                  i, m->outputs[i].name, m->outputs[i].size);
+    }
+
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* Model loading                                                       */
+/* ------------------------------------------------------------------ */
 
-        ORT_CHECK(c->api, c->api->GetTensorElementType(tensor_info,
-                                                         &c->outputs[i].type));
-        ORT_CHECK(c->api, c->api->GetDimensionsCount(tensor_info,
-                                                       &c->outputs[i].num_dims));
-        ORT_CHECK(c->api, c->api->GetDimensions(tensor_info,
-                                                  c->outputs[i].shape,
-                                                  c->outputs[i].num_dims));
+/* ------------------------------------------------------------------ */
+/* Optimized-model cache                                               */
+/*                                                                     */
+/* ORT_ENABLE_ALL graph optimization of a large model can take longer  */
+/* than the rest of startup. The first load saves the optimized graph  */
+/* to <cache_dir>/ort/<model hash>/<ORT version>-<EPs>.{onnx,ort};     */
+/* later loads open that with optimization off. CPU-only sessions save */
+/* ORT format, which is mmapped and used in place rather than parsed   */
+/* into heap. TensorRT and MIGraphX compile subgraphs ORT can't save,  */
+/* so sessions using them aren't cached (TRT has its engine cache).    */
+/* ------------------------------------------------------------------ */
+enum { OPT_CACHE_OFF, OPT_CACHE_HIT, OPT_CACHE_WRITE };
 
-        c->outputs[i].size = compute_tensor_size(c->outputs[i].shape,
-                                                  c->outputs[i].num_dims,
-                                                  c->outputs[i].type);
+typedef struct {
+    char file[1024];
+    char tmp[1100];
+    bool ort_format;
+} OptCache;
+
+static int onnx_opt_cache_prepare(OptCache* oc, const char* path,
+                                  const void* buf, size_t size,
+                                  const char* eps) {
+    if (!g_cfg->optimized_model_cache) return OPT_CACHE_OFF;
+    if (strstr(eps, "tensorrt") || strstr(eps, "migraphx")) {
+        SHIM_DBG("onnx", "optimized model cache: skipped for %s", eps);
+        return OPT_CACHE_OFF;
+    }
 
-        c->api->ReleaseTypeInfo(type_info);
+    uint64_t hash = 0;
+    if (path) {
+        if (neuron_shim_hash_file(path, &hash) != 0) return OPT_CACHE_OFF;
+    } else {
+        hash = neuron_shim_hash_buffer(buf, size);
+    }
 
-        fprintf(stderr, "[neuron-shim][onnx] output[%zu]: '%s' %zu bytes\n",
-                i, c->outputs[i].name, c->outputs[i].size);
+    char sub[32], dir[1024];
+    snprintf(sub, sizeof(sub), "ort/%016llx", (unsigned long long)hash);
+    if (neuron_shim_config_cache_subdir(g_cfg, sub, dir, sizeof(dir)) != 0) {
+        SHIM_WARN("onnx", "WARNING: optimized model cache disabled (set cache_dir)");
+        return OPT_CACHE_OFF;
     }
 
+    oc->ort_format = strcmp(eps, "cpu") == 0;
+    int n = snprintf(oc->file, sizeof(oc->file), "%s/%s-%s.%s", dir,
+                     OrtGetApiBase()->GetVersionString(), eps,
+                     oc->ort_format ? "ort" : "onnx");
+    if (n < 0 || (size_t)n >= sizeof(oc->file)) return OPT_CACHE_OFF;
+
+    /* One per session: private loads of a model may race on threads */
+    static _Atomic unsigned seq;
+    snprintf(oc->tmp, sizeof(oc->tmp), "%s.%d.%u.tmp", oc->file, (int)getpid(),
+             atomic_fetch_add(&seq, 1));
+
+    return access(oc->file, R_OK) == 0 ? OPT_CACHE_HIT : OPT_CACHE_WRITE;
+}
+
+/* Load the cached model; ORT-format ones straight from the mapping */
+static OrtStatus* onnx_opt_cache_open(const OptCache* oc, OrtSessionOptions* opts,
+                                      OrtSession** session, OnnxMapping* map) {
+    OrtStatus* s;
+    if (!oc->ort_format) {
+        s = g_ort->SetSessionGraphOptimizationLevel(opts, ORT_DISABLE_ALL);
+        return s ? s : g_ort->CreateSession(g_env, oc->file, opts, session);
+    }
+    if (!map) return g_ort->CreateSession(g_env, oc->file, opts, session);
+
+    int fd = open(oc->file, O_RDONLY);
+    struct stat st;
+    void* addr = MAP_FAILED;
+    if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0)
+        addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (fd >= 0) close(fd);
+    if (addr == MAP_FAILED)
+        return g_ort->CreateSession(g_env, oc->file, opts, session);
+
+    /* Weights too: initializers point into the mapping, not the heap */
+    s = g_ort->AddSessionConfigEntry(opts, "session.use_ort_model_bytes_directly", "1");
+    if (!s) s = g_ort->AddSessionConfigEntry(opts,
+                    "session.use_ort_model_bytes_for_initializers", "1");
+    if (!s) s = g_ort->CreateSessionFromArray(g_env, addr, (size_t)st.st_size,
+                                              opts, session);
+    if (s) {
+        munmap(addr, (size_t)st.st_size);
+        return s;
+    }
+    map->addr = addr;
+    map->size = (size_t)st.st_size;
+    return NULL;
+}
+
+/* Ask ORT to write the optimized model while it creates the session */
+static int onnx_opt_cache_arm(const OptCache* oc, OrtSessionOptions* opts) {
+    OrtStatus* s = g_ort->AddSessionConfigEntry(opts, "session.save_model_format",
+                                                oc->ort_format ? "ORT" : "ONNX");
+    if (!s) s = g_ort->SetOptimizedModelFilePath(opts, oc->tmp);
+    if (s) {
+        g_ort->ReleaseStatus(s);
+        return OPT_CACHE_OFF;
+    }
+    return OPT_CACHE_WRITE;
+}
+
+/*
+ * Create a session on 'device' from a path or an in-memory buffer.
+ * If the session runs from a cached mapping, it is stored in *map
+ * (may be NULL: then the cache is read, not mapped). *cuda_graph and
+ * 'eps' (may be NULL) are as for onnx_create_session_options().
+ * 'profile' is the file prefix for ORT's profile, NULL = off.
+ */
+static OrtSession* onnx_session_create(const char* path, const void* buf,
+                                       size_t size,
+                                       const NeuronShimModelConfig* mc,
+                                       int device, const char** pinned,
+                                       OnnxMapping* map, bool* cuda_graph,
+                                       char* eps_out, const char* profile) {
+    bool graph = *cuda_graph;
+    bool use_cache = true;
+    for (;;) {
+        OrtSessionOptions* opts = NULL;
+        char local_eps[EPS_LEN];
+        char* eps = eps_out ? eps_out : local_eps;
+        *cuda_graph = graph;
+        if (onnx_create_session_options(path, buf, size, mc, device, &opts,
+                                        pinned, eps, cuda_graph, profile) != 0) {
+            if (opts) g_ort->ReleaseSessionOptions(opts);
+            return NULL;
+        }
+
+        OptCache oc;
+        int state = use_cache ? onnx_opt_cache_prepare(&oc, path, buf, size, eps)
+                              : OPT_CACHE_OFF;
+        if (state == OPT_CACHE_WRITE) state = onnx_opt_cache_arm(&oc, opts);
+
+        OrtSession* session = NULL;
+        OrtStatus* s;
+        if (state == OPT_CACHE_HIT)
+            s = onnx_opt_cache_open(&oc, opts, &session, map);
+        else
+            s = path ? g_ort->CreateSession(g_env, path, opts, &session)
+                     : g_ort->CreateSessionFromArray(g_env, buf, size, opts, &session);
+        g_ort->ReleaseSessionOptions(opts);
+
+        if (!s) {
+            if (state == OPT_CACHE_HIT) {
+                SHIM_INFO("onnx", "optimized model from cache: %s", oc.file);
+            } else if (state == OPT_CACHE_WRITE) {
+                if (rename(oc.tmp, oc.file) == 0)
+                    SHIM_INFO("onnx", "optimized model saved: %s", oc.file);
+                else
+                    unlink(oc.tmp);
+            }
+            return session;
+        }
+
+        if (state == OPT_CACHE_OFF) {
+            SHIM_ERR("onnx", "ERROR: %s",
+                     g_ort->GetErrorMessage(s));
+            g_ort->ReleaseStatus(s);
+            return NULL;
+        }
+
+        /* A stale or unreadable artifact is rebuilt; if saving is what
+         * failed, load without the cache */
+        SHIM_WARN("onnx", "WARNING: optimized model cache: %s",
+                  g_ort->GetErrorMessage(s));
+        g_ort->ReleaseStatus(s);
+        if (state == OPT_CACHE_HIT) {
+            use_cache = unlink(oc.file) == 0;
+        } else {
+            unlink(oc.tmp);
+            use_cache = false;
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* CUDA graphs                                                         */
+/*                                                                     */
+/* With cuda_graph set in its [model] section, a fixed-shape model's   */
+/* CUDA EP captures the whole run once and then replays it, which      */
+/* removes per-kernel launch overhead. ORT requires every node on the  */
+/* CUDA EP (it refuses the session otherwise) and I/O bound to device  */
+/* memory at the same addresses on every run: see OnnxGraph. The       */
+/* copies in and out go through cudart, looked up like host_mem.c does.*/
+/* ------------------------------------------------------------------ */
+#define CUDA_MEMCPY_DEFAULT 4   /* cudaMemcpyDefault: direction from UVA */
+
+typedef int (*CudaSetDeviceFn)(int device);
+typedef int (*CudaMemcpyFn)(void* dst, const void* src, size_t size, int kind);
+typedef int (*CudaStreamSyncFn)(void* stream);
+
+static struct {
+    CudaSetDeviceFn  set_device;
+    CudaMemcpyFn     memcpy;
+    CudaStreamSyncFn stream_synchronize;
+} g_cudart;
+
+static bool onnx_cudart_lookup(void* h) {
+    g_cudart.set_device         = (CudaSetDeviceFn)dlsym(h, "cudaSetDevice");
+    g_cudart.memcpy             = (CudaMemcpyFn)dlsym(h, "cudaMemcpy");
+    g_cudart.stream_synchronize = (CudaStreamSyncFn)dlsym(h, "cudaStreamSynchronize");
+    return g_cudart.set_device && g_cudart.memcpy && g_cudart.stream_synchronize;
+}
+
+/* The CUDA EP has loaded cudart by now; only look, never load it */
+static bool onnx_load_cudart(void) {
+    static const char* const libs[] = {
+        "libcudart.so", "libcudart.so.12", "libcudart.so.11.0", NULL,
+    };
+    static pthread_mutex_t once = PTHREAD_MUTEX_INITIALIZER;
+
+    pthread_mutex_lock(&once);
+    bool ok = g_cudart.memcpy || onnx_cudart_lookup(RTLD_DEFAULT);
+    for (int i = 0; libs[i] && !ok; i++) {
+        void* h = dlopen(libs[i], RTLD_LAZY | RTLD_NOLOAD);
+        if (h) ok = onnx_cudart_lookup(h);
+    }
+    if (!ok) memset(&g_cudart, 0, sizeof(g_cudart));
+    pthread_mutex_unlock(&once);
+    return ok;
+}
+
+static void onnx_graph_free(OnnxGraph* g) {
+    if (!g) return;
+    for (size_t i = 0; i < MAX_TENSORS; i++) {
+        if (g->inputs[i])  g_ort->ReleaseValue(g->inputs[i]);
+        if (g->outputs[i]) g_ort->ReleaseValue(g->outputs[i]);
+    }
+    if (g->binding)   g_ort->ReleaseIoBinding(g->binding);
+    if (g->allocator) g_ort->ReleaseAllocator(g->allocator);
+    pthread_mutex_destroy(&g->lock);
+    free(g);
+}
+
+/* Device tensors for every input and output of 'session', bound once */
+static OnnxGraph* onnx_graph_create(const OnnxModel* m, OrtSession* session,
+                                    int device) {
+    if (!onnx_load_cudart()) {
+        SHIM_ERR("onnx", "CUDA graph: libcudart not loaded");
+        return NULL;
+    }
+
+    OnnxGraph* g = (OnnxGraph*)calloc(1, sizeof(OnnxGraph));
+    if (!g) return NULL;
+    pthread_mutex_init(&g->lock, NULL);
+
+    OrtMemoryInfo* info = NULL;
+    OrtStatus* s = g_ort->CreateMemoryInfo("Cuda", OrtDeviceAllocator, device,
+                                           OrtMemTypeDefault, &info);
+    if (!s) s = g_ort->CreateAllocator(session, info, &g->allocator);
+    if (!s) s = g_ort->CreateIoBinding(session, &g->binding);
+
+    for (size_t i = 0; !s && i < m->input_count; i++) {
+        s = g_ort->CreateTensorAsOrtValue(g->allocator, m->inputs[i].shape,
+                                          m->inputs[i].num_dims,
+                                          m->inputs[i].type, &g->inputs[i]);
+        if (!s) s = g_ort->GetTensorMutableData(g->inputs[i], &g->input_ptr[i]);
+        if (!s) s = g_ort->BindInput(g->binding, m->inputs[i].name, g->inputs[i]);
+    }
+    for (size_t i = 0; !s && i < m->output_count; i++) {
+        s = g_ort->CreateTensorAsOrtValue(g->allocator, m->outputs[i].shape,
+                                          m->outputs[i].num_dims,
+                                          m->outputs[i].type, &g->outputs[i]);
+        if (!s) s = g_ort->GetTensorMutableData(g->outputs[i], &g->output_ptr[i]);
+        if (!s) s = g_ort->BindOutput(g->binding, m->outputs[i].name, g->outputs[i]);
+    }
+    if (info) g_ort->ReleaseMemoryInfo(info);
+
+    if (s) {
+        SHIM_ERR("onnx", "CUDA graph: %s", g_ort->GetErrorMessage(s));
+        g_ort->ReleaseStatus(s);
+        onnx_graph_free(g);
+        return NULL;
+    }
+    return g;
+}
+
+/* The graph state for the model's session on 'device', built on first use */
+static OnnxGraph* onnx_model_graph(OnnxModel* m, OrtSession* session, int device) {
+    pthread_mutex_lock(&m->lock);
+    if (!m->graphs[device])
+        m->graphs[device] = onnx_graph_create(m, session, device);
+    OnnxGraph* g = m->graphs[device];
+    pthread_mutex_unlock(&m->lock);
+    return g;
+}
+
+/* Replay needs every shape fixed up front */
+static bool onnx_graph_shapes_fixed(const OnnxModel* m) {
+    for (size_t i = 0; i < m->input_count; i++)
+        if (m->inputs[i].dynamic) return false;
+    return !m->dynamic_outputs;
+}
+
+/* ------------------------------------------------------------------ */
+/* Micro-batching                                                      */
+/*                                                                     */
+/* With batch_window_us set, runtimes that share a session (one per    */
+/* camera stream, say) have concurrent inferences coalesced: the first */
+/* caller waits up to the window, or until every other runtime on the  */
+/* session has joined, then runs all of them as one batch along dim 0  */
+/* and scatters the results. Each caller still returns only once its   */
+/* outputs are written. Needs an export whose inputs and outputs all   */
+/* have a symbolic leading dim; members of a batch must have identical */
+/* input shapes, anything else runs on its own.                        */
+/* ------------------------------------------------------------------ */
+#define BATCH_ALONE 1     /* onnx_invoke_batched: run it unbatched */
+
+struct OnnxBatch {
+    OnnxContext* members[NEURON_SHIM_MAX_BATCH];
+    int          count;
+    int          limit;
+    uint64_t     key;     /* onnx_shape_key() of every member */
+};
+
+static bool onnx_batchable(const OnnxModel* m) {
+    for (size_t i = 0; i < m->input_count; i++)
+        if (m->inputs[i].num_dims == 0 || m->inputs[i].shape[0] > 0) return false;
+    for (size_t i = 0; i < m->output_count; i++)
+        if (m->outputs[i].num_dims == 0 || m->outputs[i].shape[0] > 0) return false;
+    return m->input_count > 0;
+}
+
+static OnnxBatcher* onnx_batcher_create(void) {
+    OnnxBatcher* q = (OnnxBatcher*)calloc(1, sizeof(OnnxBatcher));
+    if (!q) return NULL;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&q->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&q->lock, NULL);
+    return q;
+}
+
+static void onnx_batcher_free(OnnxBatcher* q) {
+    if (!q) return;
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->lock);
+    free(q);
+}
+
+/* The queue for the model's session on 'device', built on first use */
+static OnnxBatcher* onnx_model_batcher(OnnxModel* m, int device) {
+    pthread_mutex_lock(&m->lock);
+    if (!m->batchers[device]) m->batchers[device] = onnx_batcher_create();
+    OnnxBatcher* q = m->batchers[device];
+    pthread_mutex_unlock(&m->lock);
+    return q;
+}
+
+/* ------------------------------------------------------------------ */
+/* Autotuning                                                          */
+/*                                                                     */
+/* 'ep = auto' and 'threads = auto' (see autotune.h) are resolved at   */
+/* load, after the first session is built with every EP and the        */
+/* default thread count. EP lists are tried first: the registered EPs  */
+/* minus the highest-priority ones, one at a time ("tensorrt,cuda,cpu" */
+/* then "cuda,cpu" then "cpu"), since a small model often loses more   */
+/* to launches and copies than it gains on the GPU. Thread counts are  */
+/* then tried on the winning list. Every candidate is a fresh session  */
+/* timed on zero-filled inputs of the default shapes; the fastest one  */
+/* is kept as the model's session, so tuning costs no extra load.      */
+/* ------------------------------------------------------------------ */
+typedef struct {
+    const OnnxModel* m;
+    OrtSession*      session;
+    OrtValue*        inputs[MAX_TENSORS];
+    const char*      in_names[MAX_TENSORS];
+    const char*      out_names[MAX_TENSORS];
+} OnnxTrial;
+
+static int onnx_trial_run(void* arg) {
+    OnnxTrial* t = (OnnxTrial*)arg;
+    OrtValue* outputs[MAX_TENSORS] = {0};
+    OrtStatus* s = g_ort->Run(t->session, NULL, t->in_names,
+                              (const OrtValue* const*)t->inputs, t->m->input_count,
+                              t->out_names, t->m->output_count, outputs);
+    for (size_t i = 0; i < t->m->output_count; i++)
+        if (outputs[i]) g_ort->ReleaseValue(outputs[i]);
+    if (s) {
+        SHIM_DBG("onnx", "tuning run failed: %s", g_ort->GetErrorMessage(s));
+        g_ort->ReleaseStatus(s);
+        return -1;
+    }
     return 0;
 }
 
+static void onnx_trial_free(OnnxTrial* t) {
+    for (size_t i = 0; i < MAX_TENSORS; i++)
+        if (t->inputs[i]) g_ort->ReleaseValue(t->inputs[i]);
+}
+
+static int onnx_trial_init(OnnxTrial* t, const OnnxModel* m) {
+    memset(t, 0, sizeof(*t));
+    t->m = m;
+
+    OrtAllocator* alloc = NULL;
+    if (g_ort->GetAllocatorWithDefaultOptions(&alloc) != NULL) return -1;
+    for (size_t i = 0; i < m->input_count; i++) {
+        if (m->inputs[i].type == ONNX_TENSOR_ELEMENT_DATA_TYPE_STRING) {
+            SHIM_WARN("onnx", "WARNING: can't autotune %s: string input %s",
+                      m->path, m->inputs[i].name);
+            onnx_trial_free(t);
+            return -1;
+        }
+        void* data = NULL;
+        OrtStatus* s = g_ort->CreateTensorAsOrtValue(alloc, m->inputs[i].default_shape,
+                                                     m->inputs[i].num_dims,
+                                                     m->inputs[i].type, &t->inputs[i]);
+        if (!s) s = g_ort->GetTensorMutableData(t->inputs[i], &data);
+        if (s) {
+            g_ort->ReleaseStatus(s);
+            onnx_trial_free(t);
+            return -1;
+        }
+        memset(data, 0, m->inputs[i].size);
+        t->in_names[i] = m->inputs[i].name;
+    }
+    for (size_t i = 0; i < m->output_count; i++)
+        t->out_names[i] = m->outputs[i].name;
+    return 0;
+}
+
+/* The tuning wanted for m->cfg; on a stored result, apply it instead.
+ * Either way m->cfg points at m->tuned afterwards. */
+static bool onnx_tune_prepare(OnnxModel* m, const char* path, const void* buf,
+                              size_t size, char* file, size_t file_len,
+                              bool* tune_ep, bool* tune_threads) {
+    const NeuronShimModelConfig* mc = m->cfg;
+    int threads = mc && mc->threads ? mc->threads : g_cfg->threads;
+    *tune_ep      = mc && strcmp(mc->ep, "auto") == 0 && !g_cfg->force_cpu;
+    *tune_threads = threads == NEURON_SHIM_THREADS_AUTO && !g_cfg->global_thread_pool;
+    if (!*tune_ep && !*tune_threads) return false;
+
+    if (mc && mc->cuda_graph) {
+        SHIM_WARN("onnx", "WARNING: [model %s] autotuning skipped, cuda_graph is on",
+                  mc->pattern);
+        return false;
+    }
+
+    if (mc) m->tuned = *mc;
+    m->cfg = &m->tuned;
+
+    uint64_t hash = 0;
+    if (path) {
+        if (neuron_shim_hash_file(path, &hash) != 0) return true;
+    } else {
+        hash = neuron_shim_hash_buffer(buf, size);
+    }
+
+    /* Results only carry over while what they were measured under holds */
+    char variant[256];
+    snprintf(variant, sizeof(variant), "onnx-%s-%s-%s",
+             OrtGetApiBase()->GetVersionString(),
+             mc && mc->cpu_affinity[0] ? mc->cpu_affinity : g_cfg->cpu_affinity,
+             mc ? mc->ep : "");
+    if (neuron_shim_tune_file(hash, variant, file, file_len) != 0) {
+        SHIM_WARN("onnx", "WARNING: tuning results won't be kept (set cache_dir)");
+        file[0] = '\0';
+        return true;
+    }
+
+    NeuronShimTuning t;
+    if (neuron_shim_tune_load(file, &t) != 0 ||
+        (*tune_ep && !t.ep[0]) || (*tune_threads && t.threads <= 0))
+        return true;
+
+    if (*tune_ep)      snprintf(m->tuned.ep, sizeof(m->tuned.ep), "%s", t.ep);
+    if (*tune_threads) m->tuned.threads = t.threads;
+    SHIM_INFO("onnx", "tuned settings from %s: ep=%s threads=%d", file,
+              m->tuned.ep[0] ? m->tuned.ep : "all", m->tuned.threads);
+    return false;
+}
+
+/* Fastest candidate so far */
+typedef struct {
+    OrtSession* session;
+    const char* pinned;
+    char        ep[64];
+    char        eps[EPS_LEN];   /* what registered for 'ep' */
+    int         threads;
+    double      us;
+} OnnxTuneBest;
+
+/* Build and time a session with m->tuned's settings; it replaces *best
+ * if it's faster. The model's own session is never released here. */
+static void onnx_tune_try(OnnxModel* m, OnnxTrial* t, const char* path,
+                          const void* buf, size_t size, int device,
+                          OnnxTuneBest* best) {
+    const char* pinned = NULL;
+    char eps[EPS_LEN];
+    bool graph = false;
+    OrtSession* session = onnx_session_create(path, buf, size, m->cfg, device,
+                                              &pinned, NULL, &graph, eps, NULL);
+    if (!session) return;
+
+    double us;
+    t->session = session;
+    if (neuron_shim_tune_measure(onnx_trial_run, t, &us) != 0) {
+        g_ort->ReleaseSession(session);
+        return;
+    }
+    SHIM_INFO("onnx", "autotune: ep=%s threads=%d: %.0f us", eps,
+              m->tuned.threads, us);
+
+    if (us >= best->us) {
+        g_ort->ReleaseSession(session);
+        return;
+    }
+    if (best->session != m->session) g_ort->ReleaseSession(best->session);
+    best->session = session;
+    best->pinned  = pinned;
+    best->threads = m->tuned.threads;
+    best->us      = us;
+    snprintf(best->ep, sizeof(best->ep), "%s", m->tuned.ep);
+    snprintf(best->eps, sizeof(best->eps), "%s", eps);
+}
+
+static void onnx_eps_to_list(char* list, size_t len, const char* eps) {
+    snprintf(list, len, "%s", eps);
+    for (char* p = list; *p; p++)
+        if (*p == '+') *p = ',';
+}
+
+static void onnx_autotune(OnnxModel* m, const char* path, const void* buf,
+                          size_t size, int device, const char* eps,
+                          bool tune_ep, bool tune_threads, const char* file) {
+    OnnxTrial t;
+    if (onnx_trial_init(&t, m) != 0) return;
+
+    /* The session built with the defaults is the first candidate */
+    OnnxTuneBest best = {
+        .session = m->session,
+        .pinned  = m->pinned_name,
+        .threads = m->tuned.threads > 0 ? m->tuned.threads : onnx_thread_count(),
+    };
+    onnx_eps_to_list(best.ep, sizeof(best.ep), eps);
+    snprintf(best.eps, sizeof(best.eps), "%s", eps);
+    t.session = m->session;
+    if (neuron_shim_tune_measure(onnx_trial_run, &t, &best.us) != 0) {
+        SHIM_WARN("onnx", "WARNING: can't autotune %s: synthetic run failed", m->path);
+        onnx_trial_free(&t);
+        return;
+    }
+    SHIM_INFO("onnx", "autotune: ep=%s threads=%d: %.0f us", eps,
+              best.threads, best.us);
+    m->tuned.threads = best.threads;
+
+    if (tune_ep) {
+        char list[sizeof(best.ep)];
+        snprintf(list, sizeof(list), "%s", best.ep);
+        for (char* p = strchr(list, ','); p; p = strchr(p + 1, ',')) {
+            snprintf(m->tuned.ep, sizeof(m->tuned.ep), "%s", p + 1);
+            onnx_tune_try(m, &t, path, buf, size, device, &best);
+        }
+    }
+    snprintf(m->tuned.ep, sizeof(m->tuned.ep), "%s", best.ep);
+
+    if (tune_threads) {
+        const char* spec = m->tuned.cpu_affinity[0] ? m->tuned.cpu_affinity
+                                                    : g_cfg->cpu_affinity;
+        int first = best.threads;
+        int cand[NEURON_SHIM_TUNE_MAX_THREADS];
+        int n = neuron_shim_tune_threads(spec, cand, NEURON_SHIM_TUNE_MAX_THREADS);
+        for (int i = 0; i < n; i++) {
+            if (cand[i] == first) continue;
+            m->tuned.threads = cand[i];
+            onnx_tune_try(m, &t, path, buf, size, device, &best);
+        }
+    }
+    m->tuned.threads = best.threads;
+    onnx_trial_free(&t);
+
+    SHIM_INFO("onnx", "tuned %s: ep=%s threads=%d (%.0f us)", m->path,
+              best.ep, best.threads, best.us);
+    if (best.session != m->session) {
+        /* The default session may have run from a cached mapping */
+        g_ort->ReleaseSession(m->session);
+        if (m->mapping.addr) munmap(m->mapping.addr, m->mapping.size);
+        memset(&m->mapping, 0, sizeof(m->mapping));
+        m->session = m->device_sessions[device] = best.session;
+        m->pinned_name = best.pinned;
+        m->gpu = best.pinned != NULL;
+        snprintf(m->eps, sizeof(m->eps), "%s", best.eps);
+    }
+
+    NeuronShimTuning result = { .threads = tune_threads ? best.threads : 0 };
+    if (tune_ep) snprintf(result.ep, sizeof(result.ep), "%s", best.ep);
+    if (file[0] && neuron_shim_tune_save(file, &result) == 0)
+        SHIM_INFO("onnx", "tuning saved: %s", file);
+}
+
 /* ------------------------------------------------------------------ */
-/* Model loading                                                       */
+/* Profiling (profile.h)                                               */
+/*                                                                     */
+/* A profiled model's home session is built with ORT's profiler on;    */
+/* after profile_runs runs on it (by any runtime) ORT writes its JSON, */
+/* which is merged into the shim's trace. Other devices' sessions and  */
+/* autotuning candidates are never profiled.                           */
 /* ------------------------------------------------------------------ */
-static int onnx_load_from_file(void* ctx, const char* path) {
+static const char* onnx_profile_prefix(const OnnxModel* m, bool tuning,
+                                       char* out, size_t len) {
+    static _Atomic int seq;
+    if (neuron_shim_profile_runs(g_cfg, m->cfg) <= 0) return NULL;
+    if (tuning) {
+        SHIM_INFO("onnx", "not profiling %s with ORT while autotuning it", m->path);
+        return NULL;
+    }
+    snprintf(out, len, "%s.onnx-%d", neuron_shim_profile_path(),
+             atomic_fetch_add(&seq, 1));
+    return out;
+}
+
+/* Stop a session's ORT profile and merge it, or just throw it away */
+static void onnx_profile_end(OrtSession* session, bool merge) {
+    OrtAllocator* alloc = NULL;
+    char*         file  = NULL;
+    uint64_t      start = 0;
+    OrtStatus* s = g_ort->SessionGetProfilingStartTimeNs(session, &start);
+    if (!s) s = g_ort->GetAllocatorWithDefaultOptions(&alloc);
+    if (!s) s = g_ort->SessionEndProfiling(session, alloc, &file);
+    if (s) {
+        SHIM_WARN("onnx", "WARNING: ORT profile lost: %s", g_ort->GetErrorMessage(s));
+        g_ort->ReleaseStatus(s);
+        return;
+    }
+
+    if (!merge) {
+        unlink(file);
+    } else {
+        int n = neuron_shim_profile_merge(file, start);
+        if (n < 0) SHIM_WARN("onnx", "WARNING: can't read ORT profile %s", file);
+        else       SHIM_INFO("onnx", "merged %d ORT profile events", n);
+    }
+    alloc->Free(alloc, file);
+}
+
+static int onnx_model_create(const char* path, const void* buf, size_t size,
+                             int device, OnnxModel** out) {
+    OnnxModel* m = (OnnxModel*)calloc(1, sizeof(OnnxModel));
+    if (!m) return -1;
+
+    m->cfg = path ? neuron_shim_config_model(g_cfg, path) : NULL;
+    if (path) snprintf(m->path, sizeof(m->path), "%s", path);
+    pthread_mutex_init(&m->lock, NULL);
+
+    char tune_file[1024] = "";
+    bool tune_ep, tune_threads;
+    bool tune = onnx_tune_prepare(m, path, buf, size, tune_file, sizeof(tune_file),
+                                  &tune_ep, &tune_threads);
+    char profile[1100];
+    const char* prof = onnx_profile_prefix(m, tune, profile, sizeof(profile));
+
+    bool want_graph = m->cfg && m->cfg->cuda_graph;
+    m->cuda_graph = want_graph;
+    m->session = onnx_session_create(path, buf, size, m->cfg, device,
+                                     &m->pinned_name, &m->mapping, &m->cuda_graph,
+                                     m->eps, prof);
+    if (!m->session && want_graph) {
+        /* Most likely nodes the CUDA EP can't run (see the error) */
+        SHIM_WARN("onnx", "WARNING: CUDA graph refused for %s, loading without it",
+                  m->path);
+        m->cuda_graph = false;
+        m->session = onnx_session_create(path, buf, size, m->cfg, device,
+                                         &m->pinned_name, &m->mapping, &m->cuda_graph,
+                                         m->eps, prof);
+    }
+    if (!m->session) {
+        pthread_mutex_destroy(&m->lock);
+        free(m);
+        return -1;
+    }
+    m->home_device = device;
+    m->device_sessions[device] = m->session;
+    m->gpu = m->pinned_name != NULL;
+    if (prof) m->profile_left = neuron_shim_profile_runs(g_cfg, m->cfg);
+
+    if (populate_tensor_info(m) != 0) {
+        onnx_model_release(m);
+        return -1;
+    }
+    if (tune)
+        onnx_autotune(m, path, buf, size, device, m->eps, tune_ep, tune_threads,
+                      tune_file);
+
+    if (want_graph && !m->cuda_graph) {
+        SHIM_WARN("onnx", "WARNING: CUDA graph needs the CUDA EP; %s runs without it",
+                  m->path);
+    } else if (m->cuda_graph && !onnx_graph_shapes_fixed(m)) {
+        SHIM_WARN("onnx", "WARNING: CUDA graph refused for %s: dynamic shapes",
+                  m->path);
+        bool graph = false;
+        OrtSession* session = onnx_session_create(path, buf, size, m->cfg, device,
+                                                  &m->pinned_name, NULL, &graph, NULL,
+                                                  prof);
+        if (!session) {
+            onnx_model_release(m);
+            return -1;
+        }
+        if (prof) onnx_profile_end(m->session, false);
+        g_ort->ReleaseSession(m->session);
+        m->session = m->device_sessions[device] = session;
+        m->cuda_graph = false;
+    }
+
+    if (m->cfg && m->cfg->batch_window_us > 0) {
+        if (onnx_batchable(m)) {
+            m->batch_window_us = m->cfg->batch_window_us;
+            m->max_batch = m->cfg->max_batch > 0 && m->cfg->max_batch < NEURON_SHIM_MAX_BATCH
+                         ? m->cfg->max_batch : NEURON_SHIM_MAX_BATCH;
+            SHIM_INFO("onnx", "micro-batching up to %d runs within %d us",
+                      m->max_batch, m->batch_window_us);
+        } else {
+            SHIM_WARN("onnx", "WARNING: %s has a fixed batch dim, "
+                      "batch_window_us ignored", m->path);
+        }
+    }
+
+    /* The EP has loaded its GPU runtime by now: from here on APU
+     * buffers can come from its pinned host allocator */
+    if (m->pinned_name && g_cfg->pinned_memory) {
+        NeuronShimMemKind kind = strcmp(m->pinned_name, "CudaPinned") == 0
+                               ? NEURON_SHIM_MEM_CUDA : NEURON_SHIM_MEM_HIP;
+        if (neuron_shim_mem_enable_pinned(kind) != 0) m->pinned_name = NULL;
+    }
+
+    *out = m;
+    return 0;
+}
+
+static int onnx_model_load(const char* path, void** model) {
+    if (!g_env) return -1;
+
+    SHIM_INFO("onnx", "loading: %s", path);
+    return onnx_model_create(path, NULL, 0, g_home_device, (OnnxModel**)model);
+}
+
+static void onnx_model_release(void* model) {
+    OnnxModel* m = (OnnxModel*)model;
+    if (!m) return;
+
+    /* Unloaded before its profiled runs were done: keep what there is */
+    if (atomic_load(&m->profile_left) > 0) onnx_profile_end(m->session, true);
+
+    for (int d = 0; d < MAX_DEVICES; d++) {
+        onnx_graph_free(m->graphs[d]);   /* holds the session's allocator */
+        onnx_batcher_free(m->batchers[d]);
+        if (m->device_sessions[d]) g_ort->ReleaseSession(m->device_sessions[d]);
+    }
+    if (m->mapping.addr) munmap(m->mapping.addr, m->mapping.size);
+    pthread_mutex_destroy(&m->lock);
+    free(m);
+}
+
+/* The model's session on 'device', built on first use. CPU-only models
+ * have one session for everybody. */
+static OrtSession* onnx_model_session(OnnxModel* m, int device) {
+    if (!m->gpu || device == m->home_device) return m->session;
+
+    pthread_mutex_lock(&m->lock);
+    if (!m->device_sessions[device] && m->path[0]) {
+        const char* pinned = NULL;
+        bool        graph  = m->cuda_graph;
+        SHIM_INFO("onnx", "building session on GPU %d: %s", device, m->path);
+        m->device_sessions[device] =
+            onnx_session_create(m->path, NULL, 0, m->cfg, device, &pinned, NULL,
+                                &graph, NULL, NULL);
+    }
+    OrtSession* s = m->device_sessions[device];
+    pthread_mutex_unlock(&m->lock);
+    return s;
+}
+
+static int onnx_bind_input(OnnxContext* c, size_t index);
+static int onnx_bind_output(OnnxContext* c, size_t index);
+
+static int onnx_attach(void* ctx, void* model) {
     OnnxContext* c = (OnnxContext*)ctx;
+    if (c->model) return -1;  /* contexts bind to exactly one model */
+
+    OnnxModel* m = (OnnxModel*)model;
+    onnx_context_place(c);
+    c->session = onnx_model_session(m, c->device);
+    if (!c->session) {
+        SHIM_ERR("onnx", "no session for GPU %d", c->device);
+        return -1;
+    }
+    ORT_CHECK(c->api, c->api->CreateIoBinding(c->session, &c->io_binding));
+    c->model = m;
+    c->profile_left = neuron_shim_profile_runs(g_cfg, m->cfg);
+    if (m->gpu && g_device_count > 1)
+        SHIM_INFO("onnx", "runtime placed on GPU %d", c->device);
+
+    if (m->pinned_name) {
+        OrtStatus* s = c->api->CreateMemoryInfo(m->pinned_name, OrtDeviceAllocator,
+                                                0, OrtMemTypeCPUOutput,
+                                                &c->pinned_info);
+        if (s) {
+            SHIM_WARN("onnx", "WARNING: %s memory info: %s; binding pinned "
+                      "buffers as pageable", m->pinned_name,
+                      c->api->GetErrorMessage(s));
+            c->api->ReleaseStatus(s);
+            c->pinned_info = NULL;
+        }
+    }
 
-    fprintf(stderr, "[neuron-shim][onnx] loading: %s\n", path);
+    /* Graph replay needs its device buffers where they were captured */
+    if (g_cfg->arena_shrinkage) {
+        char arenas[32];
+        if (m->gpu && !m->cuda_graph)
+            snprintf(arenas, sizeof(arenas), "cpu:0;gpu:%d", c->device);
+        else
+            snprintf(arenas, sizeof(arenas), "cpu:0");
+        ORT_CHECK(c->api, c->api->AddRunConfigEntry(c->run_options,
+            "memory.enable_memory_arena_shrinkage", arenas));
+    }
 
-    ORT_CHECK(c->api,
-        c->api->CreateSession(c->env, path, c->session_opts, &c->session));
+    if (m->batch_window_us > 0) {
+        c->batcher = onnx_model_batcher(m, c->device);
+        if (c->batcher) atomic_fetch_add(&c->batcher->users, 1);
+    }
+
+    /* Graph mode: I/O goes through the session's fixed device tensors */
+    if (m->cuda_graph) {
+        c->graph = onnx_model_graph(m, c->session, c->device);
+        if (!c->graph) return -1;
+        return 0;
+    }
+
+    /* Pick up buffers the app bound before loading */
+    for (size_t i = 0; i < m->input_count; i++)
+        if (onnx_bind_input(c, i) != 0) return -1;
 
-    return populate_tensor_info(c);
+    /* Binds every output once, in model order, which also fixes the
+     * order GetBoundOutputValues() returns them in */
+    for (size_t i = 0; i < m->output_count; i++)
+        if (onnx_bind_output(c, i) != 0) return -1;
+
+    return 0;
 }
 
-static int onnx_load_from_buffer(void* ctx, const void* buf, size_t size) {
+static int onnx_load_from_file(void* ctx, const char* path) {
     OnnxContext* c = (OnnxContext*)ctx;
+    if (c->model) return -1;
 
-    fprintf(stderr, "[neuron-shim][onnx] loading from buffer: %zu bytes\n", size);
+    void* model;
+    if (onnx_model_load(path, &model) != 0) return -1;
+    c->owned = (OnnxModel*)model;
+    return onnx_attach(c, model);
+}
 
-    ORT_CHECK(c->api,
-        c->api->CreateSessionFromArray(c->env, buf, size,
-                                        c->session_opts, &c->session));
+static int onnx_load_from_buffer(void* ctx, const void* buf, size_t size) {
+    OnnxContext* c = (OnnxContext*)ctx;
+    if (c->model) return -1;
+
+    SHIM_INFO("onnx", "loading from buffer: %zu bytes", size);
 
-    return populate_tensor_info(c);
+    OnnxModel* m;
+    onnx_context_place(c);
+    if (onnx_model_create(NULL, buf, size, c->device, &m) != 0) return -1;
+    c->owned = m;
+    return onnx_attach(c, m);
 }
 
 /* ------------------------------------------------------------------ */
@@ -383,136 +1905,729 @@ static int onnx_load_from_buffer(void* ctx, const void* buf, size_t size) {
 /* ------------------------------------------------------------------ */
 static int onnx_get_input_count(void* ctx, uint32_t* count) {
     OnnxContext* c = (OnnxContext*)ctx;
-    *count = (uint32_t)c->input_count;
+    if (!c->model) return -1;
+    *count = (uint32_t)c->model->input_count;
     return 0;
 }
 
 static int onnx_get_output_count(void* ctx, uint32_t* count) {
     OnnxContext* c = (OnnxContext*)ctx;
-    *count = (uint32_t)c->output_count;
+    if (!c->model) return -1;
+    *count = (uint32_t)c->model->output_count;
     return 0;
 }
 
+/*
+ * Dynamic tensors report the shape they currently have: inputs the one
+ * inferred for the bound buffer, outputs the one the last run with the
+ * same input shapes produced. Before that, the defaults.
+ */
+static const int64_t* onnx_input_shape(const OnnxContext* c, size_t index) {
+    const InputValue* v = c->input_bindings[index].bound;
+    if (v && c->model->inputs[index].dynamic) return v->shape;
+    return c->model->inputs[index].default_shape;
+}
+
+static const ShapeState* onnx_known_state(const OnnxContext* c) {
+    return c->shape && c->shape->known ? c->shape : NULL;
+}
+
 static int onnx_get_input_size(void* ctx, int index, size_t* size) {
     OnnxContext* c = (OnnxContext*)ctx;
-    if ((size_t)index >= c->input_count) return -1;
-    *size = c->inputs[index].size;
+    if (!c->model || (size_t)index >= c->model->input_count) return -1;
+    *size = compute_tensor_size(onnx_input_shape(c, (size_t)index),
+                                c->model->inputs[index].num_dims,
+                                c->model->inputs[index].type);
     return 0;
 }
 
 static int onnx_get_output_size(void* ctx, int index, size_t* size) {
     OnnxContext* c = (OnnxContext*)ctx;
-    if ((size_t)index >= c->output_count) return -1;
-    *size = c->outputs[index].size;
+    if (!c->model || (size_t)index >= c->model->output_count) return -1;
+    const ShapeState* st = onnx_known_state(c);
+    *size = st ? st->size[index] : c->model->outputs[index].size;
+    return 0;
+}
+
+/* Quantization lives in QDQ nodes, not in ONNX tensor types */
+static void onnx_fill_desc(ShimTensorDesc* d, const int64_t* shape,
+                           size_t num_dims, ONNXTensorElementDataType type,
+                           size_t size) {
+    memset(d, 0, sizeof(*d));
+    d->rank = num_dims < 8 ? (uint32_t)num_dims : 8;
+    for (uint32_t i = 0; i < d->rank; i++)
+        d->dims[i] = shape[i] > 0 ? (uint32_t)shape[i] : 0;   /* 0 = dynamic */
+    d->type = ort_shim_type(type);
+    d->size = size;
+}
+
+static int onnx_get_input_info(void* ctx, int index, ShimTensorDesc* desc) {
+    OnnxContext* c = (OnnxContext*)ctx;
+    if (!c->model || (size_t)index >= c->model->input_count) return -1;
+    size_t size;
+    onnx_get_input_size(ctx, index, &size);
+    onnx_fill_desc(desc, onnx_input_shape(c, (size_t)index),
+                   c->model->inputs[index].num_dims,
+                   c->model->inputs[index].type, size);
+    return 0;
+}
+
+static int onnx_get_output_info(void* ctx, int index, ShimTensorDesc* desc) {
+    OnnxContext* c = (OnnxContext*)ctx;
+    if (!c->model || (size_t)index >= c->model->output_count) return -1;
+    const ShapeState* st = onnx_known_state(c);
+    onnx_fill_desc(desc, st ? st->shape[index] : c->model->outputs[index].shape,
+                   c->model->outputs[index].num_dims,
+                   c->model->outputs[index].type,
+                   st ? st->size[index] : c->model->outputs[index].size);
     return 0;
 }
 
 /* ------------------------------------------------------------------ */
 /* I/O binding                                                         */
 /* ------------------------------------------------------------------ */
+/*
+ * Memory info to wrap an app buffer with: buffers from the pinned shim
+ * allocator are described as the EP's pinned memory, so ORT copies them
+ * to the device asynchronously instead of staging them.
+ */
+static const OrtMemoryInfo* onnx_mem_info(const OnnxContext* c,
+                                          const void* buf, size_t size) {
+    if (c->pinned_info && neuron_shim_mem_kind(buf, size) > NEURON_SHIM_MEM_PAGEABLE)
+        return c->pinned_info;
+    return c->memory_info;
+}
+
+/* Bind the app's buffer for input 'index', wrapping it on a cache miss */
+static int onnx_bind_input(OnnxContext* c, size_t index) {
+    OnnxModel* m = c->model;
+    if (index >= m->input_count || c->graph) return 0;
+
+    const void* buf  = c->input_bindings[index].buf;
+    size_t      size = c->input_bindings[index].size;
+    if (!buf) return 0;
+
+    InputValue* cache = c->input_bindings[index].cache;
+    InputValue* v = NULL;
+    for (size_t k = 0; k < VALUE_CACHE && !v; k++)
+        if (cache[k].value && cache[k].buf == buf && cache[k].size == size)
+            v = &cache[k];
+
+    if (!v) {
+        int64_t shape[8];
+        if (!m->inputs[index].dynamic) {
+            memcpy(shape, m->inputs[index].shape, sizeof(shape));
+        } else if (onnx_infer_shape(m, index, size, shape) != 0) {
+            SHIM_ERR("onnx", "input[%zu] '%s': no shape fits %zu bytes; "
+                     "add an input_shape.%zu hint to the model's [model] section",
+                     index, m->inputs[index].name, size, index);
+            return -1;
+        }
+
+        /* Evict the least recently used wrapper (IoBinding keeps its
+         * own reference if it was the bound one) */
+        v = &cache[0];
+        for (size_t k = 0; k < VALUE_CACHE; k++) {
+            if (!cache[k].value) { v = &cache[k]; break; }
+            if (cache[k].used < v->used) v = &cache[k];
+        }
+        if (v->value) c->api->ReleaseValue(v->value);
+        if (c->input_bindings[index].bound == v)
+            c->input_bindings[index].bound = NULL;
+        memset(v, 0, sizeof(*v));
+
+        ORT_CHECK(c->api,
+            c->api->CreateTensorWithDataAsOrtValue(
+                onnx_mem_info(c, buf, size), (void*)buf, size, shape,
+                m->inputs[index].num_dims, m->inputs[index].type, &v->value));
+        v->buf  = buf;
+        v->size = size;
+        memcpy(v->shape, shape, sizeof(shape));
+    }
+
+    v->used = ++c->tick;
+    if (c->input_bindings[index].bound == v) return 0;
+
+    ORT_CHECK(c->api,
+        c->api->BindInput(c->io_binding, m->inputs[index].name, v->value));
+    c->input_bindings[index].bound = v;
+    return 0;
+}
+
 static int onnx_set_input(void* ctx, int index, const void* buf, size_t size) {
     OnnxContext* c = (OnnxContext*)ctx;
     if ((size_t)index >= MAX_TENSORS) return -1;
+
     c->input_bindings[index].buf  = buf;
     c->input_bindings[index].size = size;
+    return c->model ? onnx_bind_input(c, (size_t)index) : 0;
+}
+
+/* (Re)bind output 'index' to the IoBinding — see OnnxContext */
+static int onnx_bind_output(OnnxContext* c, size_t index) {
+    OnnxModel* m = c->model;
+    if (index >= m->output_count || c->graph) return 0;
+
+    if (c->output_bindings[index].value) {
+        c->api->ReleaseValue(c->output_bindings[index].value);
+        c->output_bindings[index].value = NULL;
+    }
+
+    void*  buf  = c->output_bindings[index].buf;
+    size_t size = c->output_bindings[index].size;
+
+    if (buf && !m->outputs[index].dynamic && size >= m->outputs[index].size) {
+        ORT_CHECK(c->api,
+            c->api->CreateTensorWithDataAsOrtValue(
+                onnx_mem_info(c, buf, m->outputs[index].size),
+                buf, m->outputs[index].size,
+                m->outputs[index].shape, m->outputs[index].num_dims,
+                m->outputs[index].type, &c->output_bindings[index].value));
+        ORT_CHECK(c->api,
+            c->api->BindOutput(c->io_binding, m->outputs[index].name,
+                               c->output_bindings[index].value));
+    } else {
+        ORT_CHECK(c->api,
+            c->api->BindOutputToDevice(c->io_binding, m->outputs[index].name,
+                                       c->memory_info));
+    }
     return 0;
 }
 
 static int onnx_set_output(void* ctx, int index, void* buf, size_t size) {
     OnnxContext* c = (OnnxContext*)ctx;
     if ((size_t)index >= MAX_TENSORS) return -1;
+
+    if (c->output_bindings[index].value &&
+        c->output_bindings[index].buf  == buf &&
+        c->output_bindings[index].size == size)
+        return 0;
+
     c->output_bindings[index].buf  = buf;
     c->output_bindings[index].size = size;
-    return 0;
+
+    /* Before a model is attached, attach() does the binding */
+    return c->model ? onnx_bind_output(c, (size_t)index) : 0;
 }
 
 /* ------------------------------------------------------------------ */
-/* Inference                                                           */
+/* Per-shape output state                                              */
 /* ------------------------------------------------------------------ */
-static int onnx_invoke(void* ctx) {
-    OnnxContext* c = (OnnxContext*)ctx;
-    if (!c->session) return -1;
+static uint64_t onnx_shape_key(const OnnxContext* c) {
+    uint64_t h = 1469598103934665603ull;          /* FNV-1a */
+    for (size_t i = 0; i < c->model->input_count; i++) {
+        const InputValue* v = c->input_bindings[i].bound;
+        for (size_t d = 0; d < c->model->inputs[i].num_dims; d++)
+            h = (h ^ (uint64_t)v->shape[d]) * 1099511628211ull;
+    }
+    return h;
+}
+
+/* State for the bound input shapes, recycling the LRU entry on a miss */
+static ShapeState* onnx_shape_state(OnnxContext* c) {
+    uint64_t    key    = onnx_shape_key(c);
+    ShapeState* victim = &c->shapes[0];
+
+    for (size_t k = 0; k < SHAPE_CACHE; k++) {
+        ShapeState* st = &c->shapes[k];
+        if (st->valid && st->key == key) {
+            st->used = ++c->tick;
+            return st;
+        }
+        if (!st->valid || (victim->valid && st->used < victim->used))
+            victim = st;
+    }
+
+    for (size_t i = 0; i < MAX_TENSORS; i++)
+        if (victim->value[i]) c->api->ReleaseValue(victim->value[i]);
+    memset(victim, 0, sizeof(*victim));
+    victim->valid = true;
+    victim->key   = key;
+    victim->used  = ++c->tick;
+    return victim;
+}
+
+/* Zero-copy binding of a dynamic output at its learned shape */
+static OrtStatus* onnx_bind_learned(OnnxContext* c, ShapeState* st, size_t i) {
+    OnnxModel* m   = c->model;
+    void*      buf = c->output_bindings[i].buf;
+    OrtStatus* s   = NULL;
+
+    if (!st->value[i] || st->value_buf[i] != buf) {
+        if (st->value[i]) c->api->ReleaseValue(st->value[i]);
+        st->value[i] = NULL;
+        s = c->api->CreateTensorWithDataAsOrtValue(
+                onnx_mem_info(c, buf, st->size[i]), buf, st->size[i], st->shape[i],
+                m->outputs[i].num_dims, m->outputs[i].type, &st->value[i]);
+        if (s) return s;
+        st->value_buf[i] = buf;
+    }
+    return c->api->BindOutput(c->io_binding, m->outputs[i].name, st->value[i]);
+}
+
+/* One Run() over every member's inputs, concatenated along dim 0 */
+static OrtStatus* onnx_run_batch(const OnnxBatch* b) {
+    OnnxContext* c0 = b->members[0];
+    OnnxModel*   m  = c0->model;
+    OrtValue*    in[MAX_TENSORS]  = { NULL };
+    OrtValue*    out[MAX_TENSORS] = { NULL };
+    const char*  in_names[MAX_TENSORS];
+    const char*  out_names[MAX_TENSORS];
+
+    OrtAllocator* allocator;
+    OrtStatus* s = g_ort->GetAllocatorWithDefaultOptions(&allocator);
+
+    for (size_t i = 0; !s && i < m->input_count; i++) {
+        const InputValue* v = c0->input_bindings[i].bound;
+        int64_t shape[8];
+        memcpy(shape, v->shape, sizeof(shape));
+        size_t per = compute_tensor_size(shape, m->inputs[i].num_dims,
+                                         m->inputs[i].type);
+        shape[0] *= b->count;
+
+        void* dst;
+        in_names[i] = m->inputs[i].name;
+        s = g_ort->CreateTensorAsOrtValue(allocator, shape, m->inputs[i].num_dims,
+                                          m->inputs[i].type, &in[i]);
+        if (!s) s = g_ort->GetTensorMutableData(in[i], &dst);
+        for (int k = 0; !s && k < b->count; k++)
+            memcpy((char*)dst + (size_t)k * per,
+                   b->members[k]->input_bindings[i].bound->buf, per);
+    }
+    for (size_t i = 0; i < m->output_count; i++)
+        out_names[i] = m->outputs[i].name;
+
+    if (!s) s = g_ort->RunOptionsUnsetTerminate(c0->run_options);
+    if (!s) {
+        atomic_fetch_add(&g_devices[c0->device].inflight, 1);
+        s = g_ort->Run(c0->session, c0->run_options, in_names,
+                       (const OrtValue* const*)in, m->input_count,
+                       out_names, m->output_count, out);
+        atomic_fetch_sub(&g_devices[c0->device].inflight, 1);
+    }
+
+    /* Member k's results are the k-th equal slice of each output */
+    int64_t shape[MAX_TENSORS][8] = { { 0 } };
+    size_t  size[MAX_TENSORS]     = { 0 };
+    bool    learn = m->dynamic_outputs;
+    for (size_t i = 0; !s && i < m->output_count; i++) {
+        OrtTensorTypeAndShapeInfo* info;
+        size_t elements = 0, rank = 0;
+        void*  data;
+        s = g_ort->GetTensorMutableData(out[i], &data);
+        if (!s) s = g_ort->GetTensorTypeAndShape(out[i], &info);
+        if (s) break;
+        s = g_ort->GetTensorShapeElementCount(info, &elements);
+        if (!s && learn) s = g_ort->GetDimensionsCount(info, &rank);
+        if (!s && learn && rank == m->outputs[i].num_dims && rank > 0)
+            s = g_ort->GetDimensions(info, shape[i], rank);
+        else if (learn)
+            learn = false;
+        g_ort->ReleaseTensorTypeAndShapeInfo(info);
+        if (s) break;
+
+        size_t per = elements * ort_element_size(m->outputs[i].type) / (size_t)b->count;
+        if (learn) {
+            shape[i][0] /= b->count;
+            size[i] = per;
+        }
+        for (int k = 0; !s && k < b->count; k++) {
+            OnnxContext* c = b->members[k];
+            if (!c->output_bindings[i].buf) continue;
+            size_t n = c->output_bindings[i].size < per ? c->output_bindings[i].size : per;
+            memcpy(c->output_bindings[i].buf, (char*)data + (size_t)k * per, n);
+        }
+    }
 
     /*
-     * Build input tensors from bound buffers.
-     * ORT wants arrays of names and OrtValue pointers.
+     * Each member's output shapes are the batch's with dim 0 split.
+     * Members block until the batch is done, so their state is ours.
      */
-    const char*  input_names[MAX_TENSORS];
-    OrtValue*    input_tensors[MAX_TENSORS];
+    for (int k = 0; !s && m->dynamic_outputs && k < b->count; k++) {
+        OnnxContext* c  = b->members[k];
+        ShapeState*  st = onnx_shape_state(c);
+        if (learn && !st->known) {
+            memcpy(st->shape, shape, sizeof(shape));
+            memcpy(st->size, size, sizeof(size));
+            st->known = true;
+        }
+        c->shape = st;
+    }
 
-    for (size_t i = 0; i < c->input_count; i++) {
-        input_names[i] = c->inputs[i].name;
+    for (size_t i = 0; i < MAX_TENSORS; i++) {
+        if (in[i])  g_ort->ReleaseValue(in[i]);
+        if (out[i]) g_ort->ReleaseValue(out[i]);
+    }
+    return s;
+}
 
-        ORT_CHECK(c->api,
-            c->api->CreateTensorWithDataAsOrtValue(
-                c->memory_info,
-                (void*)c->input_bindings[i].buf,
-                c->input_bindings[i].size,
-                c->inputs[i].shape,
-                c->inputs[i].num_dims,
-                c->inputs[i].type,
-                &input_tensors[i]));
+/*
+ * Join the batch collecting for these input shapes, or open one and
+ * lead it. @return the inference result, or BATCH_ALONE if the caller
+ * should run by itself (nobody joined, or another shape is collecting)
+ */
+static int onnx_invoke_batched(OnnxContext* c) {
+    OnnxBatcher* q   = c->batcher;
+    OnnxModel*   m   = c->model;
+    uint64_t     key = onnx_shape_key(c);
+
+    pthread_mutex_lock(&q->lock);
+    OnnxBatch* open = q->open;
+    if (open) {
+        if (open->key != key || open->count == open->limit) {
+            pthread_mutex_unlock(&q->lock);
+            return BATCH_ALONE;
+        }
+        open->members[open->count++] = c;
+        c->batch_done = false;
+        if (open->count == open->limit) pthread_cond_broadcast(&q->cond);
+        while (!c->batch_done) pthread_cond_wait(&q->cond, &q->lock);
+        int rc = c->batch_rc;
+        pthread_mutex_unlock(&q->lock);
+        return rc;
     }
 
-    /* Prepare output names */
-    const char*  output_names[MAX_TENSORS];
-    OrtValue*    output_tensors[MAX_TENSORS];
+    OnnxBatch b = { .members = { c }, .count = 1, .key = key };
+    b.limit = atomic_load(&q->users);
+    if (b.limit > m->max_batch) b.limit = m->max_batch;
+    q->open = &b;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_nsec += (long)m->batch_window_us * 1000;
+    deadline.tv_sec  += deadline.tv_nsec / 1000000000L;
+    deadline.tv_nsec %= 1000000000L;
+    while (b.count < b.limit &&
+           pthread_cond_timedwait(&q->cond, &q->lock, &deadline) != ETIMEDOUT)
+        ;
+    q->open = NULL;   /* later arrivals start the next batch */
+    pthread_mutex_unlock(&q->lock);
+    if (b.count == 1) return BATCH_ALONE;
+
+    int rc = 0;
+    OrtStatus* s = onnx_run_batch(&b);
+    if (s) {
+        SHIM_ERR("onnx", "batch of %d: %s", b.count, g_ort->GetErrorMessage(s));
+        g_ort->ReleaseStatus(s);
+        rc = -1;
+    }
 
-    for (size_t i = 0; i < c->output_count; i++) {
-        output_names[i] = c->outputs[i].name;
-        output_tensors[i] = NULL; /* ORT allocates these */
+    pthread_mutex_lock(&q->lock);
+    for (int k = 1; k < b.count; k++) {
+        b.members[k]->batch_rc   = rc;
+        b.members[k]->batch_done = true;
     }
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+    return rc;
+}
+
+/* ------------------------------------------------------------------ */
+/* Inference                                                           */
+/* ------------------------------------------------------------------ */
+/*
+ * Graph mode: copy the app's inputs into the session's device tensors,
+ * replay, copy the outputs back. Runtimes sharing the session share the
+ * tensors, so the whole sequence holds the graph's lock.
+ */
+static int onnx_invoke_graph(OnnxContext* c) {
+    OnnxModel* m = c->model;
+    OnnxGraph* g = c->graph;
+
+    for (size_t i = 0; i < m->input_count; i++) {
+        if (!c->input_bindings[i].buf) {
+            SHIM_ERR("onnx", "input[%zu] not set", i);
+            return -1;
+        }
+        if (c->input_bindings[i].size < m->inputs[i].size) {
+            SHIM_ERR("onnx", "input[%zu]: %zu bytes, model wants %zu", i,
+                     c->input_bindings[i].size, m->inputs[i].size);
+            return -1;
+        }
+    }
+
+    bool prof = c->profile_left > 0;
+    pthread_mutex_lock(&g->lock);
+    uint64_t t0 = prof ? neuron_shim_now_ns() : 0;
+    int rc = g_cudart.set_device(c->device);
+    for (size_t i = 0; !rc && i < m->input_count; i++)
+        rc = g_cudart.memcpy(g->input_ptr[i], c->input_bindings[i].buf,
+                             m->inputs[i].size, CUDA_MEMCPY_DEFAULT);
+    /* Copies from pageable memory may still be in flight, and ORT's
+     * stream doesn't wait for the legacy stream */
+    if (!rc) rc = g_cudart.stream_synchronize(NULL);
+    if (prof)
+        neuron_shim_profile_span("onnx", "copy in", t0, neuron_shim_now_ns(),
+                                 "\"to\":\"gpu:%d\"", c->device);
+
+    OrtStatus* s = NULL;
+    if (!rc) {
+        s = c->api->RunOptionsUnsetTerminate(c->run_options);
+        atomic_fetch_add(&g_devices[c->device].inflight, 1);
+        if (!s) s = c->api->RunWithBinding(c->session, c->run_options, g->binding);
+        atomic_fetch_sub(&g_devices[c->device].inflight, 1);
+    }
+
+    /* Run() has synchronized ORT's stream; these copies are blocking */
+    if (prof) t0 = neuron_shim_now_ns();
+    for (size_t i = 0; !rc && !s && i < m->output_count; i++) {
+        if (!c->output_bindings[i].buf) continue;
+        size_t n = c->output_bindings[i].size;
+        if (n > m->outputs[i].size) n = m->outputs[i].size;
+        rc = g_cudart.memcpy(c->output_bindings[i].buf, g->output_ptr[i], n,
+                             CUDA_MEMCPY_DEFAULT);
+    }
+    if (prof)
+        neuron_shim_profile_span("onnx", "copy out", t0, neuron_shim_now_ns(),
+                                 "\"from\":\"gpu:%d\"", c->device);
+    pthread_mutex_unlock(&g->lock);
+
+    if (s) {
+        SHIM_ERR("onnx", "ERROR: %s", c->api->GetErrorMessage(s));
+        c->api->ReleaseStatus(s);
+        return -1;
+    }
+    if (rc) {
+        SHIM_ERR("onnx", "CUDA graph: cudart error %d", rc);
+        return -1;
+    }
+    return 0;
+}
+
+static int onnx_invoke_bound(OnnxContext* c) {
+    OnnxModel* m = c->model;
+
+    /* Inputs were wrapped and bound by onnx_set_input() */
+    for (size_t i = 0; i < m->input_count; i++) {
+        if (!c->input_bindings[i].bound) {
+            SHIM_ERR("onnx", "input[%zu] not set", i);
+            return -1;
+        }
+    }
+
+    if (c->batcher && atomic_load(&c->batcher->users) > 1) {
+        int rc = onnx_invoke_batched(c);
+        if (rc != BATCH_ALONE) return rc;
+    }
+
+    int ret = 0;
+    bool need_copy = false;
+    OrtStatus* s = NULL;
+
+    /*
+     * Dynamic outputs: once a run with these input shapes has shown the
+     * output shapes, outputs whose buffer is big enough go zero-copy.
+     * Everything else gets a fresh ORT allocation and a copy, and the
+     * first run per input shape reads the shapes back to learn them.
+     */
+    ShapeState* st = m->dynamic_outputs ? onnx_shape_state(c) : NULL;
+    bool direct[MAX_TENSORS] = { false };
+    c->shape = st;
+    if (st && !st->known) need_copy = true;
+
+    for (size_t i = 0; i < m->output_count && !s; i++) {
+        if (c->output_bindings[i].value) {
+            direct[i] = true;
+            continue;
+        }
+        if (st && st->known && c->output_bindings[i].buf &&
+            c->output_bindings[i].size >= st->size[i]) {
+            s = onnx_bind_learned(c, st, i);
+            direct[i] = true;
+            continue;
+        }
+        s = c->api->BindOutputToDevice(c->io_binding, m->outputs[i].name,
+                                       c->memory_info);
+        if (c->output_bindings[i].buf) need_copy = true;
+    }
+
+    /* Clear a terminate flag left over from an abort() that raced the
+     * end of the previous run */
+    if (!s) s = c->api->RunOptionsUnsetTerminate(c->run_options);
+
+    /* Run inference — zero-copy outputs land in the user buffers */
+    if (!s) {
+        atomic_fetch_add(&g_devices[c->device].inflight, 1);
+        s = c->api->RunWithBinding(c->session, c->run_options, c->io_binding);
+        atomic_fetch_sub(&g_devices[c->device].inflight, 1);
+    }
+
+    if (!s && need_copy) {
+        OrtAllocator* allocator;
+        OrtValue**    values = NULL;
+        size_t        value_count = 0;
+        uint64_t      t0 = c->profile_left > 0 ? neuron_shim_now_ns() : 0;
+
+        s = c->api->GetAllocatorWithDefaultOptions(&allocator);
+        if (!s) s = c->api->GetBoundOutputValues(c->io_binding, allocator,
+                                                 &values, &value_count);
+
+        /* Learn output shapes and copy fallback outputs to user buffers */
+        bool learn = st && !st->known;
+        for (size_t i = 0; !s && i < value_count && i < m->output_count; i++) {
+            if (!learn && (direct[i] || !c->output_bindings[i].buf))
+                continue;
 
-    /* Run inference */
-    ORT_CHECK(c->api,
-        c->api->Run(c->session, NULL,
-                     input_names, (const OrtValue* const*)input_tensors,
-                     c->input_count,
-                     output_names, c->output_count,
-                     output_tensors));
-
-    /* Copy outputs to user buffers */
-    for (size_t i = 0; i < c->output_count; i++) {
-        if (output_tensors[i] && c->output_bindings[i].buf) {
             void* tensor_data;
-            ORT_CHECK(c->api,
-                c->api->GetTensorMutableData(output_tensors[i], &tensor_data));
+            OrtTensorTypeAndShapeInfo* info;
+            size_t elements, rank = 0;
+            s = c->api->GetTensorMutableData(values[i], &tensor_data);
+            if (!s) s = c->api->GetTensorTypeAndShape(values[i], &info);
+            if (s) break;
+            s = c->api->GetTensorShapeElementCount(info, &elements);
+            if (!s && learn) s = c->api->GetDimensionsCount(info, &rank);
+            if (!s && learn && rank == m->outputs[i].num_dims)
+                s = c->api->GetDimensions(info, st->shape[i], rank);
+            else if (learn)
+                learn = false;      /* rank changed: don't cache this shape */
+            c->api->ReleaseTensorTypeAndShapeInfo(info);
+            if (s) break;
+
+            size_t tensor_size = elements * ort_element_size(m->outputs[i].type);
+            if (learn) st->size[i] = tensor_size;
+            if (direct[i] || !c->output_bindings[i].buf) continue;
 
             size_t copy_size = c->output_bindings[i].size;
-            if (copy_size > c->outputs[i].size)
-                copy_size = c->outputs[i].size;
+            if (copy_size > tensor_size) copy_size = tensor_size;
 
             memcpy(c->output_bindings[i].buf, tensor_data, copy_size);
         }
+        if (!s && learn && value_count == m->output_count) st->known = true;
+
+        for (size_t i = 0; i < value_count; i++)
+            c->api->ReleaseValue(values[i]);
+        if (values) allocator->Free(allocator, values);
+        if (t0)
+            neuron_shim_profile_span("onnx", "copy out", t0, neuron_shim_now_ns(),
+                                     "\"learn_shapes\":%s", st ? "true" : "false");
+    }
+
+    if (s) {
+        SHIM_ERR("onnx", "ERROR: %s",
+                 c->api->GetErrorMessage(s));
+        c->api->ReleaseStatus(s);
+        ret = -1;
     }
 
-    /* Cleanup */
-    for (size_t i = 0; i < c->input_count; i++)
-        c->api->ReleaseValue(input_tensors[i]);
-    for (size_t i = 0; i < c->output_count; i++)
-        if (output_tensors[i]) c->api->ReleaseValue(output_tensors[i]);
+    return ret;
+}
 
+static int onnx_invoke(void* ctx) {
+    OnnxContext* c = (OnnxContext*)ctx;
+    OnnxModel*   m = c->model;
+    if (!m) return -1;
+    int ret = c->graph ? onnx_invoke_graph(c) : onnx_invoke_bound(c);
+
+    if (c->profile_left > 0) c->profile_left--;
+    if (c->session == m->session &&
+        atomic_load_explicit(&m->profile_left, memory_order_relaxed) > 0 &&
+        atomic_fetch_sub(&m->profile_left, 1) == 1)
+        onnx_profile_end(m->session, true);
+    return ret;
+}
+
+/* ------------------------------------------------------------------ */
+/* Memory accounting                                                   */
+/*                                                                     */
+/* InUse / MaxInUse of the session's arenas, from AllocatorGetStats    */
+/* (ORT 1.23+): its CPU allocator and, on a GPU EP, its device one.    */
+/* With the env's shared CPU arena (arena_* settings) the host figures */
+/* cover every session in the process.                                 */
+/* ------------------------------------------------------------------ */
+static int onnx_arena_stats(OrtSession* session, const OrtMemoryInfo* info,
+                            uint64_t* in_use, uint64_t* peak) {
+#if ORT_API_VERSION >= 23
+    OrtAllocator*     a  = NULL;
+    OrtKeyValuePairs* kv = NULL;
+    OrtStatus* s = g_ort->CreateAllocator(session, info, &a);
+    if (!s) s = g_ort->AllocatorGetStats(a, &kv);
+    if (a) g_ort->ReleaseAllocator(a);
+    if (s) {
+        g_ort->ReleaseStatus(s);   /* no arena there */
+        return -1;
+    }
+
+    const char* v = g_ort->GetKeyValue(kv, "InUse");
+    *in_use = v ? strtoull(v, NULL, 10) : 0;
+    v = g_ort->GetKeyValue(kv, "MaxInUse");
+    *peak = v ? strtoull(v, NULL, 10) : *in_use;
+    g_ort->ReleaseKeyValuePairs(kv);
+    return 0;
+#else
+    (void)session; (void)info; (void)in_use; (void)peak;
+    return -1;
+#endif
+}
+
+static int onnx_memory_usage(void* ctx, NeuronShimMemoryStats* out) {
+    OnnxContext* c = (OnnxContext*)ctx;
+    const OnnxModel* m = c->model;
+    if (!m || !c->session) return -1;
+
+    int rc = onnx_arena_stats(c->session, c->memory_info,
+                              &out->host_bytes, &out->host_peak);
+
+    /* The device arena is named after the EP's pinned memory, minus "Pinned" */
+    if (m->pinned_name) {
+        char name[32];
+        snprintf(name, sizeof(name), "%.*s",
+                 (int)(strlen(m->pinned_name) - strlen("Pinned")), m->pinned_name);
+        OrtMemoryInfo* info = NULL;
+        OrtStatus* s = g_ort->CreateMemoryInfo(name, OrtArenaAllocator, c->device,
+                                               OrtMemTypeDefault, &info);
+        if (!s) {
+            if (onnx_arena_stats(c->session, info, &out->device_bytes,
+                                 &out->device_peak) == 0)
+                rc = 0;
+            g_ort->ReleaseMemoryInfo(info);
+        } else {
+            g_ort->ReleaseStatus(s);
+        }
+    }
+    return rc;
+}
+
+static int onnx_providers(void* ctx, char* out, size_t len) {
+    OnnxContext* c = (OnnxContext*)ctx;
+    if (!c->model) return -1;
+    snprintf(out, len, "%s", c->model->eps);
     return 0;
 }
 
+static void onnx_abort(void* ctx) {
+    OnnxContext* c = (OnnxContext*)ctx;
+    OrtStatus* s = c->api->RunOptionsSetTerminate(c->run_options);
+    if (s) c->api->ReleaseStatus(s);
+}
+
 /* ------------------------------------------------------------------ */
 /* Backend vtable                                                      */
 /* ------------------------------------------------------------------ */
 static const NeuronShimBackend onnx_backend = {
     .name             = "onnx",
+    .init             = onnx_init,
     .create           = onnx_create,
     .destroy          = onnx_destroy,
     .load_from_file   = onnx_load_from_file,
     .load_from_buffer = onnx_load_from_buffer,
+    .model_load       = onnx_model_load,
+    .model_release    = onnx_model_release,
+    .attach           = onnx_attach,
     .get_input_count  = onnx_get_input_count,
     .get_output_count = onnx_get_output_count,
     .get_input_size   = onnx_get_input_size,
     .get_output_size  = onnx_get_output_size,
+    .get_input_info   = onnx_get_input_info,
+    .get_output_info  = onnx_get_output_info,
     .set_input        = onnx_set_input,
     .set_output       = onnx_set_output,
     .invoke           = onnx_invoke,
+    .abort            = onnx_abort,
+    .memory_usage     = onnx_memory_usage,
+    .providers        = onnx_providers,
 };
 
-const NeuronShimBackend* neuron_shim_backend_onnx(void) {
-    return &onnx_backend;
+/* Plugin entry point (see backend.h) */
+const NeuronShimBackend* neuron_shim_plugin_backend(uint32_t abi) {
+    return abi == NEURON_SHIM_BACKEND_ABI ? &onnx_backend : NULL;
 }
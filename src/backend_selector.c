@@ -2,23 +2,74 @@
  * neuron-shim: Backend selector
  */
 
+#define _GNU_SOURCE
 #include "backend.h"
+#include "log.h"
 
 #include <string.h>
 #include <stdio.h>
 #include <dlfcn.h>
+#include <unistd.h>
+
+/* dlopen 'file' and fetch its backend table; 'quiet' for probes */
+static const NeuronShimBackend* open_plugin(const char* file, bool quiet) {
+    void* handle = dlopen(file, RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        if (quiet) SHIM_DBG(NULL, "plugin %s: %s", file, dlerror());
+        else       SHIM_WARN(NULL, "WARNING: can't load plugin %s: %s", file, dlerror());
+        return NULL;
+    }
+
+    NeuronShimPluginFn entry = (NeuronShimPluginFn)dlsym(handle, NEURON_SHIM_PLUGIN_ENTRY);
+    const NeuronShimBackend* b = entry ? entry(NEURON_SHIM_BACKEND_ABI) : NULL;
+    if (!b) {
+        SHIM_WARN(NULL, "WARNING: %s is not a neuron-shim plugin for this "
+                  "version (ABI %d)", file, NEURON_SHIM_BACKEND_ABI);
+        dlclose(handle);
+        return NULL;
+    }
+
+    /* Backends live as long as the process: the handle is never closed */
+    SHIM_INFO(NULL, "backend %s: loaded from %s", b->name, file);
+    return b;
+}
+
+/* Missing runtimes are expected while auto-detecting, not otherwise */
+static const NeuronShimBackend* load_backend(const char* name, bool quiet) {
+    if (strcmp(name, "stub") == 0) return neuron_shim_backend_stub();
+
+    char file[1024 + 64];
+    const NeuronShimConfig* cfg = neuron_shim_config_get();
+    if (cfg->plugin_dir[0]) {
+        snprintf(file, sizeof(file), "%s/libneuronrt-%s.so", cfg->plugin_dir, name);
+        return open_plugin(file, quiet);
+    }
+
+    /* Next to the shim itself, as installed */
+    Dl_info info;
+    if (dladdr((void*)neuron_shim_load_backend, &info) && info.dli_fname) {
+        const char* slash = strrchr(info.dli_fname, '/');
+        if (slash) {
+            snprintf(file, sizeof(file), "%.*s/libneuronrt-%s.so",
+                     (int)(slash - info.dli_fname), info.dli_fname, name);
+            if (access(file, F_OK) == 0) return open_plugin(file, quiet);
+        }
+    }
+
+    snprintf(file, sizeof(file), "libneuronrt-%s.so", name);
+    return open_plugin(file, quiet);
+}
+
+const NeuronShimBackend* neuron_shim_load_backend(const char* name) {
+    return load_backend(name, false);
+}
 
 const NeuronShimBackend* neuron_shim_select_backend(const char* name) {
     /* Explicit selection */
     if (name) {
-#ifdef SHIM_HAS_ONNX
-        if (strcmp(name, "onnx") == 0) return neuron_shim_backend_onnx();
-#endif
-#ifdef SHIM_HAS_TFLITE
-        if (strcmp(name, "tflite") == 0) return neuron_shim_backend_tflite();
-#endif
-        if (strcmp(name, "stub") == 0)   return neuron_shim_backend_stub();
-        fprintf(stderr, "[neuron-shim] unknown backend '%s', falling back\n", name);
+        const NeuronShimBackend* b = load_backend(name, false);
+        if (b) return b;
+        SHIM_WARN(NULL, "backend '%s' unavailable, falling back", name);
     }
 
     /*
@@ -26,33 +77,19 @@ const NeuronShimBackend* neuron_shim_select_backend(const char* name) {
      *   1. ONNX Runtime (preferred — supports NVIDIA + AMD GPU)
      *   2. TFLite (CPU or mobile GPU)
      *   3. Stub (no-op fallback)
+     *
+     * A plugin only loads if its runtime library does, so loading it
+     * is the probe.
      */
-#ifdef SHIM_HAS_ONNX
-    {
-        void* handle = dlopen("libonnxruntime.so", RTLD_LAZY | RTLD_NOLOAD);
-        if (!handle)
-            handle = dlopen("libonnxruntime.so", RTLD_LAZY);
-        if (handle) {
-            dlclose(handle);
-            fprintf(stderr, "[neuron-shim] auto-selected: onnx\n");
-            return neuron_shim_backend_onnx();
-        }
-    }
-#endif
-
-#ifdef SHIM_HAS_TFLITE
-    {
-        void* handle = dlopen("libtensorflowlite_c.so", RTLD_LAZY | RTLD_NOLOAD);
-        if (!handle)
-            handle = dlopen("libtensorflowlite_c.so", RTLD_LAZY);
-        if (handle) {
-            dlclose(handle);
-            fprintf(stderr, "[neuron-shim] auto-selected: tflite\n");
-            return neuron_shim_backend_tflite();
+    static const char* const order[] = { "onnx", "tflite" };
+    for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+        const NeuronShimBackend* b = load_backend(order[i], true);
+        if (b) {
+            SHIM_INFO(NULL, "auto-selected: %s", order[i]);
+            return b;
         }
     }
-#endif
 
-    fprintf(stderr, "[neuron-shim] using stub backend\n");
+    SHIM_INFO(NULL, "using stub backend");
     return neuron_shim_backend_stub();
 }
@@ -9,6 +9,7 @@
  */
 
 #include "backend.h"
+#include "log.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -31,15 +32,15 @@ typedef struct {
 static int stub_create(void** ctx) {
     StubContext* c = (StubContext*)calloc(1, sizeof(StubContext));
     *ctx = c;
-    fprintf(stderr, "[neuron-shim][stub] backend created — all calls are no-ops\n");
+    SHIM_INFO("stub", "backend created — all calls are no-ops");
     return 0;
 }
 
 static void stub_destroy(void* ctx) {
     StubContext* c = (StubContext*)ctx;
     if (c) {
-        fprintf(stderr, "[neuron-shim][stub] stats: %d inferences on '%s'\n",
-                c->inference_count, c->model_path);
+        SHIM_INFO("stub", "stats: %d inferences on '%s'",
+                  c->inference_count, c->model_path);
     }
     free(c);
 }
@@ -47,7 +48,7 @@ static void stub_destroy(void* ctx) {
 static int stub_load_from_file(void* ctx, const char* path) {
     StubContext* c = (StubContext*)ctx;
     snprintf(c->model_path, sizeof(c->model_path), "%s", path);
-    fprintf(stderr, "[neuron-shim][stub] LOAD: %s\n", path);
+    SHIM_INFO("stub", "LOAD: %s", path);
     /* Default to 1 input, 1 output until we see actual calls */
     c->input_count = 1;
     c->output_count = 1;
@@ -57,7 +58,7 @@ static int stub_load_from_file(void* ctx, const char* path) {
 static int stub_load_from_buffer(void* ctx, const void* buf, size_t size) {
     StubContext* c = (StubContext*)ctx;
     snprintf(c->model_path, sizeof(c->model_path), "<buffer:%zu bytes>", size);
-    fprintf(stderr, "[neuron-shim][stub] LOAD from buffer: %zu bytes\n", size);
+    SHIM_INFO("stub", "LOAD from buffer: %zu bytes", size);
     c->input_count = 1;
     c->output_count = 1;
     return 0;
@@ -95,7 +96,7 @@ static int stub_set_input(void* ctx, int index, const void* buf, size_t size) {
         c->inputs[index].size = size;
         if (index >= c->input_count) c->input_count = index + 1;
     }
-    fprintf(stderr, "[neuron-shim][stub] SET_INPUT[%d]: %zu bytes\n", index, size);
+    SHIM_DBG("stub", "SET_INPUT[%d]: %zu bytes", index, size);
     return 0;
 }
 
@@ -106,7 +107,7 @@ static int stub_set_output(void* ctx, int index, void* buf, size_t size) {
         c->outputs[index].buf  = buf;
         if (index >= c->output_count) c->output_count = index + 1;
     }
-    fprintf(stderr, "[neuron-shim][stub] SET_OUTPUT[%d]: %zu bytes\n", index, size);
+    SHIM_DBG("stub", "SET_OUTPUT[%d]: %zu bytes", index, size);
     return 0;
 }
 
@@ -123,8 +124,8 @@ static int stub_invoke(void* ctx) {
     }
 
     if (c->inference_count <= 5 || (c->inference_count % 100) == 0) {
-        fprintf(stderr, "[neuron-shim][stub] INFERENCE #%d (outputs zeroed)\n",
-                c->inference_count);
+        SHIM_INFO("stub", "INFERENCE #%d (outputs zeroed)",
+                  c->inference_count);
     }
 
     return 0;
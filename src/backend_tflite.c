@@ -8,38 +8,354 @@
  * (uses the TFLite C API for maximum portability)
  */
 
+#include "RuntimeAPI.h"
+#include "autotune.h"
 #include "backend.h"
-
+#include "cpu_affinity.h"
+#include "log.h"
+#include "model_hash.h"
+#include "profile.h"
+#include "stats.h"
+
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 /* ------------------------------------------------------------------ */
 /* TFLite C API — we use the stable C interface, not C++               */
 /* This avoids ABI issues and works with any TFLite build.             */
 /* ------------------------------------------------------------------ */
 #include <tensorflow/lite/c/c_api.h>
+#include <tensorflow/lite/c/c_api_experimental.h>
 
 /* Optional: GPU delegate for acceleration */
 #ifdef NEURON_SHIM_ENABLE_GPU
 #include <tensorflow/lite/delegates/gpu/delegate.h>
 #endif
 
+/* Optional: explicitly configured XNNPACK delegate (CPU) */
+#ifdef NEURON_SHIM_ENABLE_XNNPACK
+#include <tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h>
+#endif
+
+/* Optional: per-op events for profile_file (TFLite >= 2.13) */
+#ifdef NEURON_SHIM_TFLITE_PROFILER
+#include <tensorflow/lite/profiling/telemetry/c/profiler.h>
+#endif
+
 #define MAX_TENSORS 32
 
+/* TFLite's kDefaultTensorAlignment — custom allocations must honor it */
+#define TENSOR_ALIGNMENT 64
+
+#define OP_DEPTH 8   /* nested op events, e.g. a delegate's kernels in its node */
+
+/*
+ * One app buffer bound to an input or output tensor.
+ *
+ * In zero-copy mode the tensor is pointed straight at 'buf' with a
+ * custom allocation ('direct'), so no copies happen at all. Buffers that
+ * are misaligned or too small fall back to copying. A tensor that was
+ * once mapped can't go back to the arena, so it is remapped onto an
+ * aligned 'staging' buffer owned by the context instead.
+ */
 typedef struct {
-    TfLiteModel*       model;
+    void*  buf;
+    size_t size;
+    void*  mapped;    /* what the tensor's custom allocation points at */
+    void*  staging;
+    bool   direct;    /* tensor data is 'buf' itself */
+} TFLiteBinding;
+
+/*
+ * The TfLiteModel (flatbuffer + weights) is read-only and may be shared
+ * by many contexts through the model cache; each context builds its own
+ * interpreter on top of it, since interpreters hold activations and are
+ * not thread-safe.
+ */
+typedef struct {
+    TfLiteModel* model;
+    char         path[1024];   /* source file, empty for buffer loads */
+    uint64_t     hash;         /* content hash, keys the XNNPACK weight cache */
+    bool         hashed;
+    int          threads;      /* from the model's [model] section or tuned, 0 = global */
+    char         cpu_affinity[64];  /* likewise, empty = global */
+    int          profile_runs;      /* invokes each context profiles (profile.h) */
+} TFLiteModelHandle;
+
+typedef enum {
+    DELEGATE_NONE,
+    DELEGATE_XNNPACK,
+    DELEGATE_GPU,
+} DelegateKind;
+
+typedef struct {
+    TFLiteModelHandle* model;
+    bool               owns_model;   /* false when attached from the cache */
     TfLiteInterpreter* interpreter;
     TfLiteInterpreterOptions* options;
 
-    /* User-provided output buffers to copy results into */
-    struct {
-        void*  buf;
-        size_t size;
-    } output_bindings[MAX_TENSORS];
+    /* Must outlive the interpreter; deleted in tflite_destroy */
+    TfLiteDelegate*    delegate;
+    DelegateKind       delegate_kind;
+
+    /* User-provided I/O buffers */
+    TFLiteBinding input_bindings[MAX_TENSORS];
+    TFLiteBinding output_bindings[MAX_TENSORS];
     int output_binding_count;
+
+    bool needs_alloc;   /* custom allocations changed since AllocateTensors */
+
+    /* Worker threads inherit the mask of the thread that spawns them:
+     * XNNPACK's pool at delegate creation, the builtin pool on the
+     * first invoke. Both happen inside 'cpus', the caller is untouched. */
+    NeuronShimCpuSet cpus;
+    bool             pool_started;
+
+    int              profile_left;   /* invokes still to profile */
+#ifdef NEURON_SHIM_TFLITE_PROFILER
+    TfLiteTelemetryProfilerStruct profiler;
+    struct {
+        const char* name;
+        int64_t     op, subgraph;
+        uint64_t    start_ns;
+    } ops[OP_DEPTH];                 /* op events begun, innermost last */
+    int              op_depth;
+#endif
 } TFLiteContext;
 
+static const NeuronShimConfig* g_cfg = NULL;
+
+static void tflite_model_release(void* model);
+
+static int tflite_init(const NeuronShimConfig* cfg) {
+    g_cfg = cfg;
+    return 0;
+}
+
+static int tflite_thread_count(const TFLiteModelHandle* m) {
+    int num_threads = 4;
+    if (m && m->threads > 0) num_threads = m->threads;
+    else if (g_cfg && g_cfg->threads > 0) num_threads = g_cfg->threads;
+    return num_threads;
+}
+
+/* ------------------------------------------------------------------ */
+/* Delegates                                                           */
+/*                                                                     */
+/*   tflite_delegate = auto     GPU if built in, else XNNPACK if built */
+/*                              in, else TFLite's own defaults         */
+/*                   = none     plain TFLite kernels                   */
+/*                   = xnnpack  XNNPACK, with optional fp16 and an     */
+/*                              on-disk weight cache per model         */
+/*                   = gpu      TFLite GPU delegate                    */
+/* ------------------------------------------------------------------ */
+static DelegateKind tflite_delegate_kind(void) {
+    const char* name = g_cfg ? g_cfg->tflite_delegate : "auto";
+
+    if (strcmp(name, "none") == 0)    return DELEGATE_NONE;
+    if (strcmp(name, "xnnpack") == 0) return DELEGATE_XNNPACK;
+    if (strcmp(name, "gpu") == 0)     return DELEGATE_GPU;
+
+#if defined(NEURON_SHIM_ENABLE_GPU)
+    return DELEGATE_GPU;
+#elif defined(NEURON_SHIM_ENABLE_XNNPACK)
+    return DELEGATE_XNNPACK;
+#else
+    return DELEGATE_NONE;
+#endif
+}
+
+#ifdef NEURON_SHIM_ENABLE_XNNPACK
+/*
+ * Repacked weights are written once, then mmapped on later starts. The
+ * file is keyed by model content, TFLite version and precision, so a
+ * replaced model or an upgraded TFLite never maps stale weights.
+ */
+static bool tflite_xnnpack_cache_path(const TFLiteModelHandle* m, bool fp16,
+                                      char* out, size_t len) {
+    if (g_cfg->xnnpack_cache_dir[0] == '\0' || !m->hashed) return false;
+    snprintf(out, len, "%s/%016llx-%s-%s.xnnpack_cache", g_cfg->xnnpack_cache_dir,
+             (unsigned long long)m->hash, TfLiteVersion(), fp16 ? "fp16" : "fp32");
+    return true;
+}
+
+/*
+ * Held from delegate creation until the interpreter is prepared while
+ * the cache file doesn't exist yet: the first context builds it, the
+ * ones loading alongside wait and map it instead of writing it too.
+ */
+static pthread_mutex_t g_xnnpack_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static bool tflite_xnnpack_cache_lock(const TFLiteModelHandle* m) {
+    char path[1024 + 512];
+    if (tflite_delegate_kind() != DELEGATE_XNNPACK ||
+        !tflite_xnnpack_cache_path(m, g_cfg->xnnpack_fp16, path, sizeof(path)) ||
+        access(path, F_OK) == 0)
+        return false;
+    pthread_mutex_lock(&g_xnnpack_cache_lock);
+    return true;
+}
+
+static TfLiteDelegate* tflite_create_xnnpack(const TFLiteModelHandle* m) {
+    TfLiteXNNPackDelegateOptions opts = TfLiteXNNPackDelegateOptionsDefault();
+    opts.num_threads = tflite_thread_count(m);
+
+    char cache_path[1024 + 512];
+    TfLiteDelegate* d = NULL;
+    if (g_cfg->xnnpack_fp16) {
+        TfLiteXNNPackDelegateOptions fp16 = opts;
+        fp16.flags |= TFLITE_XNNPACK_DELEGATE_FLAG_FORCE_FP16;
+        if (tflite_xnnpack_cache_path(m, true, cache_path, sizeof(cache_path)))
+            fp16.weight_cache_file_path = cache_path;
+        d = TfLiteXNNPackDelegateCreate(&fp16);
+        if (d)
+            opts.weight_cache_file_path = fp16.weight_cache_file_path;
+        else
+            SHIM_WARN("tflite", "XNNPACK fp16 not supported, "
+                      "using fp32");
+    }
+    if (!d) {
+        if (tflite_xnnpack_cache_path(m, false, cache_path, sizeof(cache_path)))
+            opts.weight_cache_file_path = cache_path;
+        d = TfLiteXNNPackDelegateCreate(&opts);
+    }
+
+    if (d)
+        SHIM_INFO("tflite", "XNNPACK delegate enabled "
+                  "(%d threads%s%s%s)", opts.num_threads,
+                  g_cfg->xnnpack_fp16 ? ", fp16" : "",
+                  opts.weight_cache_file_path ? ", cache " : "",
+                  opts.weight_cache_file_path ? opts.weight_cache_file_path : "");
+    return d;
+}
+#endif
+
+static void tflite_add_delegate(TFLiteContext* c) {
+    DelegateKind kind = tflite_delegate_kind();
+
+    switch (kind) {
+    case DELEGATE_XNNPACK:
+#ifdef NEURON_SHIM_ENABLE_XNNPACK
+        c->delegate = tflite_create_xnnpack(c->model);
+#else
+        SHIM_WARN("tflite", "XNNPACK delegate not built in "
+                  "(SHIM_ENABLE_XNNPACK)");
+#endif
+        break;
+
+    case DELEGATE_GPU:
+#ifdef NEURON_SHIM_ENABLE_GPU
+        {
+            TfLiteGpuDelegateOptionsV2 gpu_opts = TfLiteGpuDelegateOptionsV2Default();
+            c->delegate = TfLiteGpuDelegateV2Create(&gpu_opts);
+            if (c->delegate)
+                SHIM_INFO("tflite", "GPU delegate enabled");
+        }
+#else
+        SHIM_WARN("tflite", "GPU delegate not built in "
+                  "(SHIM_ENABLE_GPU)");
+#endif
+        break;
+
+    case DELEGATE_NONE:
+        break;
+    }
+
+    if (c->delegate) {
+        c->delegate_kind = kind;
+        TfLiteInterpreterOptionsAddDelegate(c->options, c->delegate);
+    }
+}
+
+static void tflite_delete_delegate(TFLiteContext* c) {
+    if (!c->delegate) return;
+
+    switch (c->delegate_kind) {
+#ifdef NEURON_SHIM_ENABLE_XNNPACK
+    case DELEGATE_XNNPACK: TfLiteXNNPackDelegateDelete(c->delegate); break;
+#endif
+#ifdef NEURON_SHIM_ENABLE_GPU
+    case DELEGATE_GPU:     TfLiteGpuDelegateV2Delete(c->delegate);   break;
+#endif
+    default: break;
+    }
+    c->delegate = NULL;
+}
+
+/* ------------------------------------------------------------------ */
+/* Op profiling (profile_file, see profile.h)                          */
+/*                                                                     */
+/* The telemetry profiler hears about every op the interpreter runs,   */
+/* on the invoking thread; while the context is still profiling each   */
+/* becomes a span. Delegated partitions show up as the delegate's op.  */
+/* ------------------------------------------------------------------ */
+#ifdef NEURON_SHIM_TFLITE_PROFILER
+static uint32_t tflite_op_begin(TfLiteTelemetryProfilerStruct* p, const char* op_name,
+                                int64_t op_idx, int64_t subgraph_idx) {
+    TFLiteContext* c = (TFLiteContext*)p->data;
+    if (c->profile_left <= 0 || c->op_depth == OP_DEPTH) return 0;
+
+    int d = c->op_depth++;
+    c->ops[d].name     = op_name;
+    c->ops[d].op       = op_idx;
+    c->ops[d].subgraph = subgraph_idx;
+    c->ops[d].start_ns = neuron_shim_now_ns();
+    return (uint32_t)d + 1;
+}
+
+static void tflite_op_end(TfLiteTelemetryProfilerStruct* p, uint32_t handle) {
+    TFLiteContext* c = (TFLiteContext*)p->data;
+    if (handle == 0 || handle > (uint32_t)c->op_depth) return;
+
+    c->op_depth = (int)handle - 1;
+    const char* name = c->ops[c->op_depth].name;
+    neuron_shim_profile_span("tflite", name ? name : "op",
+                             c->ops[c->op_depth].start_ns, neuron_shim_now_ns(),
+                             "\"op\":%lld,\"subgraph\":%lld",
+                             (long long)c->ops[c->op_depth].op,
+                             (long long)c->ops[c->op_depth].subgraph);
+}
+
+/* Ops timed elsewhere (e.g. inside a delegate), reported once done */
+static void tflite_op_done(TfLiteTelemetryProfilerStruct* p, const char* op_name,
+                           uint64_t elapsed_us, int64_t op_idx, int64_t subgraph_idx) {
+    TFLiteContext* c = (TFLiteContext*)p->data;
+    if (c->profile_left <= 0) return;
+
+    uint64_t end = neuron_shim_now_ns();
+    neuron_shim_profile_span("tflite", op_name ? op_name : "op",
+                             end - elapsed_us * 1000, end,
+                             "\"op\":%lld,\"subgraph\":%lld",
+                             (long long)op_idx, (long long)subgraph_idx);
+}
+
+static void tflite_telemetry_event(TfLiteTelemetryProfilerStruct* p,
+                                   const char* event_name, uint64_t status) {}
+static void tflite_telemetry_op_event(TfLiteTelemetryProfilerStruct* p,
+                                      const char* event_name, int64_t op_idx,
+                                      int64_t subgraph_idx, uint64_t status) {}
+static void tflite_telemetry_settings(TfLiteTelemetryProfilerStruct* p,
+                                      const char* setting_name,
+                                      const TfLiteTelemetrySettings* settings) {}
+
+static void tflite_add_profiler(TFLiteContext* c) {
+    c->profiler = (TfLiteTelemetryProfilerStruct){
+        .data                     = c,
+        .ReportTelemetryEvent     = tflite_telemetry_event,
+        .ReportTelemetryOpEvent   = tflite_telemetry_op_event,
+        .ReportSettings           = tflite_telemetry_settings,
+        .ReportBeginOpInvokeEvent = tflite_op_begin,
+        .ReportEndOpInvokeEvent   = tflite_op_end,
+        .ReportOpInvokeEvent      = tflite_op_done,
+    };
+    TfLiteInterpreterOptionsSetTelemetryProfiler(c->options, &c->profiler);
+}
+#endif
+
 /* ------------------------------------------------------------------ */
 /* Lifecycle                                                           */
 /* ------------------------------------------------------------------ */
@@ -50,20 +366,10 @@ static int tflite_create(void** ctx) {
     c->options = TfLiteInterpreterOptionsCreate();
 
     /* Use all available cores */
-    int num_threads = 4;
-    const char* env = getenv("NEURON_SHIM_NUM_THREADS");
-    if (env) num_threads = atoi(env);
-    TfLiteInterpreterOptionsSetNumThreads(c->options, num_threads);
+    TfLiteInterpreterOptionsSetNumThreads(c->options, tflite_thread_count(NULL));
 
-#ifdef NEURON_SHIM_ENABLE_GPU
-    {
-        TfLiteGpuDelegateOptionsV2 gpu_opts = TfLiteGpuDelegateOptionsV2Default();
-        TfLiteDelegate* gpu_delegate = TfLiteGpuDelegateV2Create(&gpu_opts);
-        if (gpu_delegate) {
-            TfLiteInterpreterOptionsAddDelegate(c->options, gpu_delegate);
-            fprintf(stderr, "[neuron-shim][tflite] GPU delegate enabled\n");
-        }
-    }
+#ifdef NEURON_SHIM_TFLITE_CANCEL
+    TfLiteInterpreterOptionsEnableCancellation(c->options, true);
 #endif
 
     *ctx = c;
@@ -76,59 +382,245 @@ static void tflite_destroy(void* ctx) {
 
     if (c->interpreter)
         TfLiteInterpreterDelete(c->interpreter);
-    if (c->model)
-        TfLiteModelDelete(c->model);
+    tflite_delete_delegate(c);
+    if (c->model && c->owns_model)
+        tflite_model_release(c->model);
     if (c->options)
         TfLiteInterpreterOptionsDelete(c->options);
 
+    for (int i = 0; i < MAX_TENSORS; i++) {
+        free(c->input_bindings[i].staging);
+        free(c->output_bindings[i].staging);
+    }
     free(c);
 }
 
 /* ------------------------------------------------------------------ */
 /* Model loading                                                       */
 /* ------------------------------------------------------------------ */
+static void tflite_map_binding(TFLiteContext* c, TFLiteBinding* b,
+                               int tensor_index, size_t tensor_size);
+
 static int tflite_build_interpreter(TFLiteContext* c) {
     if (!c->model) return -1;
 
-    c->interpreter = TfLiteInterpreterCreate(c->model, c->options);
+    const char* spec = c->model->cpu_affinity[0] ? c->model->cpu_affinity
+                                                 : g_cfg->cpu_affinity;
+    if (neuron_shim_cpuset_parse(spec, &c->cpus) == 0 && c->cpus.count)
+        SHIM_INFO("tflite", "inference threads pinned to %s (%d CPUs)",
+                  spec, c->cpus.count);
+
+    NeuronShimCpuMask saved;
+    bool pinned = neuron_shim_cpuset_enter(&c->cpus, &saved);
+#ifdef NEURON_SHIM_ENABLE_XNNPACK
+    bool cache_locked = tflite_xnnpack_cache_lock(c->model);
+#endif
+
+    /* Delegates are per interpreter, created once the model is known */
+    tflite_add_delegate(c);
+    if (c->model->threads > 0)
+        TfLiteInterpreterOptionsSetNumThreads(c->options, c->model->threads);
+
+    c->profile_left = c->model->profile_runs;
+#ifdef NEURON_SHIM_TFLITE_PROFILER
+    if (c->profile_left > 0) tflite_add_profiler(c);
+#endif
+
+    c->interpreter = TfLiteInterpreterCreate(c->model->model, c->options);
+    TfLiteStatus st = c->interpreter ? TfLiteInterpreterAllocateTensors(c->interpreter)
+                                     : kTfLiteError;
+#ifdef NEURON_SHIM_ENABLE_XNNPACK
+    if (cache_locked) pthread_mutex_unlock(&g_xnnpack_cache_lock);
+#endif
+    if (pinned) neuron_shim_cpuset_leave(&saved);
+
     if (!c->interpreter) {
-        fprintf(stderr, "[neuron-shim][tflite] failed to create interpreter\n");
+        SHIM_ERR("tflite", "failed to create interpreter");
         return -1;
     }
-
-    if (TfLiteInterpreterAllocateTensors(c->interpreter) != kTfLiteOk) {
-        fprintf(stderr, "[neuron-shim][tflite] AllocateTensors failed\n");
+    if (st != kTfLiteOk) {
+        SHIM_ERR("tflite", "AllocateTensors failed");
         return -1;
     }
 
-    fprintf(stderr, "[neuron-shim][tflite] model loaded: %d inputs, %d outputs\n",
-            TfLiteInterpreterGetInputTensorCount(c->interpreter),
-            TfLiteInterpreterGetOutputTensorCount(c->interpreter));
+    SHIM_INFO("tflite", "model loaded: %d inputs, %d outputs",
+              TfLiteInterpreterGetInputTensorCount(c->interpreter),
+              TfLiteInterpreterGetOutputTensorCount(c->interpreter));
+
+    /* Outputs may have been bound before the model was loaded */
+    const int* out_idx = TfLiteInterpreterOutputTensorIndices(c->interpreter);
+    int out_count = TfLiteInterpreterGetOutputTensorCount(c->interpreter);
+    for (int i = 0; i < c->output_binding_count && i < out_count; i++) {
+        const TfLiteTensor* t =
+            TfLiteInterpreterGetOutputTensor(c->interpreter, i);
+        tflite_map_binding(c, &c->output_bindings[i], out_idx[i],
+                           TfLiteTensorByteSize(t));
+    }
 
     return 0;
 }
 
-static int tflite_load_from_file(void* ctx, const char* path) {
+/* ------------------------------------------------------------------ */
+/* Autotuning (threads = auto, see autotune.h)                         */
+/*                                                                     */
+/* Each candidate thread count gets a throwaway context built the way  */
+/* a runtime's would be (same delegate, same CPU set), timed on the    */
+/* zero-filled tensors AllocateTensors leaves behind.                  */
+/* ------------------------------------------------------------------ */
+static int tflite_invoke(void* ctx);
+
+static bool tflite_tune_wanted(const NeuronShimModelConfig* mc) {
+    int threads = mc && mc->threads ? mc->threads : g_cfg->threads;
+    return threads == NEURON_SHIM_THREADS_AUTO;
+}
+
+static double tflite_tune_try(TFLiteModelHandle* m) {
+    void* ctx = NULL;
+    double us = -1;
+    if (tflite_create(&ctx) != 0) return -1;
+
     TFLiteContext* c = (TFLiteContext*)ctx;
+    c->model = m;
+    if (tflite_build_interpreter(c) == 0) {
+        int n = TfLiteInterpreterGetInputTensorCount(c->interpreter);
+        for (int i = 0; i < n; i++) {
+            TfLiteTensor* t = TfLiteInterpreterGetInputTensor(c->interpreter, i);
+            memset(TfLiteTensorData(t), 0, TfLiteTensorByteSize(t));
+        }
+        if (neuron_shim_tune_measure(tflite_invoke, c, &us) == 0)
+            SHIM_INFO("tflite", "autotune: threads=%d: %.0f us", m->threads, us);
+        else
+            us = -1;
+    }
+    tflite_destroy(c);
+    return us;
+}
+
+static void tflite_autotune(TFLiteModelHandle* m) {
+    char file[1024] = "";
+    uint64_t hash;
+    if (neuron_shim_hash_file(m->path, &hash) == 0) {
+        char variant[128];
+        snprintf(variant, sizeof(variant), "tflite-%s-%d%s-%s", TfLiteVersion(),
+                 (int)tflite_delegate_kind(), g_cfg->xnnpack_fp16 ? "-fp16" : "",
+                 m->cpu_affinity[0] ? m->cpu_affinity : g_cfg->cpu_affinity);
+        if (neuron_shim_tune_file(hash, variant, file, sizeof(file)) != 0) {
+            SHIM_WARN("tflite", "WARNING: tuning results won't be kept (set cache_dir)");
+            file[0] = '\0';
+        }
+    }
 
-    c->model = TfLiteModelCreateFromFile(path);
-    if (!c->model) {
-        fprintf(stderr, "[neuron-shim][tflite] failed to load: %s\n", path);
+    NeuronShimTuning t;
+    if (file[0] && neuron_shim_tune_load(file, &t) == 0 && t.threads > 0) {
+        m->threads = t.threads;
+        SHIM_INFO("tflite", "tuned settings from %s: threads=%d", file, m->threads);
+        return;
+    }
+
+    const char* spec = m->cpu_affinity[0] ? m->cpu_affinity : g_cfg->cpu_affinity;
+    int cand[NEURON_SHIM_TUNE_MAX_THREADS];
+    int n = neuron_shim_tune_threads(spec, cand, NEURON_SHIM_TUNE_MAX_THREADS);
+    int best = 0;
+    double best_us = 0;
+    for (int i = 0; i < n; i++) {
+        m->threads = cand[i];
+        double us = tflite_tune_try(m);
+        if (us >= 0 && (!best || us < best_us)) {
+            best = cand[i];
+            best_us = us;
+        }
+    }
+
+    m->threads = best;   /* 0 if nothing ran: the defaults */
+    if (!best) {
+        SHIM_WARN("tflite", "WARNING: can't autotune %s: synthetic run failed", m->path);
+        return;
+    }
+    SHIM_INFO("tflite", "tuned %s: threads=%d (%.0f us)", m->path, best, best_us);
+
+    NeuronShimTuning result = { .threads = best };
+    if (file[0] && neuron_shim_tune_save(file, &result) == 0)
+        SHIM_INFO("tflite", "tuning saved: %s", file);
+}
+
+static int tflite_model_load(const char* path, void** model) {
+    TFLiteModelHandle* m = (TFLiteModelHandle*)calloc(1, sizeof(*m));
+    if (!m) return -1;
+
+    m->model = TfLiteModelCreateFromFile(path);
+    if (!m->model) {
+        SHIM_ERR("tflite", "failed to load: %s", path);
+        free(m);
         return -1;
     }
+    snprintf(m->path, sizeof(m->path), "%s", path);
+    if (g_cfg->xnnpack_cache_dir[0] != '\0')
+        m->hashed = neuron_shim_hash_file(path, &m->hash) == 0;
+
+    const NeuronShimModelConfig* mc = neuron_shim_config_model(g_cfg, path);
+    if (mc) {
+        m->threads = mc->threads;
+        snprintf(m->cpu_affinity, sizeof(m->cpu_affinity), "%s", mc->cpu_affinity);
+    }
+    if (tflite_tune_wanted(mc)) tflite_autotune(m);
+    m->profile_runs = neuron_shim_profile_runs(g_cfg, mc);   /* not the tuning runs */
+
+    *model = m;
+    return 0;
+}
+
+static void tflite_model_release(void* model) {
+    TFLiteModelHandle* m = (TFLiteModelHandle*)model;
+    if (!m) return;
+
+    TfLiteModelDelete(m->model);
+    free(m);
+}
+
+static int tflite_attach(void* ctx, void* model) {
+    TFLiteContext* c = (TFLiteContext*)ctx;
+    if (c->model) return -1;
+
+    c->model = (TFLiteModelHandle*)model;
+    c->owns_model = false;
+    return tflite_build_interpreter(c);
+}
+
+static int tflite_load_from_file(void* ctx, const char* path) {
+    TFLiteContext* c = (TFLiteContext*)ctx;
+    if (c->model) return -1;
+
+    void* model;
+    if (tflite_model_load(path, &model) != 0) return -1;
 
+    c->model = (TFLiteModelHandle*)model;
+    c->owns_model = true;
     return tflite_build_interpreter(c);
 }
 
 static int tflite_load_from_buffer(void* ctx, const void* buf, size_t size) {
     TFLiteContext* c = (TFLiteContext*)ctx;
+    if (c->model) return -1;
 
-    c->model = TfLiteModelCreate(buf, size);
-    if (!c->model) {
-        fprintf(stderr, "[neuron-shim][tflite] failed to load from buffer\n");
+    TFLiteModelHandle* m = (TFLiteModelHandle*)calloc(1, sizeof(*m));
+    if (!m) return -1;
+
+    /* TfLiteModelCreate does not copy: 'buf' must outlive the model */
+    m->model = TfLiteModelCreate(buf, size);
+    if (!m->model) {
+        SHIM_ERR("tflite", "failed to load from buffer");
+        free(m);
         return -1;
     }
 
+    m->profile_runs = neuron_shim_profile_runs(g_cfg, NULL);
+    if (g_cfg->xnnpack_cache_dir[0] != '\0') {
+        m->hash   = neuron_shim_hash_buffer(buf, size);
+        m->hashed = true;
+    }
+
+    c->model = m;
+    c->owns_model = true;
     return tflite_build_interpreter(c);
 }
 
@@ -173,33 +665,142 @@ static int tflite_get_output_size(void* ctx, int index, size_t* size) {
     return 0;
 }
 
+static void tflite_fill_desc(ShimTensorDesc* d, const TfLiteTensor* t) {
+    memset(d, 0, sizeof(*d));
+    int32_t rank = TfLiteTensorNumDims(t);
+    d->rank = rank < 0 ? 0 : rank > 8 ? 8 : (uint32_t)rank;
+    for (uint32_t i = 0; i < d->rank; i++) {
+        int32_t dim = TfLiteTensorDim(t, (int32_t)i);
+        d->dims[i] = dim > 0 ? (uint32_t)dim : 0;
+    }
+
+    switch (TfLiteTensorType(t)) {
+    case kTfLiteFloat32: d->type = NEURON_SHIM_TYPE_FLOAT32; break;
+    case kTfLiteUInt8:   d->type = NEURON_SHIM_TYPE_UINT8;   break;
+    case kTfLiteInt8:    d->type = NEURON_SHIM_TYPE_INT8;    break;
+    case kTfLiteFloat16: d->type = NEURON_SHIM_TYPE_FLOAT16; break;
+    case kTfLiteInt16:   d->type = NEURON_SHIM_TYPE_INT16;   break;
+    case kTfLiteInt32:   d->type = NEURON_SHIM_TYPE_INT32;   break;
+    case kTfLiteInt64:   d->type = NEURON_SHIM_TYPE_INT64;   break;
+    case kTfLiteBool:    d->type = NEURON_SHIM_TYPE_BOOL;    break;
+    default:             d->type = NEURON_SHIM_TYPE_UNKNOWN; break;
+    }
+
+    TfLiteQuantizationParams q = TfLiteTensorQuantizationParams(t);
+    d->scale      = q.scale;
+    d->zero_point = q.zero_point;
+    d->size       = TfLiteTensorByteSize(t);
+}
+
+static int tflite_get_input_info(void* ctx, int index, ShimTensorDesc* desc) {
+    TFLiteContext* c = (TFLiteContext*)ctx;
+    if (!c->interpreter) return -1;
+
+    const TfLiteTensor* tensor =
+        TfLiteInterpreterGetInputTensor(c->interpreter, index);
+    if (!tensor) return -1;
+
+    tflite_fill_desc(desc, tensor);
+    return 0;
+}
+
+static int tflite_get_output_info(void* ctx, int index, ShimTensorDesc* desc) {
+    TFLiteContext* c = (TFLiteContext*)ctx;
+    if (!c->interpreter) return -1;
+
+    const TfLiteTensor* tensor =
+        TfLiteInterpreterGetOutputTensor(c->interpreter, index);
+    if (!tensor) return -1;
+
+    tflite_fill_desc(desc, tensor);
+    return 0;
+}
+
 /* ------------------------------------------------------------------ */
 /* I/O binding                                                         */
 /* ------------------------------------------------------------------ */
+/*
+ * Point a tensor at the bound app buffer when zero-copy rules allow it,
+ * else leave it on the copy path. Sets b->direct accordingly.
+ */
+static void tflite_map_binding(TFLiteContext* c, TFLiteBinding* b,
+                               int tensor_index, size_t tensor_size) {
+    b->direct = false;
+    if (!g_cfg || !g_cfg->tflite_zero_copy) return;
+
+    void* want = NULL;
+    if (b->buf && ((uintptr_t)b->buf % TENSOR_ALIGNMENT) == 0 &&
+        b->size >= tensor_size)
+        want = b->buf;
+
+    if (!want) {
+        if (!b->mapped) return;   /* still on the arena — plain copy path */
+        if (!b->staging) {
+            size_t bytes = (tensor_size + TENSOR_ALIGNMENT - 1)
+                           & ~(size_t)(TENSOR_ALIGNMENT - 1);
+            b->staging = aligned_alloc(TENSOR_ALIGNMENT, bytes);
+            if (!b->staging) return;
+        }
+        want = b->staging;
+    }
+
+    if (want != b->mapped) {
+        TfLiteCustomAllocation alloc = { .data = want, .bytes = tensor_size };
+        if (TfLiteInterpreterSetCustomAllocationForTensor(
+                c->interpreter, tensor_index, &alloc,
+                kTfLiteCustomAllocationFlagsNone) != kTfLiteOk) {
+            /* e.g. a non-arena tensor: keep it where it was */
+            return;
+        }
+        b->mapped = want;
+        c->needs_alloc = true;
+    }
+
+    b->direct = (want == b->buf);
+}
+
 static int tflite_set_input(void* ctx, int index, const void* buf, size_t size) {
     TFLiteContext* c = (TFLiteContext*)ctx;
-    if (!c->interpreter) return -1;
+    if (!c->interpreter || index < 0 || index >= MAX_TENSORS) return -1;
 
-    TfLiteTensor* tensor =
+    const TfLiteTensor* tensor =
         TfLiteInterpreterGetInputTensor(c->interpreter, index);
     if (!tensor) return -1;
 
-    if (TfLiteTensorCopyFromBuffer(tensor, buf, size) != kTfLiteOk)
-        return -1;
+    TFLiteBinding* b = &c->input_bindings[index];
+    if (buf && b->buf == buf && b->size == size)
+        return 0;   /* same binding as last frame */
 
+    /* TFLite kernels don't write to their inputs */
+    b->buf  = (void*)buf;
+    b->size = size;
+    tflite_map_binding(c, b,
+        TfLiteInterpreterInputTensorIndices(c->interpreter)[index],
+        TfLiteTensorByteSize(tensor));
     return 0;
 }
 
 static int tflite_set_output(void* ctx, int index, void* buf, size_t size) {
     TFLiteContext* c = (TFLiteContext*)ctx;
-    if (index >= MAX_TENSORS) return -1;
+    if (index < 0 || index >= MAX_TENSORS) return -1;
 
-    /* Store binding — we'll copy data here after inference */
-    c->output_bindings[index].buf  = buf;
-    c->output_bindings[index].size = size;
+    /* Store binding — results are copied here after inference unless
+     * the tensor can write into it directly */
+    TFLiteBinding* b = &c->output_bindings[index];
+    b->buf  = buf;
+    b->size = size;
     if (index >= c->output_binding_count)
         c->output_binding_count = index + 1;
 
+    if (c->interpreter &&
+        index < TfLiteInterpreterGetOutputTensorCount(c->interpreter)) {
+        const TfLiteTensor* tensor =
+            TfLiteInterpreterGetOutputTensor(c->interpreter, index);
+        tflite_map_binding(c, b,
+            TfLiteInterpreterOutputTensorIndices(c->interpreter)[index],
+            TfLiteTensorByteSize(tensor));
+    }
+
     return 0;
 }
 
@@ -210,28 +811,95 @@ static int tflite_invoke(void* ctx) {
     TFLiteContext* c = (TFLiteContext*)ctx;
     if (!c->interpreter) return -1;
 
-    if (TfLiteInterpreterInvoke(c->interpreter) != kTfLiteOk) {
-        fprintf(stderr, "[neuron-shim][tflite] inference failed\n");
+    /* New custom allocations only take effect after re-planning */
+    if (c->needs_alloc) {
+        if (TfLiteInterpreterAllocateTensors(c->interpreter) != kTfLiteOk) {
+            SHIM_ERR("tflite", "AllocateTensors failed");
+            return -1;
+        }
+        c->needs_alloc = false;
+    }
+
+    /* Copy inputs that aren't mapped directly. Done here rather than in
+     * set_input so a re-plan above can't clobber them, and so the app
+     * may refill a buffer it bound once. */
+    bool     prof   = c->profile_left > 0;
+    uint64_t t0     = prof ? neuron_shim_now_ns() : 0;
+    size_t   copied = 0;
+    int in_count = TfLiteInterpreterGetInputTensorCount(c->interpreter);
+    for (int i = 0; i < in_count && i < MAX_TENSORS; i++) {
+        TFLiteBinding* b = &c->input_bindings[i];
+        if (b->direct || !b->buf) continue;
+        copied += b->size;
+
+        TfLiteTensor* tensor =
+            TfLiteInterpreterGetInputTensor(c->interpreter, i);
+        if (TfLiteTensorCopyFromBuffer(tensor, b->buf, b->size) != kTfLiteOk) {
+            SHIM_ERR("tflite", "input[%d]: %zu bytes, "
+                     "model wants %zu", i, b->size,
+                     TfLiteTensorByteSize(tensor));
+            return -1;
+        }
+    }
+    if (prof && copied)
+        neuron_shim_profile_span("tflite", "copy in", t0, neuron_shim_now_ns(),
+                                 "\"bytes\":%zu", copied);
+
+    NeuronShimCpuMask saved;
+    bool pinned = !c->pool_started && neuron_shim_cpuset_enter(&c->cpus, &saved);
+    TfLiteStatus st = TfLiteInterpreterInvoke(c->interpreter);
+    if (pinned) neuron_shim_cpuset_leave(&saved);
+    c->pool_started = true;
+
+    if (st != kTfLiteOk) {
+        SHIM_ERR("tflite", "inference failed");
         return -1;
     }
 
     /* Copy output data to user-provided buffers */
+    if (prof) t0 = neuron_shim_now_ns();
+    copied = 0;
     for (int i = 0; i < c->output_binding_count; i++) {
-        if (!c->output_bindings[i].buf) continue;
+        TFLiteBinding* b = &c->output_bindings[i];
+        if (!b->buf || b->direct) continue;
 
         const TfLiteTensor* tensor =
             TfLiteInterpreterGetOutputTensor(c->interpreter, i);
         if (!tensor) continue;
 
-        size_t copy_size = c->output_bindings[i].size;
+        size_t copy_size = b->size;
         size_t tensor_size = TfLiteTensorByteSize(tensor);
         if (copy_size > tensor_size) copy_size = tensor_size;
 
-        TfLiteTensorCopyToBuffer(tensor,
-                                 c->output_bindings[i].buf,
-                                 copy_size);
+        /* CopyToBuffer insists on an exact size; copy the overlap */
+        memcpy(b->buf, TfLiteTensorData(tensor), copy_size);
+        copied += copy_size;
     }
+    if (prof && copied)
+        neuron_shim_profile_span("tflite", "copy out", t0, neuron_shim_now_ns(),
+                                 "\"bytes\":%zu", copied);
+    if (prof) c->profile_left--;
+
+    return 0;
+}
+
+#ifdef NEURON_SHIM_TFLITE_CANCEL
+static void tflite_abort(void* ctx) {
+    TFLiteContext* c = (TFLiteContext*)ctx;
+    /* Invoke re-arms the flag on entry, so a stale cancel is harmless */
+    if (c->interpreter) TfLiteInterpreterCancel(c->interpreter);
+}
+#endif
+
+/* Ops the delegate doesn't claim run on the builtin kernels */
+static int tflite_providers(void* ctx, char* out, size_t len) {
+    TFLiteContext* c = (TFLiteContext*)ctx;
+    if (!c->interpreter) return -1;
 
+    const char* delegate = !c->delegate                       ? ""
+                         : c->delegate_kind == DELEGATE_GPU   ? "gpu+"
+                         :                                      "xnnpack+";
+    snprintf(out, len, "%scpu", delegate);
     return 0;
 }
 
@@ -240,19 +908,30 @@ static int tflite_invoke(void* ctx) {
 /* ------------------------------------------------------------------ */
 static const NeuronShimBackend tflite_backend = {
     .name             = "tflite",
+    .init             = tflite_init,
     .create           = tflite_create,
     .destroy          = tflite_destroy,
     .load_from_file   = tflite_load_from_file,
     .load_from_buffer = tflite_load_from_buffer,
+    .model_load       = tflite_model_load,
+    .model_release    = tflite_model_release,
+    .attach           = tflite_attach,
     .get_input_count  = tflite_get_input_count,
     .get_output_count = tflite_get_output_count,
     .get_input_size   = tflite_get_input_size,
     .get_output_size  = tflite_get_output_size,
+    .get_input_info   = tflite_get_input_info,
+    .get_output_info  = tflite_get_output_info,
     .set_input        = tflite_set_input,
     .set_output       = tflite_set_output,
     .invoke           = tflite_invoke,
+#ifdef NEURON_SHIM_TFLITE_CANCEL
+    .abort            = tflite_abort,
+#endif
+    .providers        = tflite_providers,
 };
 
-const NeuronShimBackend* neuron_shim_backend_tflite(void) {
-    return &tflite_backend;
+/* Plugin entry point (see backend.h) */
+const NeuronShimBackend* neuron_shim_plugin_backend(uint32_t abi) {
+    return abi == NEURON_SHIM_BACKEND_ABI ? &tflite_backend : NULL;
 }
@@ -3,20 +3,208 @@
  */
 
 #include "config.h"
+#include "RuntimeAPI.h"
+#include "log.h"
 
+#include <fnmatch.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
 
 static NeuronShimConfig g_config = {
     .backend   = "auto",
     .suffix    = "auto",
     .model_dir = "",       /* empty = use original path */
     .threads   = 4,
+    .cpu_affinity = "",
     .force_cpu = false,
+    .gpu_placement = "fixed",
+    .gpu_device = 0,
+    .gpu_count = 0,
     .log_level = 3,
+    .log_rate_limit = 20,
+    .global_thread_pool = false,
+    .memory_pattern = true,
+    .arena_shrinkage = false,
+    .model_cache = true,
+    .hot_swap = false,
+    .pinned_memory = true,
+    .tflite_zero_copy = false,
+    .tflite_delegate = "auto",
+    .xnnpack_fp16 = false,
+    .xnnpack_cache_dir = "",
+    .cache_dir = "",
+    .optimized_model_cache = false,
+    .trt_engine_cache = false,
+    .trt_engine_cache_path = "",
+    .trt_timing_cache = false,
+    .trt_fp16 = false,
+    .trt_int8 = false,
+    .trt_max_workspace = 0,
+    .preload = "",
+    .warmup_runs = 1,
+    .qos_scheduler = true,
+    .stats_dump = "",
+    .trace_file = "",
+    .trace_sample_inputs = 0,
+    .profile_file = "",
+    .profile_runs = 10,
 };
 
+/* Copy a string setting. A value that doesn't fit is refused, keeping
+ * the previous one, rather than cut short (a core list missing its
+ * last cores, say). */
+static void set_string(char* dst, size_t size, const char* key, const char* value) {
+    size_t n = strlen(value);
+    if (n >= size) {
+        SHIM_WARN(NULL, "WARNING: %s too long (%zu chars, max %zu), ignored",
+                  key, n, size - 1);
+        return;
+    }
+    memcpy(dst, value, n + 1);
+}
+
+/* ------------------------------------------------------------------ */
+/* Per-model sections                                                  */
+/* ------------------------------------------------------------------ */
+
+/* "uint8,nhwc,scale=0.0078125,zero_point=128" */
+static void parse_tensor_conv(NeuronShimTensorConv* t, const char* value) {
+    char buf[512];
+    snprintf(buf, sizeof(buf), "%s", value);
+
+    memset(t, 0, sizeof(*t));
+    t->type = NEURON_SHIM_TYPE_UNKNOWN;   /* = same as the model */
+
+    char* save = NULL;
+    for (char* tok = strtok_r(buf, ",", &save); tok;
+         tok = strtok_r(NULL, ",", &save)) {
+        if (strcmp(tok, "float32") == 0)      t->type = NEURON_SHIM_TYPE_FLOAT32;
+        else if (strcmp(tok, "float16") == 0) t->type = NEURON_SHIM_TYPE_FLOAT16;
+        else if (strcmp(tok, "uint8") == 0)   t->type = NEURON_SHIM_TYPE_UINT8;
+        else if (strcmp(tok, "int8") == 0)    t->type = NEURON_SHIM_TYPE_INT8;
+        else if (strcmp(tok, "nhwc") == 0)    t->nhwc = true;
+        else if (strcmp(tok, "nchw") == 0)    t->nhwc = false;
+        else if (strncmp(tok, "scale=", 6) == 0)
+            t->scale = strtof(tok + 6, NULL);
+        else if (strncmp(tok, "zero_point=", 11) == 0)
+            t->zero_point = (int32_t)strtol(tok + 11, NULL, 10);
+        else
+            SHIM_WARN(NULL, "WARNING: unknown tensor option '%s'", tok);
+    }
+    t->enabled = true;
+}
+
+/* "1x3x480x640,1x3x720x1280"; '?' for a dim inferred from the size */
+static void parse_shape_hints(NeuronShimModelConfig* m, int index,
+                              const char* value) {
+    char buf[512];
+    snprintf(buf, sizeof(buf), "%s", value);
+
+    m->input_shape_count[index] = 0;
+    char* save = NULL;
+    for (char* tok = strtok_r(buf, ",", &save); tok;
+         tok = strtok_r(NULL, ",", &save)) {
+        if (m->input_shape_count[index] == NEURON_SHIM_MAX_SHAPES) {
+            SHIM_WARN(NULL, "WARNING: input_shape.%d: more than %d shapes",
+                      index, NEURON_SHIM_MAX_SHAPES);
+            break;
+        }
+        NeuronShimShapeHint* h =
+            &m->input_shapes[index][m->input_shape_count[index]];
+        h->rank = 0;
+
+        char* dsave = NULL;
+        for (char* d = strtok_r(tok, "x", &dsave); d && h->rank < 8;
+             d = strtok_r(NULL, "x", &dsave))
+            h->dims[h->rank++] = strcmp(d, "?") == 0 ? -1 : strtoll(d, NULL, 10);
+        if (h->rank) m->input_shape_count[index]++;
+    }
+}
+
+/* A thread count, or "auto" */
+static int parse_threads(const char* value) {
+    return strcmp(value, "auto") == 0 ? NEURON_SHIM_THREADS_AUTO : atoi(value);
+}
+
+/* Keys valid inside a [model] section */
+static void parse_model_key(NeuronShimModelConfig* m, const char* key,
+                            const char* value) {
+    int index;
+    if (sscanf(key, "input_shape.%d", &index) == 1) {
+        if (index >= 0 && index < NEURON_SHIM_MAX_IO)
+            parse_shape_hints(m, index, value);
+    } else if (sscanf(key, "input.%d", &index) == 1) {
+        if (index >= 0 && index < NEURON_SHIM_MAX_IO)
+            parse_tensor_conv(&m->inputs[index], value);
+    } else if (sscanf(key, "output.%d", &index) == 1) {
+        if (index >= 0 && index < NEURON_SHIM_MAX_IO)
+            parse_tensor_conv(&m->outputs[index], value);
+    } else if (strcmp(key, "backend") == 0) {
+        set_string(m->backend, sizeof(m->backend), key, value);
+    } else if (strcmp(key, "suffix") == 0) {
+        set_string(m->suffix, sizeof(m->suffix), key, value);
+    } else if (strcmp(key, "ep") == 0) {
+        set_string(m->ep, sizeof(m->ep), key, value);
+    } else if (strcmp(key, "threads") == 0) {
+        m->threads = parse_threads(value);
+    } else if (strcmp(key, "cpu_affinity") == 0) {
+        set_string(m->cpu_affinity, sizeof(m->cpu_affinity), key, value);
+    } else if (strcmp(key, "cuda_graph") == 0) {
+        m->cuda_graph = strcmp(value, "true") == 0 || strcmp(value, "1") == 0;
+    } else if (strcmp(key, "batch_window_us") == 0) {
+        m->batch_window_us = atoi(value);
+    } else if (strcmp(key, "max_batch") == 0) {
+        m->max_batch = atoi(value);
+    } else if (strcmp(key, "pipeline") == 0) {
+        m->pipeline = strcmp(value, "true") == 0 || strcmp(value, "1") == 0;
+    } else if (strcmp(key, "profile_runs") == 0) {
+        m->profile_runs = atoi(value);
+    } else {
+        SHIM_WARN(NULL, "WARNING: unknown key '%s' in [model %s]",
+                  key, m->pattern);
+    }
+}
+
+static NeuronShimModelConfig* open_model_section(const char* line) {
+    char pattern[256];
+    if (sscanf(line, "[model %255[^]]]", pattern) != 1) {
+        SHIM_WARN(NULL, "WARNING: bad config section: %s", line);
+        return NULL;
+    }
+    if (g_config.model_count == NEURON_SHIM_MAX_MODELS) {
+        SHIM_WARN(NULL, "WARNING: more than %d [model] sections, ignoring %s",
+                  NEURON_SHIM_MAX_MODELS, pattern);
+        return NULL;
+    }
+    NeuronShimModelConfig* m = &g_config.models[g_config.model_count++];
+    snprintf(m->pattern, sizeof(m->pattern), "%s", pattern);
+    return m;
+}
+
+const NeuronShimModelConfig* neuron_shim_config_model(const NeuronShimConfig* cfg,
+                                                      const char* dla_path) {
+    /* Backends only see the resolved file: match it by its .dla name,
+     * stripping the suffix that section's models are resolved with */
+    for (int i = 0; i < cfg->model_count; i++) {
+        char        path[1024];
+        const char* suffix = neuron_shim_config_model_suffix(cfg, &cfg->models[i]);
+        size_t      n = strlen(dla_path), s = strlen(suffix);
+        if (s && n > s && strcmp(dla_path + n - s, suffix) == 0) n -= s;
+        snprintf(path, sizeof(path), "%.*s", (int)n, dla_path);
+
+        const char* base = strrchr(path, '/');
+        base = base ? base + 1 : path;
+
+        const char* pattern = cfg->models[i].pattern;
+        const char* subject = strchr(pattern, '/') ? path : base;
+        if (fnmatch(pattern, subject, 0) == 0) return &cfg->models[i];
+    }
+    return NULL;
+}
+
 /* ------------------------------------------------------------------ */
 /* Parse a config file                                                 */
 /* ------------------------------------------------------------------ */
@@ -24,6 +212,10 @@ static void parse_config_file(const char* path) {
     FILE* f = fopen(path, "r");
     if (!f) return;
 
+    /* Set once a [model ...] header is seen; later keys belong to it */
+    NeuronShimModelConfig* section = NULL;
+    bool in_section = false;
+
     char line[512];
     while (fgets(line, sizeof(line), f)) {
         /* Skip comments and blanks */
@@ -31,24 +223,118 @@ static void parse_config_file(const char* path) {
         while (*p == ' ' || *p == '\t') p++;
         if (*p == '#' || *p == '\n' || *p == '\0') continue;
 
+        if (*p == '[') {
+            p[strcspn(p, "\n")] = '\0';
+            section    = open_model_section(p);
+            in_section = true;
+            continue;
+        }
+
         char key[64], value[512];
         if (sscanf(p, "%63[^= ] = %511s", key, value) != 2) continue;
 
+        if (in_section) {
+            if (section) parse_model_key(section, key, value);
+            continue;
+        }
+
         if (strcmp(key, "backend") == 0) {
-            strncpy(g_config.backend, value, sizeof(g_config.backend) - 1);
-            g_config.backend[sizeof(g_config.backend) - 1] = '\0';
+            set_string(g_config.backend, sizeof(g_config.backend), key, value);
         } else if (strcmp(key, "suffix") == 0) {
-            strncpy(g_config.suffix, value, sizeof(g_config.suffix) - 1);
-            g_config.suffix[sizeof(g_config.suffix) - 1] = '\0';
-        } else if (strcmp(key, "model_dir") == 0)
-            snprintf(g_config.model_dir, sizeof(g_config.model_dir), "%s", value);
+            set_string(g_config.suffix, sizeof(g_config.suffix), key, value);
+        } else if (strcmp(key, "plugin_dir") == 0)
+            set_string(g_config.plugin_dir, sizeof(g_config.plugin_dir), key, value);
+        else if (strcmp(key, "model_dir") == 0)
+            set_string(g_config.model_dir, sizeof(g_config.model_dir), key, value);
         else if (strcmp(key, "threads") == 0)
-            g_config.threads = atoi(value);
+            g_config.threads = parse_threads(value);
+        else if (strcmp(key, "cpu_affinity") == 0)
+            set_string(g_config.cpu_affinity, sizeof(g_config.cpu_affinity), key, value);
         else if (strcmp(key, "force_cpu") == 0)
             g_config.force_cpu = (strcmp(value, "true") == 0 ||
                                   strcmp(value, "1") == 0);
         else if (strcmp(key, "log_level") == 0)
             g_config.log_level = atoi(value);
+        else if (strcmp(key, "log_rate_limit") == 0)
+            g_config.log_rate_limit = atoi(value);
+        else if (strcmp(key, "global_thread_pool") == 0)
+            g_config.global_thread_pool = (strcmp(value, "true") == 0 ||
+                                           strcmp(value, "1") == 0);
+        else if (strcmp(key, "arena_extend_strategy") == 0)
+            set_string(g_config.arena_extend_strategy, sizeof(g_config.arena_extend_strategy), key, value);
+        else if (strcmp(key, "arena_max_memory") == 0)
+            g_config.arena_max_memory = (size_t)strtoull(value, NULL, 10);
+        else if (strcmp(key, "arena_initial_chunk") == 0)
+            g_config.arena_initial_chunk = (size_t)strtoull(value, NULL, 10);
+        else if (strcmp(key, "memory_pattern") == 0)
+            g_config.memory_pattern = (strcmp(value, "true") == 0 ||
+                                       strcmp(value, "1") == 0);
+        else if (strcmp(key, "arena_shrinkage") == 0)
+            g_config.arena_shrinkage = (strcmp(value, "true") == 0 ||
+                                        strcmp(value, "1") == 0);
+        else if (strcmp(key, "gpu_placement") == 0)
+            set_string(g_config.gpu_placement, sizeof(g_config.gpu_placement), key, value);
+        else if (strcmp(key, "gpu_device") == 0)
+            g_config.gpu_device = atoi(value);
+        else if (strcmp(key, "gpu_count") == 0)
+            g_config.gpu_count = atoi(value);
+        else if (strcmp(key, "pinned_memory") == 0)
+            g_config.pinned_memory = (strcmp(value, "true") == 0 ||
+                                      strcmp(value, "1") == 0);
+        else if (strcmp(key, "model_cache") == 0)
+            g_config.model_cache = (strcmp(value, "true") == 0 ||
+                                    strcmp(value, "1") == 0);
+        else if (strcmp(key, "hot_swap") == 0)
+            g_config.hot_swap = (strcmp(value, "true") == 0 ||
+                                 strcmp(value, "1") == 0);
+        else if (strcmp(key, "tflite_zero_copy") == 0)
+            g_config.tflite_zero_copy = (strcmp(value, "true") == 0 ||
+                                         strcmp(value, "1") == 0);
+        else if (strcmp(key, "tflite_delegate") == 0)
+            set_string(g_config.tflite_delegate, sizeof(g_config.tflite_delegate), key, value);
+        else if (strcmp(key, "xnnpack_fp16") == 0)
+            g_config.xnnpack_fp16 = (strcmp(value, "true") == 0 ||
+                                     strcmp(value, "1") == 0);
+        else if (strcmp(key, "xnnpack_cache_dir") == 0)
+            set_string(g_config.xnnpack_cache_dir, sizeof(g_config.xnnpack_cache_dir), key, value);
+        else if (strcmp(key, "cache_dir") == 0)
+            set_string(g_config.cache_dir, sizeof(g_config.cache_dir), key, value);
+        else if (strcmp(key, "optimized_model_cache") == 0)
+            g_config.optimized_model_cache = (strcmp(value, "true") == 0 ||
+                                              strcmp(value, "1") == 0);
+        else if (strcmp(key, "trt_engine_cache") == 0)
+            g_config.trt_engine_cache = (strcmp(value, "true") == 0 ||
+                                         strcmp(value, "1") == 0);
+        else if (strcmp(key, "trt_engine_cache_path") == 0)
+            set_string(g_config.trt_engine_cache_path, sizeof(g_config.trt_engine_cache_path), key, value);
+        else if (strcmp(key, "trt_timing_cache") == 0)
+            g_config.trt_timing_cache = (strcmp(value, "true") == 0 ||
+                                         strcmp(value, "1") == 0);
+        else if (strcmp(key, "trt_fp16") == 0)
+            g_config.trt_fp16 = (strcmp(value, "true") == 0 ||
+                                 strcmp(value, "1") == 0);
+        else if (strcmp(key, "trt_int8") == 0)
+            g_config.trt_int8 = (strcmp(value, "true") == 0 ||
+                                 strcmp(value, "1") == 0);
+        else if (strcmp(key, "trt_max_workspace") == 0)
+            g_config.trt_max_workspace = (size_t)strtoull(value, NULL, 10);
+        else if (strcmp(key, "preload") == 0)
+            set_string(g_config.preload, sizeof(g_config.preload), key, value);
+        else if (strcmp(key, "warmup_runs") == 0)
+            g_config.warmup_runs = atoi(value);
+        else if (strcmp(key, "qos_scheduler") == 0)
+            g_config.qos_scheduler = (strcmp(value, "true") == 0 ||
+                                      strcmp(value, "1") == 0);
+        else if (strcmp(key, "stats_dump") == 0)
+            set_string(g_config.stats_dump, sizeof(g_config.stats_dump), key, value);
+        else if (strcmp(key, "trace_file") == 0)
+            set_string(g_config.trace_file, sizeof(g_config.trace_file), key, value);
+        else if (strcmp(key, "trace_sample_inputs") == 0)
+            g_config.trace_sample_inputs = atoi(value);
+        else if (strcmp(key, "profile_file") == 0)
+            set_string(g_config.profile_file, sizeof(g_config.profile_file), key, value);
+        else if (strcmp(key, "profile_runs") == 0)
+            g_config.profile_runs = atoi(value);
     }
     fclose(f);
 }
@@ -65,16 +351,22 @@ const NeuronShimConfig* neuron_shim_config_load(void) {
 
     /* Environment variables override everything */
     env = getenv("NEURON_SHIM_BACKEND");
-    if (env) { strncpy(g_config.backend, env, sizeof(g_config.backend) - 1); g_config.backend[sizeof(g_config.backend) - 1] = '\0'; }
+    if (env) set_string(g_config.backend, sizeof(g_config.backend), "NEURON_SHIM_BACKEND", env);
 
     env = getenv("NEURON_SHIM_SUFFIX");
-    if (env) { strncpy(g_config.suffix, env, sizeof(g_config.suffix) - 1); g_config.suffix[sizeof(g_config.suffix) - 1] = '\0'; }
+    if (env) set_string(g_config.suffix, sizeof(g_config.suffix), "NEURON_SHIM_SUFFIX", env);
+
+    env = getenv("NEURON_SHIM_PLUGIN_DIR");
+    if (env) set_string(g_config.plugin_dir, sizeof(g_config.plugin_dir), "NEURON_SHIM_PLUGIN_DIR", env);
 
     env = getenv("NEURON_SHIM_MODEL_DIR");
-    if (env) snprintf(g_config.model_dir, sizeof(g_config.model_dir), "%s", env);
+    if (env) set_string(g_config.model_dir, sizeof(g_config.model_dir), "NEURON_SHIM_MODEL_DIR", env);
 
     env = getenv("NEURON_SHIM_NUM_THREADS");
-    if (env) g_config.threads = atoi(env);
+    if (env) g_config.threads = parse_threads(env);
+
+    env = getenv("NEURON_SHIM_CPU_AFFINITY");
+    if (env) set_string(g_config.cpu_affinity, sizeof(g_config.cpu_affinity), "NEURON_SHIM_CPU_AFFINITY", env);
 
     env = getenv("NEURON_SHIM_FORCE_CPU");
     if (env) g_config.force_cpu = (strcmp(env, "1") == 0);
@@ -82,6 +374,109 @@ const NeuronShimConfig* neuron_shim_config_load(void) {
     env = getenv("NEURON_SHIM_LOG_LEVEL");
     if (env) g_config.log_level = atoi(env);
 
+    env = getenv("NEURON_SHIM_LOG_RATE_LIMIT");
+    if (env) g_config.log_rate_limit = atoi(env);
+
+    env = getenv("NEURON_SHIM_GLOBAL_THREAD_POOL");
+    if (env) g_config.global_thread_pool = (strcmp(env, "1") == 0);
+
+    env = getenv("NEURON_SHIM_ARENA_EXTEND_STRATEGY");
+    if (env) set_string(g_config.arena_extend_strategy, sizeof(g_config.arena_extend_strategy), "NEURON_SHIM_ARENA_EXTEND_STRATEGY", env);
+
+    env = getenv("NEURON_SHIM_ARENA_MAX_MEMORY");
+    if (env) g_config.arena_max_memory = (size_t)strtoull(env, NULL, 10);
+
+    env = getenv("NEURON_SHIM_ARENA_INITIAL_CHUNK");
+    if (env) g_config.arena_initial_chunk = (size_t)strtoull(env, NULL, 10);
+
+    env = getenv("NEURON_SHIM_MEMORY_PATTERN");
+    if (env) g_config.memory_pattern = (strcmp(env, "1") == 0);
+
+    env = getenv("NEURON_SHIM_ARENA_SHRINKAGE");
+    if (env) g_config.arena_shrinkage = (strcmp(env, "1") == 0);
+
+    env = getenv("NEURON_SHIM_MODEL_CACHE");
+    if (env) g_config.model_cache = (strcmp(env, "1") == 0);
+
+    env = getenv("NEURON_SHIM_HOT_SWAP");
+    if (env) g_config.hot_swap = (strcmp(env, "1") == 0);
+
+    env = getenv("NEURON_SHIM_GPU_PLACEMENT");
+    if (env) set_string(g_config.gpu_placement, sizeof(g_config.gpu_placement), "NEURON_SHIM_GPU_PLACEMENT", env);
+
+    env = getenv("NEURON_SHIM_GPU_DEVICE");
+    if (env) g_config.gpu_device = atoi(env);
+
+    env = getenv("NEURON_SHIM_GPU_COUNT");
+    if (env) g_config.gpu_count = atoi(env);
+
+    env = getenv("NEURON_SHIM_PINNED_MEMORY");
+    if (env) g_config.pinned_memory = (strcmp(env, "1") == 0);
+
+    env = getenv("NEURON_SHIM_TFLITE_ZERO_COPY");
+    if (env) g_config.tflite_zero_copy = (strcmp(env, "1") == 0);
+
+    env = getenv("NEURON_SHIM_TFLITE_DELEGATE");
+    if (env) set_string(g_config.tflite_delegate, sizeof(g_config.tflite_delegate), "NEURON_SHIM_TFLITE_DELEGATE", env);
+
+    env = getenv("NEURON_SHIM_XNNPACK_FP16");
+    if (env) g_config.xnnpack_fp16 = (strcmp(env, "1") == 0);
+
+    env = getenv("NEURON_SHIM_XNNPACK_CACHE_DIR");
+    if (env) set_string(g_config.xnnpack_cache_dir, sizeof(g_config.xnnpack_cache_dir), "NEURON_SHIM_XNNPACK_CACHE_DIR", env);
+
+    env = getenv("NEURON_SHIM_CACHE_DIR");
+    if (env) set_string(g_config.cache_dir, sizeof(g_config.cache_dir), "NEURON_SHIM_CACHE_DIR", env);
+
+    env = getenv("NEURON_SHIM_OPTIMIZED_MODEL_CACHE");
+    if (env) g_config.optimized_model_cache = (strcmp(env, "1") == 0);
+
+    env = getenv("NEURON_SHIM_TRT_ENGINE_CACHE");
+    if (env) g_config.trt_engine_cache = (strcmp(env, "1") == 0);
+
+    env = getenv("NEURON_SHIM_TRT_ENGINE_CACHE_PATH");
+    if (env) set_string(g_config.trt_engine_cache_path, sizeof(g_config.trt_engine_cache_path), "NEURON_SHIM_TRT_ENGINE_CACHE_PATH", env);
+
+    env = getenv("NEURON_SHIM_TRT_TIMING_CACHE");
+    if (env) g_config.trt_timing_cache = (strcmp(env, "1") == 0);
+
+    env = getenv("NEURON_SHIM_TRT_FP16");
+    if (env) g_config.trt_fp16 = (strcmp(env, "1") == 0);
+
+    env = getenv("NEURON_SHIM_TRT_INT8");
+    if (env) g_config.trt_int8 = (strcmp(env, "1") == 0);
+
+    env = getenv("NEURON_SHIM_TRT_MAX_WORKSPACE");
+    if (env) g_config.trt_max_workspace = (size_t)strtoull(env, NULL, 10);
+
+    env = getenv("NEURON_SHIM_PRELOAD");
+    if (env) set_string(g_config.preload, sizeof(g_config.preload), "NEURON_SHIM_PRELOAD", env);
+
+    env = getenv("NEURON_SHIM_WARMUP_RUNS");
+    if (env) g_config.warmup_runs = atoi(env);
+
+    env = getenv("NEURON_SHIM_QOS_SCHEDULER");
+    if (env) g_config.qos_scheduler = (strcmp(env, "1") == 0);
+
+    env = getenv("NEURON_SHIM_STATS_DUMP");
+    if (env) set_string(g_config.stats_dump, sizeof(g_config.stats_dump), "NEURON_SHIM_STATS_DUMP", env);
+
+    env = getenv("NEURON_SHIM_TRACE_FILE");
+    if (env) set_string(g_config.trace_file, sizeof(g_config.trace_file), "NEURON_SHIM_TRACE_FILE", env);
+
+    env = getenv("NEURON_SHIM_TRACE_SAMPLE_INPUTS");
+    if (env) g_config.trace_sample_inputs = atoi(env);
+
+    env = getenv("NEURON_SHIM_PROFILE_FILE");
+    if (env) set_string(g_config.profile_file, sizeof(g_config.profile_file), "NEURON_SHIM_PROFILE_FILE", env);
+
+    env = getenv("NEURON_SHIM_PROFILE_RUNS");
+    if (env) g_config.profile_runs = atoi(env);
+
+    return &g_config;
+}
+
+const NeuronShimConfig* neuron_shim_config_get(void) {
     return &g_config;
 }
 
@@ -93,10 +488,50 @@ const char* neuron_shim_config_get_suffix(const NeuronShimConfig* cfg) {
     if (strcmp(cfg->suffix, "auto") != 0)
         return cfg->suffix;
 
-    /* Derive from backend */
-    if (strcmp(cfg->backend, "tflite") == 0)
+    /* Derive from backend; plugin variants are named tflite-... */
+    if (strncmp(cfg->backend, "tflite", 6) == 0)
         return ".tflite";
 
     /* Default to .onnx (works for onnx, auto, and stub) */
     return ".onnx";
 }
+
+const char* neuron_shim_config_model_suffix(const NeuronShimConfig* cfg,
+                                            const NeuronShimModelConfig* mc) {
+    if (mc && mc->suffix[0] && strcmp(mc->suffix, "auto") != 0)
+        return mc->suffix;
+    if (mc && mc->backend[0])
+        return strncmp(mc->backend, "tflite", 6) == 0 ? ".tflite" : ".onnx";
+    return neuron_shim_config_get_suffix(cfg);
+}
+
+/* ------------------------------------------------------------------ */
+/* Shim-managed cache directories                                      */
+/* ------------------------------------------------------------------ */
+int neuron_shim_config_cache_subdir(const NeuronShimConfig* cfg, const char* sub,
+                                    char* out, size_t len) {
+    if (!cfg->cache_dir[0]) return -1;
+
+    int n = snprintf(out, len, "%s/%s", cfg->cache_dir, sub);
+    if (n < 0 || (size_t)n >= len) return -1;
+
+    /* mkdir -p: create each component in turn */
+    for (char* p = out + 1; ; p++) {
+        if (*p != '/' && *p != '\0') continue;
+        if (p[-1] == '/') {             /* "a//b" or trailing slash */
+            if (*p == '\0') break;
+            continue;
+        }
+        char c = *p;
+        *p = '\0';
+        int rc = mkdir(out, 0755);
+        *p = c;
+        if (rc != 0 && errno != EEXIST) {
+            SHIM_WARN(NULL, "WARNING: can't create cache dir %s: %s",
+                      out, strerror(errno));
+            return -1;
+        }
+        if (c == '\0') break;
+    }
+    return 0;
+}
@@ -0,0 +1,642 @@
+/*
+ * neuron-shim: Tensor conversion kernels
+ *
+ * Every SIMD kernel processes whole vectors and returns how many
+ * elements it handled; the scalar loop finishes the tail, and does all
+ * of the work on CPUs without the extension. The scalar code mirrors
+ * the vector instructions (clamp before rounding, round half to even,
+ * multiply by 1/scale) so results don't depend on which path ran.
+ *
+ * NEON kernels need AArch64 (vcvtnq, vmaxnmq, fp16 conversions); 32-bit
+ * ARM builds use the scalar paths.
+ */
+
+#include "convert.h"
+#include "log.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SHIM_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define SHIM_NEON 1
+#endif
+
+#define TAG "convert"
+
+/* Quantized values are clamped to this before rounding; wide enough for
+ * any 8-bit result, narrow enough that every path converts it exactly */
+#define QMIN -32768.0f
+#define QMAX  32767.0f
+
+#ifdef SHIM_X86
+static inline bool have_avx2(void) {
+    return __builtin_cpu_supports("avx2");
+}
+
+static inline bool have_f16c(void) {
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c");
+}
+#endif
+
+static inline int32_t clamp_i32(int32_t v, int32_t lo, int32_t hi) {
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+static inline int32_t quantize_one(float x, float inv, int32_t zero_point) {
+    float v = fminf(fmaxf(x * inv, QMIN), QMAX);
+    return (int32_t)nearbyintf(v) + zero_point;
+}
+
+/* ------------------------------------------------------------------ */
+/* Dequantize                                                          */
+/* ------------------------------------------------------------------ */
+#ifdef SHIM_X86
+__attribute__((target("avx2")))
+static size_t dequantize_u8_avx2(const uint8_t* src, float* dst, size_t n,
+                                 float scale, int32_t zero_point) {
+    const __m256  vs = _mm256_set1_ps(scale);
+    const __m256i vz = _mm256_set1_epi32(zero_point);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i b = _mm_loadl_epi64((const __m128i*)(src + i));
+        __m256i v = _mm256_sub_epi32(_mm256_cvtepu8_epi32(b), vz);
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), vs));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t dequantize_s8_avx2(const int8_t* src, float* dst, size_t n,
+                                 float scale, int32_t zero_point) {
+    const __m256  vs = _mm256_set1_ps(scale);
+    const __m256i vz = _mm256_set1_epi32(zero_point);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i b = _mm_loadl_epi64((const __m128i*)(src + i));
+        __m256i v = _mm256_sub_epi32(_mm256_cvtepi8_epi32(b), vz);
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), vs));
+    }
+    return i;
+}
+#endif
+
+#ifdef SHIM_NEON
+static inline void dequantize_s16x8_neon(int16x8_t v, float* dst,
+                                         float32x4_t vs, int32x4_t vz) {
+    int32x4_t lo = vsubq_s32(vmovl_s16(vget_low_s16(v)), vz);
+    int32x4_t hi = vsubq_s32(vmovl_s16(vget_high_s16(v)), vz);
+    vst1q_f32(dst,     vmulq_f32(vcvtq_f32_s32(lo), vs));
+    vst1q_f32(dst + 4, vmulq_f32(vcvtq_f32_s32(hi), vs));
+}
+
+static size_t dequantize_u8_neon(const uint8_t* src, float* dst, size_t n,
+                                 float scale, int32_t zero_point) {
+    const float32x4_t vs = vdupq_n_f32(scale);
+    const int32x4_t   vz = vdupq_n_s32(zero_point);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t b = vld1q_u8(src + i);
+        dequantize_s16x8_neon(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(b))),
+                              dst + i, vs, vz);
+        dequantize_s16x8_neon(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(b))),
+                              dst + i + 8, vs, vz);
+    }
+    return i;
+}
+
+static size_t dequantize_s8_neon(const int8_t* src, float* dst, size_t n,
+                                 float scale, int32_t zero_point) {
+    const float32x4_t vs = vdupq_n_f32(scale);
+    const int32x4_t   vz = vdupq_n_s32(zero_point);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        int8x16_t b = vld1q_s8(src + i);
+        dequantize_s16x8_neon(vmovl_s8(vget_low_s8(b)),  dst + i,     vs, vz);
+        dequantize_s16x8_neon(vmovl_s8(vget_high_s8(b)), dst + i + 8, vs, vz);
+    }
+    return i;
+}
+#endif
+
+void neuron_shim_dequantize_u8(const uint8_t* src, float* dst, size_t n,
+                               float scale, int32_t zero_point) {
+    size_t i = 0;
+#if defined(SHIM_X86)
+    if (have_avx2()) i = dequantize_u8_avx2(src, dst, n, scale, zero_point);
+#elif defined(SHIM_NEON)
+    i = dequantize_u8_neon(src, dst, n, scale, zero_point);
+#endif
+    for (; i < n; i++)
+        dst[i] = (float)((int32_t)src[i] - zero_point) * scale;
+}
+
+void neuron_shim_dequantize_s8(const int8_t* src, float* dst, size_t n,
+                               float scale, int32_t zero_point) {
+    size_t i = 0;
+#if defined(SHIM_X86)
+    if (have_avx2()) i = dequantize_s8_avx2(src, dst, n, scale, zero_point);
+#elif defined(SHIM_NEON)
+    i = dequantize_s8_neon(src, dst, n, scale, zero_point);
+#endif
+    for (; i < n; i++)
+        dst[i] = (float)((int32_t)src[i] - zero_point) * scale;
+}
+
+/* ------------------------------------------------------------------ */
+/* Quantize                                                            */
+/* ------------------------------------------------------------------ */
+#ifdef SHIM_X86
+__attribute__((target("avx2")))
+static inline __m256i quantize_x8_avx2(const float* src, __m256 vinv,
+                                       __m256i vz) {
+    __m256 v = _mm256_mul_ps(_mm256_loadu_ps(src), vinv);
+    /* max/min return the second operand for NaN, like fmaxf/fminf */
+    v = _mm256_min_ps(_mm256_max_ps(v, _mm256_set1_ps(QMIN)),
+                      _mm256_set1_ps(QMAX));
+    return _mm256_add_epi32(_mm256_cvtps_epi32(v), vz);
+}
+
+__attribute__((target("avx2")))
+static size_t quantize_8bit_avx2(const float* src, void* dst, size_t n,
+                                 float inv, int32_t zero_point, bool is_signed) {
+    const __m256  vinv = _mm256_set1_ps(inv);
+    const __m256i vz   = _mm256_set1_epi32(zero_point);
+    /* packs/packus interleave 128-bit lanes; this puts dwords back in order */
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i ab = _mm256_packs_epi32(quantize_x8_avx2(src + i,      vinv, vz),
+                                        quantize_x8_avx2(src + i + 8,  vinv, vz));
+        __m256i cd = _mm256_packs_epi32(quantize_x8_avx2(src + i + 16, vinv, vz),
+                                        quantize_x8_avx2(src + i + 24, vinv, vz));
+        __m256i r = is_signed ? _mm256_packs_epi16(ab, cd)
+                              : _mm256_packus_epi16(ab, cd);
+        r = _mm256_permutevar8x32_epi32(r, order);
+        _mm256_storeu_si256((__m256i*)((uint8_t*)dst + i), r);
+    }
+    return i;
+}
+#endif
+
+#ifdef SHIM_NEON
+static inline int16x8_t quantize_x8_neon(const float* src, float32x4_t vinv,
+                                         int32x4_t vz) {
+    const float32x4_t lo = vdupq_n_f32(QMIN), hi = vdupq_n_f32(QMAX);
+    /* maxnm/minnm return the number for NaN, like fmaxf/fminf */
+    float32x4_t a = vminnmq_f32(vmaxnmq_f32(vmulq_f32(vld1q_f32(src), vinv), lo), hi);
+    float32x4_t b = vminnmq_f32(vmaxnmq_f32(vmulq_f32(vld1q_f32(src + 4), vinv), lo), hi);
+    int32x4_t qa = vaddq_s32(vcvtnq_s32_f32(a), vz);
+    int32x4_t qb = vaddq_s32(vcvtnq_s32_f32(b), vz);
+    return vcombine_s16(vqmovn_s32(qa), vqmovn_s32(qb));
+}
+
+static size_t quantize_8bit_neon(const float* src, void* dst, size_t n,
+                                 float inv, int32_t zero_point, bool is_signed) {
+    const float32x4_t vinv = vdupq_n_f32(inv);
+    const int32x4_t   vz   = vdupq_n_s32(zero_point);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        int16x8_t a = quantize_x8_neon(src + i,     vinv, vz);
+        int16x8_t b = quantize_x8_neon(src + i + 8, vinv, vz);
+        if (is_signed)
+            vst1q_s8((int8_t*)dst + i, vcombine_s8(vqmovn_s16(a), vqmovn_s16(b)));
+        else
+            vst1q_u8((uint8_t*)dst + i, vcombine_u8(vqmovun_s16(a), vqmovun_s16(b)));
+    }
+    return i;
+}
+#endif
+
+void neuron_shim_quantize_u8(const float* src, uint8_t* dst, size_t n,
+                             float scale, int32_t zero_point) {
+    float  inv = 1.0f / scale;
+    size_t i = 0;
+#if defined(SHIM_X86)
+    if (have_avx2()) i = quantize_8bit_avx2(src, dst, n, inv, zero_point, false);
+#elif defined(SHIM_NEON)
+    i = quantize_8bit_neon(src, dst, n, inv, zero_point, false);
+#endif
+    for (; i < n; i++)
+        dst[i] = (uint8_t)clamp_i32(quantize_one(src[i], inv, zero_point), 0, 255);
+}
+
+void neuron_shim_quantize_s8(const float* src, int8_t* dst, size_t n,
+                             float scale, int32_t zero_point) {
+    float  inv = 1.0f / scale;
+    size_t i = 0;
+#if defined(SHIM_X86)
+    if (have_avx2()) i = quantize_8bit_avx2(src, dst, n, inv, zero_point, true);
+#elif defined(SHIM_NEON)
+    i = quantize_8bit_neon(src, dst, n, inv, zero_point, true);
+#endif
+    for (; i < n; i++)
+        dst[i] = (int8_t)clamp_i32(quantize_one(src[i], inv, zero_point),
+                                   -128, 127);
+}
+
+/* ------------------------------------------------------------------ */
+/* fp16                                                                */
+/* ------------------------------------------------------------------ */
+static uint16_t f32_to_f16_one(float value) {
+    const uint32_t f32_inf   = 255u << 23;
+    const uint32_t f16_max   = (127u + 16u) << 23;   /* 65536.0f */
+    const uint32_t denorm_u  = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+    uint32_t f;
+    memcpy(&f, &value, sizeof(f));
+
+    uint32_t sign = f & 0x80000000u;
+    f ^= sign;
+
+    uint16_t h;
+    if (f >= f16_max) {
+        /* Inf stays Inf; NaN keeps its top payload bits and is quieted */
+        h = f > f32_inf ? (uint16_t)(0x7e00 | ((f >> 13) & 0x3ff)) : 0x7c00;
+    } else if (f < (113u << 23)) {
+        /* Half subnormal (or zero): let the FPU round the mantissa */
+        float fv, magic;
+        memcpy(&fv, &f, sizeof(fv));
+        memcpy(&magic, &denorm_u, sizeof(magic));
+        fv += magic;
+        uint32_t r;
+        memcpy(&r, &fv, sizeof(r));
+        h = (uint16_t)(r - denorm_u);
+    } else {
+        uint32_t mant_odd = (f >> 13) & 1;
+        f += ((uint32_t)(15 - 127) << 23) + 0xfff;   /* rebias, round */
+        f += mant_odd;                                /* ... to even */
+        h = (uint16_t)(f >> 13);
+    }
+    return (uint16_t)(h | (sign >> 16));
+}
+
+static float f16_to_f32_one(uint16_t h) {
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t exp  = (h >> 10) & 0x1f;
+    uint32_t mant = h & 0x3ff;
+    uint32_t f;
+
+    if (exp == 0x1f) {
+        /* Inf, or NaN quieted the way hardware converters do */
+        f = sign | 0x7f800000u | (mant << 13) | (mant ? 0x400000u : 0);
+    } else if (exp) {
+        f = sign | ((exp + 112) << 23) | (mant << 13);
+    } else if (!mant) {
+        f = sign;
+    } else {
+        /* Subnormal half: normalize into a regular float */
+        exp = 113;
+        while (!(mant & 0x400)) { mant <<= 1; exp--; }
+        f = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+    }
+
+    float out;
+    memcpy(&out, &f, sizeof(out));
+    return out;
+}
+
+#ifdef SHIM_X86
+__attribute__((target("avx2,f16c")))
+static size_t f32_to_f16_f16c(const float* src, uint16_t* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm_storeu_si128((__m128i*)(dst + i),
+                         _mm256_cvtps_ph(_mm256_loadu_ps(src + i),
+                                         _MM_FROUND_TO_NEAREST_INT));
+    return i;
+}
+
+__attribute__((target("avx2,f16c")))
+static size_t f16_to_f32_f16c(const uint16_t* src, float* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(dst + i,
+                         _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(src + i))));
+    return i;
+}
+#endif
+
+#ifdef SHIM_NEON
+static size_t f32_to_f16_neon(const float* src, uint16_t* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+    return i;
+}
+
+static size_t f16_to_f32_neon(const uint16_t* src, float* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+    return i;
+}
+#endif
+
+void neuron_shim_f32_to_f16(const float* src, uint16_t* dst, size_t n) {
+    size_t i = 0;
+#if defined(SHIM_X86)
+    if (have_f16c()) i = f32_to_f16_f16c(src, dst, n);
+#elif defined(SHIM_NEON)
+    i = f32_to_f16_neon(src, dst, n);
+#endif
+    for (; i < n; i++) dst[i] = f32_to_f16_one(src[i]);
+}
+
+void neuron_shim_f16_to_f32(const uint16_t* src, float* dst, size_t n) {
+    size_t i = 0;
+#if defined(SHIM_X86)
+    if (have_f16c()) i = f16_to_f32_f16c(src, dst, n);
+#elif defined(SHIM_NEON)
+    i = f16_to_f32_neon(src, dst, n);
+#endif
+    for (; i < n; i++) dst[i] = f16_to_f32_one(src[i]);
+}
+
+/* ------------------------------------------------------------------ */
+/* Layout                                                              */
+/* ------------------------------------------------------------------ */
+#define TILE 32
+
+/* dst[j][i] = src[i][j] for a rows x cols matrix, in cache-sized tiles */
+#define DEFINE_TRANSPOSE(name, T) \
+    static void name(const T* src, T* dst, size_t rows, size_t cols) { \
+        for (size_t i0 = 0; i0 < rows; i0 += TILE) { \
+            size_t i1 = i0 + TILE < rows ? i0 + TILE : rows; \
+            for (size_t j0 = 0; j0 < cols; j0 += TILE) { \
+                size_t j1 = j0 + TILE < cols ? j0 + TILE : cols; \
+                for (size_t i = i0; i < i1; i++) \
+                    for (size_t j = j0; j < j1; j++) \
+                        dst[j * rows + i] = src[i * cols + j]; \
+            } \
+        } \
+    }
+
+DEFINE_TRANSPOSE(transpose_8,  uint8_t)
+DEFINE_TRANSPOSE(transpose_16, uint16_t)
+DEFINE_TRANSPOSE(transpose_32, uint32_t)
+DEFINE_TRANSPOSE(transpose_64, uint64_t)
+
+static void transpose_batches(const void* src, void* dst, size_t n,
+                              size_t rows, size_t cols, size_t elem) {
+    size_t plane = rows * cols * elem;
+    for (size_t b = 0; b < n; b++) {
+        const void* s = (const uint8_t*)src + b * plane;
+        void*       d = (uint8_t*)dst + b * plane;
+        if (rows == 1 || cols == 1) {
+            memcpy(d, s, plane);
+            continue;
+        }
+        switch (elem) {
+        case 1: transpose_8(s, d, rows, cols);  break;
+        case 2: transpose_16(s, d, rows, cols); break;
+        case 4: transpose_32(s, d, rows, cols); break;
+        case 8: transpose_64(s, d, rows, cols); break;
+        }
+    }
+}
+
+void neuron_shim_nhwc_to_nchw(const void* src, void* dst, size_t n, size_t h,
+                              size_t w, size_t c, size_t elem) {
+    transpose_batches(src, dst, n, h * w, c, elem);
+}
+
+void neuron_shim_nchw_to_nhwc(const void* src, void* dst, size_t n, size_t h,
+                              size_t w, size_t c, size_t elem) {
+    transpose_batches(src, dst, n, c, h * w, elem);
+}
+
+/* ------------------------------------------------------------------ */
+/* Element conversion between two tensor formats                       */
+/* ------------------------------------------------------------------ */
+typedef struct {
+    uint32_t type;
+    float    scale;
+    int32_t  zero_point;
+} Elem;
+
+size_t neuron_shim_type_size(uint32_t type) {
+    switch (type) {
+    case NEURON_SHIM_TYPE_FLOAT32: return 4;
+    case NEURON_SHIM_TYPE_UINT8:   return 1;
+    case NEURON_SHIM_TYPE_INT8:    return 1;
+    case NEURON_SHIM_TYPE_FLOAT16: return 2;
+    case NEURON_SHIM_TYPE_INT16:   return 2;
+    case NEURON_SHIM_TYPE_INT32:   return 4;
+    case NEURON_SHIM_TYPE_INT64:   return 8;
+    case NEURON_SHIM_TYPE_BOOL:    return 1;
+    default:                       return 0;
+    }
+}
+
+static bool is_quantized(uint32_t type) {
+    return type == NEURON_SHIM_TYPE_UINT8 || type == NEURON_SHIM_TYPE_INT8;
+}
+
+/* Types that go through the float32 path */
+static bool is_convertible(uint32_t type) {
+    return type == NEURON_SHIM_TYPE_FLOAT32 || type == NEURON_SHIM_TYPE_FLOAT16 ||
+           is_quantized(type);
+}
+
+/* Same bytes on both sides: a raw copy (or just a transpose) will do */
+static bool same_format(Elem a, Elem b) {
+    if (a.type != b.type) return false;
+    if (!is_quantized(a.type) || a.scale <= 0 || b.scale <= 0) return true;
+    return a.scale == b.scale && a.zero_point == b.zero_point;
+}
+
+static void decode(const void* src, Elem s, float* dst, size_t n) {
+    switch (s.type) {
+    case NEURON_SHIM_TYPE_FLOAT32: memcpy(dst, src, n * sizeof(float)); break;
+    case NEURON_SHIM_TYPE_FLOAT16: neuron_shim_f16_to_f32(src, dst, n); break;
+    case NEURON_SHIM_TYPE_UINT8:
+        neuron_shim_dequantize_u8(src, dst, n, s.scale, s.zero_point);
+        break;
+    case NEURON_SHIM_TYPE_INT8:
+        neuron_shim_dequantize_s8(src, dst, n, s.scale, s.zero_point);
+        break;
+    }
+}
+
+static void encode(const float* src, void* dst, Elem d, size_t n) {
+    switch (d.type) {
+    case NEURON_SHIM_TYPE_FLOAT32: memcpy(dst, src, n * sizeof(float)); break;
+    case NEURON_SHIM_TYPE_FLOAT16: neuron_shim_f32_to_f16(src, dst, n); break;
+    case NEURON_SHIM_TYPE_UINT8:
+        neuron_shim_quantize_u8(src, dst, n, d.scale, d.zero_point);
+        break;
+    case NEURON_SHIM_TYPE_INT8:
+        neuron_shim_quantize_s8(src, dst, n, d.scale, d.zero_point);
+        break;
+    }
+}
+
+static void convert_elems(const void* src, Elem s, void* dst, Elem d, size_t n) {
+    if (same_format(s, d)) {
+        memcpy(dst, src, n * neuron_shim_type_size(s.type));
+    } else if (s.type == NEURON_SHIM_TYPE_FLOAT32) {
+        encode(src, dst, d, n);
+    } else if (d.type == NEURON_SHIM_TYPE_FLOAT32) {
+        decode(src, s, dst, n);
+    } else {
+        /* e.g. uint8 -> fp16: through float32 in L1-sized chunks */
+        float  tmp[1024];
+        size_t ss = neuron_shim_type_size(s.type);
+        size_t ds = neuron_shim_type_size(d.type);
+        for (size_t i = 0; i < n; i += 1024) {
+            size_t k = n - i < 1024 ? n - i : 1024;
+            decode((const uint8_t*)src + i * ss, s, tmp, k);
+            encode(tmp, (uint8_t*)dst + i * ds, d, k);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Per-tensor plans                                                    */
+/* ------------------------------------------------------------------ */
+static size_t elem_count(const ShimTensorDesc* d) {
+    size_t count = 1;
+    for (uint32_t i = 0; i < d->rank; i++) count *= d->dims[i];
+    return count;
+}
+
+static Elem app_elem(const ShimTensorConv* t) {
+    return (Elem){ t->app.type, t->app.scale, t->app.zeroPoint };
+}
+
+static Elem model_elem(const ShimTensorConv* t) {
+    return (Elem){ t->model.type, t->model.scale, t->model.zero_point };
+}
+
+int neuron_shim_conv_setup(ShimTensorConv* t, const NeuronShimTensorConv* spec,
+                           const ShimTensorDesc* model, const char* what) {
+    memset(t, 0, sizeof(*t));
+    t->model = *model;
+
+    uint32_t type = spec->type == NEURON_SHIM_TYPE_UNKNOWN ? model->type
+                                                            : spec->type;
+    size_t app_size   = neuron_shim_type_size(type);
+    size_t model_size = neuron_shim_type_size(model->type);
+    if (!app_size || !model_size ||
+        (type != model->type &&
+         (!is_convertible(type) || !is_convertible(model->type)))) {
+        SHIM_ERR(TAG, "%s: can't convert between type %u (app) and %u (model)",
+                 what, type, model->type);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < model->rank; i++) {
+        if (model->dims[i] == 0) {
+            SHIM_ERR(TAG, "%s: model tensor has dynamic dims", what);
+            return -1;
+        }
+    }
+    size_t count = elem_count(model);
+    if (count * model_size != model->size) {
+        SHIM_ERR(TAG, "%s: model tensor is %zu bytes, expected %zu",
+                 what, model->size, count * model_size);
+        return -1;
+    }
+
+    t->transpose = spec->nhwc;
+    if (t->transpose && model->rank != 4) {
+        SHIM_ERR(TAG, "%s: nhwc needs a 4-D model tensor, got %u-D",
+                 what, model->rank);
+        return -1;
+    }
+
+    /* App-side quantization: from the config, else the same as the model */
+    t->app.type      = type;
+    t->app.scale     = spec->scale > 0 ? spec->scale : model->scale;
+    t->app.zeroPoint = spec->scale > 0 ? spec->zero_point : model->zero_point;
+    if (!is_quantized(type)) {
+        t->app.scale     = 0;
+        t->app.zeroPoint = 0;
+    }
+    if (is_quantized(type) && !same_format(app_elem(t), model_elem(t)) &&
+        (t->app.scale <= 0 ||
+         (is_quantized(model->type) && model->scale <= 0))) {
+        SHIM_ERR(TAG, "%s: quantized conversion needs a scale", what);
+        return -1;
+    }
+    if (is_quantized(model->type) && !is_quantized(type) && model->scale <= 0) {
+        SHIM_ERR(TAG, "%s: model tensor has no quantization params", what);
+        return -1;
+    }
+
+    /* What the app sees: its own type, and NHWC dims if transposed */
+    t->app.dimensionCount = model->rank;
+    for (uint32_t i = 0; i < model->rank; i++)
+        t->app.dimensions[i] = model->dims[i];
+    if (t->transpose) {
+        t->app.dimensions[1] = model->dims[2];   /* H */
+        t->app.dimensions[2] = model->dims[3];   /* W */
+        t->app.dimensions[3] = model->dims[1];   /* C */
+    }
+    t->app.sizeBytes = count * app_size;
+
+    /* 64-byte aligned so backends can bind it without copying */
+    t->staging = aligned_alloc(64, (model->size + 63) & ~(size_t)63);
+    if (!t->staging) return -1;
+
+    if (t->transpose && !same_format(app_elem(t), model_elem(t))) {
+        size_t narrow = app_size < model_size ? app_size : model_size;
+        t->scratch = malloc(count * narrow);
+        if (!t->scratch) {
+            neuron_shim_conv_free(t);
+            return -1;
+        }
+    }
+
+    SHIM_INFO(TAG, "%s: app type %u%s -> model type %u%s, %zu elements",
+              what, type, t->transpose ? " NHWC" : "", model->type,
+              t->transpose ? " NCHW" : "", count);
+    return 0;
+}
+
+void neuron_shim_conv_free(ShimTensorConv* t) {
+    free(t->staging);
+    free(t->scratch);
+    t->staging = t->scratch = NULL;
+}
+
+/* Convert one tensor, transposing on the narrower side of the two */
+static void run(const ShimTensorConv* t, const void* src, Elem s,
+                void* dst, Elem d, bool to_nchw) {
+    size_t count = elem_count(&t->model);
+    if (!t->transpose) {
+        convert_elems(src, s, dst, d, count);
+        return;
+    }
+
+    size_t n = t->model.dims[0], c = t->model.dims[1];
+    size_t h = t->model.dims[2], w = t->model.dims[3];
+    void (*transpose)(const void*, void*, size_t, size_t, size_t, size_t, size_t) =
+        to_nchw ? neuron_shim_nhwc_to_nchw : neuron_shim_nchw_to_nhwc;
+
+    size_t ss = neuron_shim_type_size(s.type);
+    size_t ds = neuron_shim_type_size(d.type);
+    if (same_format(s, d)) {
+        transpose(src, dst, n, h, w, c, ss);
+    } else if (ss <= ds) {
+        transpose(src, t->scratch, n, h, w, c, ss);
+        convert_elems(t->scratch, s, dst, d, count);
+    } else {
+        convert_elems(src, s, t->scratch, d, count);
+        transpose(t->scratch, dst, n, h, w, c, ds);
+    }
+}
+
+void neuron_shim_conv_to_model(const ShimTensorConv* t) {
+    if (t->app_buf)
+        run(t, t->app_buf, app_elem(t), t->staging, model_elem(t), true);
+}
+
+void neuron_shim_conv_to_app(const ShimTensorConv* t) {
+    if (t->app_buf)
+        run(t, t->staging, model_elem(t), t->app_buf, app_elem(t), false);
+}
@@ -0,0 +1,132 @@
+/*
+ * neuron-shim: CPU sets for inference threads
+ */
+
+#define _GNU_SOURCE
+#include "cpu_affinity.h"
+#include "log.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TAG "affinity"
+
+_Static_assert(sizeof(NeuronShimCpuMask) == sizeof(cpu_set_t),
+               "NeuronShimCpuMask must match cpu_set_t");
+
+/* "0-3,6" into 'mask' */
+static int parse_list(const char* list, cpu_set_t* mask) {
+    const char* p = list;
+    while (*p) {
+        char* end;
+        long lo = strtol(p, &end, 10), hi = lo;
+        if (end == p || lo < 0) return -1;
+        if (*end == '-') {
+            p = end + 1;
+            hi = strtol(p, &end, 10);
+            if (end == p || hi < lo) return -1;
+        }
+        for (long c = lo; c <= hi && c < NEURON_SHIM_MAX_CPUS; c++)
+            CPU_SET((int)c, mask);
+        p = end;
+        while (*p == ',' || *p == '\n' || *p == ' ') p++;
+        if (*p && (*p < '0' || *p > '9')) return -1;
+    }
+    return 0;
+}
+
+static int read_sysfs(const char* path, char* buf, size_t len) {
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+    size_t n = fread(buf, 1, len - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+    return n ? 0 : -1;
+}
+
+/*
+ * Cores within 75% of the highest cpu_capacity count as big: prime and
+ * big clusters on tri-cluster SoCs, not the little ones.
+ */
+static void capacity_split(const cpu_set_t* allowed, bool big, cpu_set_t* mask) {
+    int  cap[NEURON_SHIM_MAX_CPUS];
+    int  max_cap = 0;
+    bool have = false;
+
+    for (int c = 0; c < NEURON_SHIM_MAX_CPUS; c++) {
+        cap[c] = -1;
+        if (!CPU_ISSET(c, allowed)) continue;
+
+        char path[96], buf[32];
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu%d/cpu_capacity", c);
+        if (read_sysfs(path, buf, sizeof(buf)) != 0) continue;
+        cap[c] = atoi(buf);
+        if (cap[c] > max_cap) max_cap = cap[c];
+        have = true;
+    }
+
+    for (int c = 0; c < NEURON_SHIM_MAX_CPUS; c++) {
+        if (!CPU_ISSET(c, allowed)) continue;
+        bool is_big = !have || cap[c] < 0 || cap[c] * 4 >= max_cap * 3;
+        if (is_big == big) CPU_SET(c, mask);
+    }
+}
+
+int neuron_shim_cpuset_parse(const char* spec, NeuronShimCpuSet* out) {
+    out->count = 0;
+    if (!spec || !spec[0]) return 0;
+
+    cpu_set_t allowed, mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        CPU_ZERO(&allowed);
+        for (int c = 0; c < NEURON_SHIM_MAX_CPUS; c++) CPU_SET(c, &allowed);
+    }
+
+    int node;
+    if (strcmp(spec, "big") == 0 || strcmp(spec, "little") == 0) {
+        capacity_split(&allowed, spec[0] == 'b', &mask);
+    } else if (sscanf(spec, "numa:%d", &node) == 1) {
+        char path[96], buf[4096];
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/node/node%d/cpulist", node);
+        if (read_sysfs(path, buf, sizeof(buf)) != 0 || parse_list(buf, &mask) != 0) {
+            SHIM_WARN(TAG, "WARNING: no NUMA node %d", node);
+            return -1;
+        }
+    } else if (parse_list(spec, &mask) != 0) {
+        SHIM_WARN(TAG, "WARNING: bad cpu_affinity '%s'", spec);
+        return -1;
+    }
+
+    for (int c = 0; c < NEURON_SHIM_MAX_CPUS; c++)
+        if (CPU_ISSET(c, &mask) && CPU_ISSET(c, &allowed))
+            out->cpus[out->count++] = c;
+    if (out->count == 0) {
+        SHIM_WARN(TAG, "WARNING: cpu_affinity '%s' selects no usable CPU", spec);
+        return -1;
+    }
+    return 0;
+}
+
+bool neuron_shim_cpuset_enter(const NeuronShimCpuSet* set, NeuronShimCpuMask* saved) {
+    if (!set || set->count == 0) return false;
+
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (int i = 0; i < set->count; i++) CPU_SET(set->cpus[i], &mask);
+
+    if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                               (cpu_set_t*)saved) != 0)
+        return false;
+    return pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+}
+
+void neuron_shim_cpuset_leave(const NeuronShimCpuMask* saved) {
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                           (const cpu_set_t*)saved);
+}
@@ -0,0 +1,268 @@
+/*
+ * neuron-shim: Host memory allocator for APU buffers
+ *
+ * Blocks are rounded up to a power-of-two size class between 4 KB and
+ * 64 MB; freed blocks go onto a per-class free list (bounded in count
+ * and total bytes) and are handed out again before anything new is
+ * allocated. Larger requests are allocated and freed directly.
+ *
+ * Live blocks are kept in an array sorted by address, so the per-frame
+ * "is this setInput buffer ours, and pinned?" question is a binary
+ * search under a read lock — and a single atomic load when the app
+ * never allocated through apusys at all.
+ *
+ * Pinned memory comes from the GPU runtime the backend already loaded;
+ * its host allocator is looked up with dlsym so the shim never links
+ * against CUDA or HIP.
+ */
+
+#include "host_mem.h"
+#include "log.h"
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TAG "mem"
+
+#define ALIGN       4096    /* DMA engines want at least page alignment */
+#define MIN_SHIFT   12      /* smallest class: 4 KB */
+#define MAX_SHIFT   26      /* largest class: 64 MB; bigger isn't pooled */
+#define NUM_CLASSES (MAX_SHIFT - MIN_SHIFT + 1)
+#define FREE_PER_CLASS 16
+#define POOL_LIMIT  ((size_t)256 << 20)   /* free bytes kept around */
+
+typedef struct {
+    char*             base;
+    size_t            cap;
+    int               cls;      /* size class, -1 = unpooled */
+    NeuronShimMemKind kind;
+} Block;
+
+/* cudaHostAlloc/hipHostMalloc and their frees share these signatures */
+typedef int (*HostAllocFn)(void** ptr, size_t size, unsigned int flags);
+typedef int (*HostFreeFn)(void* ptr);
+
+static struct {
+    HostAllocFn alloc;
+    HostFreeFn  free;
+} g_pinned[3];
+
+static pthread_rwlock_t  g_lock = PTHREAD_RWLOCK_INITIALIZER;
+static NeuronShimMemKind g_kind = NEURON_SHIM_MEM_PAGEABLE;
+
+static Block*         g_live;         /* sorted by base */
+static size_t         g_live_cap;
+static _Atomic size_t g_live_count;
+
+static Block  g_free[NUM_CLASSES][FREE_PER_CLASS];
+static int    g_free_count[NUM_CLASSES];
+static size_t g_free_bytes;
+
+/* ------------------------------------------------------------------ */
+/* Raw blocks                                                          */
+/* ------------------------------------------------------------------ */
+static int size_class(size_t size) {
+    for (int s = MIN_SHIFT; s <= MAX_SHIFT; s++)
+        if (size <= (size_t)1 << s) return s - MIN_SHIFT;
+    return -1;
+}
+
+/* Falls back to pageable memory if the pinned allocator fails */
+static char* raw_alloc(size_t cap, NeuronShimMemKind kind,
+                       NeuronShimMemKind* got) {
+    void* p = NULL;
+    if (kind != NEURON_SHIM_MEM_PAGEABLE) {
+        if (g_pinned[kind].alloc(&p, cap, 0) == 0 && p) {
+            *got = kind;
+            return p;
+        }
+        SHIM_WARN(TAG, "WARNING: pinned allocation of %zu bytes failed, "
+                  "using pageable memory", cap);
+        p = NULL;
+    }
+    if (posix_memalign(&p, ALIGN, cap) != 0) return NULL;
+    *got = NEURON_SHIM_MEM_PAGEABLE;
+    return p;
+}
+
+static void raw_free(const Block* b) {
+    if (b->kind == NEURON_SHIM_MEM_PAGEABLE)
+        free(b->base);
+    else
+        g_pinned[b->kind].free(b->base);
+}
+
+/* ------------------------------------------------------------------ */
+/* Live block index (callers hold g_lock)                              */
+/* ------------------------------------------------------------------ */
+/* Index of the first live block with base > p */
+static size_t live_upper(const void* p) {
+    size_t lo = 0, hi = atomic_load_explicit(&g_live_count, memory_order_relaxed);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if ((const char*)p < g_live[mid].base) hi = mid;
+        else lo = mid + 1;
+    }
+    return lo;
+}
+
+static int live_insert(const Block* b) {
+    size_t n = atomic_load_explicit(&g_live_count, memory_order_relaxed);
+    if (n == g_live_cap) {
+        size_t cap = g_live_cap ? g_live_cap * 2 : 64;
+        Block* live = realloc(g_live, cap * sizeof(Block));
+        if (!live) return -1;
+        g_live     = live;
+        g_live_cap = cap;
+    }
+    size_t at = live_upper(b->base);
+    memmove(&g_live[at + 1], &g_live[at], (n - at) * sizeof(Block));
+    g_live[at] = *b;
+    atomic_store(&g_live_count, n + 1);
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                          */
+/* ------------------------------------------------------------------ */
+void* neuron_shim_mem_alloc(size_t size) {
+    if (size == 0) size = 1;
+
+    Block b = { .cls = size_class(size) };
+    b.cap = b.cls >= 0 ? (size_t)1 << (b.cls + MIN_SHIFT)
+                       : (size + ALIGN - 1) / ALIGN * ALIGN;
+
+    pthread_rwlock_wrlock(&g_lock);
+    NeuronShimMemKind kind = g_kind;
+    if (b.cls >= 0 && g_free_count[b.cls] > 0) {
+        b = g_free[b.cls][--g_free_count[b.cls]];
+        g_free_bytes -= b.cap;
+    }
+    pthread_rwlock_unlock(&g_lock);
+
+    if (!b.base) {
+        b.base = raw_alloc(b.cap, kind, &b.kind);
+        if (!b.base) return NULL;
+    }
+    memset(b.base, 0, size);   /* apusys_mem_alloc used to calloc */
+
+    pthread_rwlock_wrlock(&g_lock);
+    int rc = live_insert(&b);
+    pthread_rwlock_unlock(&g_lock);
+    if (rc != 0) {
+        raw_free(&b);
+        return NULL;
+    }
+    return b.base;
+}
+
+int neuron_shim_mem_free(void* p) {
+    if (!p) return 0;
+
+    pthread_rwlock_wrlock(&g_lock);
+    size_t n  = atomic_load_explicit(&g_live_count, memory_order_relaxed);
+    size_t at = live_upper(p);
+    if (at == 0 || g_live[at - 1].base != p) {
+        pthread_rwlock_unlock(&g_lock);
+        return -1;
+    }
+    Block b = g_live[--at];
+    memmove(&g_live[at], &g_live[at + 1], (n - at - 1) * sizeof(Block));
+    atomic_store(&g_live_count, n - 1);
+
+    /* Keep it for reuse if it's the kind new allocations would get */
+    bool pooled = b.cls >= 0 && b.kind == g_kind &&
+                  g_free_count[b.cls] < FREE_PER_CLASS &&
+                  g_free_bytes + b.cap <= POOL_LIMIT;
+    if (pooled) {
+        g_free[b.cls][g_free_count[b.cls]++] = b;
+        g_free_bytes += b.cap;
+    }
+    pthread_rwlock_unlock(&g_lock);
+
+    if (!pooled) raw_free(&b);
+    return 0;
+}
+
+int neuron_shim_mem_kind(const void* p, size_t size) {
+    if (!p || atomic_load(&g_live_count) == 0) return -1;
+
+    int kind = -1;
+    pthread_rwlock_rdlock(&g_lock);
+    size_t at = live_upper(p);
+    if (at > 0) {
+        const Block* b = &g_live[at - 1];
+        if ((size_t)((const char*)p - b->base) + size <= b->cap)
+            kind = (int)b->kind;
+    }
+    pthread_rwlock_unlock(&g_lock);
+    return kind;
+}
+
+static bool load_pinned(NeuronShimMemKind kind) {
+    static const char* const cuda_libs[] = {
+        "libcudart.so", "libcudart.so.12", "libcudart.so.11.0", NULL,
+    };
+    static const char* const hip_libs[] = {
+        "libamdhip64.so", "libamdhip64.so.6", "libamdhip64.so.5", NULL,
+    };
+    const char* const* libs = kind == NEURON_SHIM_MEM_CUDA ? cuda_libs : hip_libs;
+    const char* alloc_sym = kind == NEURON_SHIM_MEM_CUDA ? "cudaHostAlloc" : "hipHostMalloc";
+    const char* free_sym  = kind == NEURON_SHIM_MEM_CUDA ? "cudaFreeHost"  : "hipHostFree";
+
+    void* alloc_fn = dlsym(RTLD_DEFAULT, alloc_sym);
+    void* free_fn  = dlsym(RTLD_DEFAULT, free_sym);
+
+    /* The EP normally loaded the runtime already; only look, don't load
+     * a second GPU stack if it didn't */
+    for (int i = 0; libs[i] && !(alloc_fn && free_fn); i++) {
+        void* h = dlopen(libs[i], RTLD_LAZY | RTLD_NOLOAD);
+        if (!h) continue;
+        alloc_fn = dlsym(h, alloc_sym);
+        free_fn  = dlsym(h, free_sym);
+    }
+    if (!alloc_fn || !free_fn) return false;
+
+    g_pinned[kind].alloc = (HostAllocFn)alloc_fn;
+    g_pinned[kind].free  = (HostFreeFn)free_fn;
+    return true;
+}
+
+int neuron_shim_mem_enable_pinned(NeuronShimMemKind kind) {
+    if (kind != NEURON_SHIM_MEM_CUDA && kind != NEURON_SHIM_MEM_HIP) return -1;
+
+    static pthread_mutex_t once = PTHREAD_MUTEX_INITIALIZER;
+    pthread_mutex_lock(&once);
+    bool ok = g_pinned[kind].alloc || load_pinned(kind);
+    pthread_mutex_unlock(&once);
+    if (!ok) {
+        SHIM_WARN(TAG, "WARNING: %s not loaded, APU buffers stay pageable",
+                  kind == NEURON_SHIM_MEM_CUDA ? "libcudart" : "libamdhip64");
+        return -1;
+    }
+
+    /* Drop pooled blocks of the old kind so reuse doesn't hand them out */
+    Block  drained[NUM_CLASSES * FREE_PER_CLASS];
+    size_t n = 0;
+
+    pthread_rwlock_wrlock(&g_lock);
+    bool changed = g_kind != kind;
+    g_kind = kind;
+    for (int c = 0; changed && c < NUM_CLASSES; c++) {
+        while (g_free_count[c] > 0)
+            drained[n++] = g_free[c][--g_free_count[c]];
+    }
+    if (changed) g_free_bytes = 0;
+    pthread_rwlock_unlock(&g_lock);
+
+    for (size_t i = 0; i < n; i++) raw_free(&drained[i]);
+    if (changed)
+        SHIM_INFO(TAG, "APU buffers now allocated as %s pinned host memory",
+                  kind == NEURON_SHIM_MEM_CUDA ? "CUDA" : "HIP");
+    return 0;
+}
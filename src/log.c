@@ -0,0 +1,267 @@
+/*
+ * neuron-shim: Asynchronous logging
+ *
+ * The ring is a bounded MPSC queue (Vyukov-style): producers claim a
+ * slot with one CAS on 'head', format straight into it, then publish
+ * it by bumping the slot's sequence number. The single consumer — the
+ * writer thread, or neuron_shim_log_flush() — writes published slots
+ * out in batches.
+ */
+
+#include "log.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RING_SLOTS 256            /* power of two */
+#define SLOT_TEXT  480
+
+typedef struct {
+    _Atomic size_t seq;
+    size_t         len;
+    char           text[SLOT_TEXT];
+} LogSlot;
+
+int neuron_shim_log_level = 3;
+
+static int              g_rate_limit = 0;
+static LogSlot          g_ring[RING_SLOTS];
+static _Atomic size_t   g_head;
+static size_t           g_tail;              /* guarded by g_consumer_lock */
+static _Atomic uint32_t g_dropped;
+static atomic_bool      g_async;
+
+static pthread_mutex_t g_consumer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t g_wait_lock     = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  g_wake;
+static atomic_bool     g_sleeping;
+
+/* ------------------------------------------------------------------ */
+/* Formatting                                                          */
+/* ------------------------------------------------------------------ */
+static size_t format_message(char* out, size_t cap, const char* tag,
+                             uint32_t suppressed, const char* fmt, va_list ap) {
+    int n = tag ? snprintf(out, cap, "[neuron-shim][%s] ", tag)
+                : snprintf(out, cap, "[neuron-shim] ");
+    size_t len = (size_t)n;
+
+    if (suppressed)
+        len += (size_t)snprintf(out + len, cap - len,
+                                "(%u similar messages suppressed) ", suppressed);
+
+    n = vsnprintf(out + len, cap - len, fmt, ap);
+    if (n < 0) n = 0;
+    len += (size_t)n;
+
+    /* Truncated: keep the line terminated */
+    if (len > cap - 2) len = cap - 2;
+    out[len++] = '\n';
+    out[len] = '\0';
+    return len;
+}
+
+/* ------------------------------------------------------------------ */
+/* Per-site rate limiting                                              */
+/* ------------------------------------------------------------------ */
+static bool rate_allow(ShimLogSite* site, uint32_t* suppressed) {
+    *suppressed = 0;
+    if (g_rate_limit <= 0) return true;
+
+    struct timespec ts;
+#ifdef CLOCK_MONOTONIC_COARSE
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    uint64_t now = (uint64_t)ts.tv_sec;
+
+    /* First message of a new second resets the window */
+    uint64_t window = atomic_load_explicit(&site->window, memory_order_relaxed);
+    if (window != now &&
+        atomic_compare_exchange_strong(&site->window, &window, now)) {
+        atomic_store_explicit(&site->count, 0, memory_order_relaxed);
+        *suppressed = atomic_exchange(&site->suppressed, 0);
+    }
+
+    if (atomic_fetch_add_explicit(&site->count, 1, memory_order_relaxed)
+            >= (uint32_t)g_rate_limit) {
+        atomic_fetch_add_explicit(&site->suppressed, 1, memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+/* ------------------------------------------------------------------ */
+/* Producer side                                                       */
+/* ------------------------------------------------------------------ */
+static LogSlot* claim_slot(size_t* pos_out) {
+    size_t pos = atomic_load_explicit(&g_head, memory_order_relaxed);
+    for (;;) {
+        LogSlot* slot = &g_ring[pos & (RING_SLOTS - 1)];
+        size_t   seq  = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&g_head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                *pos_out = pos;
+                return slot;
+            }
+        } else if (diff < 0) {
+            return NULL;    /* full: the writer is behind */
+        } else {
+            pos = atomic_load_explicit(&g_head, memory_order_relaxed);
+        }
+    }
+}
+
+static void wake_writer(void) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!atomic_load_explicit(&g_sleeping, memory_order_relaxed)) return;
+
+    pthread_mutex_lock(&g_wait_lock);
+    pthread_cond_signal(&g_wake);
+    pthread_mutex_unlock(&g_wait_lock);
+}
+
+void neuron_shim_log_write(ShimLogSite* site, const char* tag,
+                           const char* fmt, ...) {
+    uint32_t suppressed;
+    if (!rate_allow(site, &suppressed)) return;
+
+    va_list ap;
+    va_start(ap, fmt);
+
+    if (!atomic_load_explicit(&g_async, memory_order_acquire)) {
+        char buf[SLOT_TEXT];
+        size_t len = format_message(buf, sizeof(buf), tag, suppressed, fmt, ap);
+        va_end(ap);
+        fwrite(buf, 1, len, stderr);
+        return;
+    }
+
+    size_t   pos;
+    LogSlot* slot = claim_slot(&pos);
+    if (!slot) {
+        va_end(ap);
+        atomic_fetch_add_explicit(&g_dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    slot->len = format_message(slot->text, sizeof(slot->text), tag,
+                               suppressed, fmt, ap);
+    va_end(ap);
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+    wake_writer();
+}
+
+/* ------------------------------------------------------------------ */
+/* Consumer side                                                       */
+/* ------------------------------------------------------------------ */
+static bool ring_ready(void) {
+    const LogSlot* slot = &g_ring[g_tail & (RING_SLOTS - 1)];
+    return atomic_load_explicit(&slot->seq, memory_order_acquire) == g_tail + 1;
+}
+
+static void drain(void) {
+    char   batch[8192];
+    size_t used = 0;
+
+    pthread_mutex_lock(&g_consumer_lock);
+    while (ring_ready()) {
+        LogSlot* slot = &g_ring[g_tail & (RING_SLOTS - 1)];
+        if (used + slot->len > sizeof(batch)) {
+            fwrite(batch, 1, used, stderr);
+            used = 0;
+        }
+        memcpy(batch + used, slot->text, slot->len);
+        used += slot->len;
+
+        /* Hand the slot back to producers for the next lap */
+        atomic_store_explicit(&slot->seq, g_tail + RING_SLOTS,
+                              memory_order_release);
+        g_tail++;
+    }
+
+    uint32_t dropped = atomic_exchange(&g_dropped, 0);
+    if (dropped && used + 96 <= sizeof(batch))
+        used += (size_t)snprintf(batch + used, sizeof(batch) - used,
+                                 "[neuron-shim][log] %u messages dropped "
+                                 "(ring full)\n", dropped);
+
+    if (used) {
+        fwrite(batch, 1, used, stderr);
+        fflush(stderr);
+    }
+    pthread_mutex_unlock(&g_consumer_lock);
+}
+
+static void* writer_thread(void* arg) {
+    (void)arg;
+    for (;;) {
+        drain();
+
+        pthread_mutex_lock(&g_wait_lock);
+        atomic_store(&g_sleeping, true);
+        atomic_thread_fence(memory_order_seq_cst);
+
+        /* Re-check after advertising we're asleep, so a producer that
+         * missed the flag can't leave a message stranded. The timeout
+         * is only a backstop. */
+        pthread_mutex_lock(&g_consumer_lock);
+        bool ready = ring_ready();
+        pthread_mutex_unlock(&g_consumer_lock);
+
+        if (!ready) {
+            struct timespec until;
+            clock_gettime(CLOCK_MONOTONIC, &until);
+            until.tv_nsec += 200 * 1000000L;
+            if (until.tv_nsec >= 1000000000L) {
+                until.tv_sec++;
+                until.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&g_wake, &g_wait_lock, &until);
+        }
+        atomic_store(&g_sleeping, false);
+        pthread_mutex_unlock(&g_wait_lock);
+    }
+    return NULL;
+}
+
+void neuron_shim_log_flush(void) {
+    if (atomic_load(&g_async)) drain();
+    else fflush(stderr);
+}
+
+void neuron_shim_log_init(int level, int rate_limit) {
+    neuron_shim_log_level = level;
+    g_rate_limit          = rate_limit;
+    if (level <= 0) return;     /* nothing will ever be logged */
+
+    for (size_t i = 0; i < RING_SLOTS; i++)
+        atomic_store_explicit(&g_ring[i].seq, i, memory_order_relaxed);
+
+    pthread_condattr_t cattr;
+    pthread_condattr_init(&cattr);
+    pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_wake, &cattr);
+    pthread_condattr_destroy(&cattr);
+
+    pthread_attr_t attr;
+    pthread_t      thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int rc = pthread_create(&thread, &attr, writer_thread, NULL);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) return;        /* stay synchronous */
+
+    atomic_store_explicit(&g_async, true, memory_order_release);
+    atexit(neuron_shim_log_flush);
+}
@@ -0,0 +1,440 @@
+/*
+ * neuron-shim: Shared model cache
+ *
+ * A small linked list is enough — apps load a handful of distinct
+ * models, and lookups happen only at loadNetwork time.
+ *
+ * Loading is done outside the lock so unrelated models can load in
+ * parallel. Concurrent requests for the same model wait on the entry
+ * until the first loader finishes.
+ *
+ * Preloading splits a load in two: reserve() publishes a LOADING entry
+ * right away (synchronously, at shim init), and fill() does the slow
+ * part later on a background thread. An app that asks for the model
+ * in between simply waits on the entry, as for any in-flight load.
+ *
+ * Hot swap never changes an entry's model. A replaced file is loaded
+ * as a new entry (its key has the new mtime) and linked from the old
+ * one as its successor; the link holds a reference, so the old entry
+ * and everything newer stay alive until the last runtime has moved on.
+ */
+
+#include "model_cache.h"
+#include "log.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+typedef enum {
+    ENTRY_LOADING,
+    ENTRY_READY,
+    ENTRY_FAILED,
+} EntryState;
+
+struct ShimModelEntry {
+    struct ShimModelEntry*   next;
+
+    /* Key */
+    const NeuronShimBackend* backend;
+    char                     path[1024];
+    struct timespec          mtime;
+    off_t                    size;
+
+    /* Value */
+    void*      model;
+    EntryState state;
+    int        refcount;
+
+    /* Hot swap: the next version of this file, once loaded and warm */
+    struct ShimModelEntry* _Atomic successor;
+    bool                           reloading;
+};
+
+static ShimModelEntry* g_entries = NULL;
+static pthread_mutex_t g_lock    = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  g_loaded  = PTHREAD_COND_INITIALIZER;
+
+static void watch_dir_of(const char* path);
+
+static void unlink_entry(ShimModelEntry* e) {
+    for (ShimModelEntry** p = &g_entries; *p; p = &(*p)->next) {
+        if (*p == e) {
+            *p = e->next;
+            return;
+        }
+    }
+}
+
+static ShimModelEntry* find_entry(const NeuronShimBackend* backend,
+                                  const char* path, const struct stat* st) {
+    for (ShimModelEntry* e = g_entries; e; e = e->next) {
+        if (e->backend == backend &&
+            e->state != ENTRY_FAILED &&
+            e->size == st->st_size &&
+            e->mtime.tv_sec  == st->st_mtim.tv_sec &&
+            e->mtime.tv_nsec == st->st_mtim.tv_nsec &&
+            strcmp(e->path, path) == 0)
+            return e;
+    }
+    return NULL;
+}
+
+/* Caller holds g_lock and has checked there's no live entry */
+static ShimModelEntry* insert_entry(const NeuronShimBackend* backend,
+                                    const char* path, const struct stat* st) {
+    ShimModelEntry* e = (ShimModelEntry*)calloc(1, sizeof(ShimModelEntry));
+    if (!e) return NULL;
+
+    e->backend  = backend;
+    e->mtime    = st->st_mtim;
+    e->size     = st->st_size;
+    e->state    = ENTRY_LOADING;
+    e->refcount = 1;
+    snprintf(e->path, sizeof(e->path), "%s", path);
+    e->next   = g_entries;
+    g_entries = e;
+    watch_dir_of(path);
+    return e;
+}
+
+static double elapsed_ms(const struct timespec* t0) {
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0->tv_sec) * 1e3 + (t1.tv_nsec - t0->tv_nsec) / 1e6;
+}
+
+/*
+ * Run synthetic inferences on a throwaway context so lazy one-time work
+ * (graph optimization, device context creation, kernel autotuning, TRT
+ * engine build) happens here instead of on the app's first frame.
+ * Inputs are zero-filled at the model's own tensor sizes; outputs are
+ * left unbound and discarded.
+ */
+static void warm_up(const NeuronShimBackend* backend, void* model,
+                    const char* path, int runs) {
+    void* ctx = NULL;
+    if (backend->create(&ctx) != 0) return;
+
+    void*    inputs[64] = { 0 };
+    uint32_t in_count = 0;
+    int      ok = backend->attach(ctx, model) == 0 &&
+                  backend->get_input_count(ctx, &in_count) == 0;
+    if (in_count > 64) in_count = 64;
+
+    for (uint32_t i = 0; ok && i < in_count; i++) {
+        size_t size = 0;
+        ok = backend->get_input_size(ctx, (int)i, &size) == 0 &&
+             (inputs[i] = calloc(1, size ? size : 1)) != NULL &&
+             backend->set_input(ctx, (int)i, inputs[i], size) == 0;
+    }
+
+    double first = 0.0, last = 0.0;
+    for (int r = 0; ok && r < runs; r++) {
+        struct timespec t0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        ok = backend->invoke(ctx) == 0;
+        last = elapsed_ms(&t0);
+        if (r == 0) first = last;
+    }
+
+    if (ok)
+        SHIM_INFO("cache", "warm-up: %s (%d runs, first %.1f ms, "
+                  "last %.1f ms)", path, runs, first, last);
+    else
+        SHIM_WARN("cache", "warm-up failed: %s", path);
+
+    backend->destroy(ctx);
+    for (uint32_t i = 0; i < in_count; i++)
+        free(inputs[i]);
+}
+
+/* Load (and optionally warm up) a LOADING entry, then wake waiters.
+ * On failure the caller's reference is dropped. */
+static int fill_entry(ShimModelEntry* e, int warmup_runs) {
+    void* model = NULL;
+    int rc = e->backend->model_load(e->path, &model);
+    if (rc == 0 && warmup_runs > 0)
+        warm_up(e->backend, model, e->path, warmup_runs);
+
+    pthread_mutex_lock(&g_lock);
+    if (rc == 0) {
+        e->model = model;
+        e->state = ENTRY_READY;
+    } else {
+        e->state = ENTRY_FAILED;
+        unlink_entry(e);
+    }
+    pthread_cond_broadcast(&g_loaded);
+
+    if (rc != 0) {
+        int last = (--e->refcount == 0);
+        pthread_mutex_unlock(&g_lock);
+        if (last) free(e);
+        return -1;
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    SHIM_INFO("cache", "loaded: %s", e->path);
+    return 0;
+}
+
+static ShimModelEntry* acquire(const NeuronShimBackend* backend,
+                               const char* path, int warmup_runs) {
+    if (!backend || !path || !backend->model_load) return NULL;
+
+    struct stat st;
+    if (stat(path, &st) != 0) return NULL;
+
+    pthread_mutex_lock(&g_lock);
+
+    ShimModelEntry* e = find_entry(backend, path, &st);
+    if (e) {
+        e->refcount++;
+        while (e->state == ENTRY_LOADING)
+            pthread_cond_wait(&g_loaded, &g_lock);
+
+        if (e->state == ENTRY_READY) {
+            pthread_mutex_unlock(&g_lock);
+            SHIM_INFO("cache", "hit: %s (refs=%d)",
+                      path, e->refcount);
+            return e;
+        }
+
+        /* The load we waited on failed */
+        int last = (--e->refcount == 0);
+        pthread_mutex_unlock(&g_lock);
+        if (last) free(e);
+        return NULL;
+    }
+
+    e = insert_entry(backend, path, &st);
+    pthread_mutex_unlock(&g_lock);
+    if (!e) return NULL;
+
+    return fill_entry(e, warmup_runs) == 0 ? e : NULL;
+}
+
+ShimModelEntry* neuron_shim_cache_acquire(const NeuronShimBackend* backend,
+                                          const char* path) {
+    return acquire(backend, path, 0);
+}
+
+ShimModelEntry* neuron_shim_cache_reserve(const NeuronShimBackend* backend,
+                                          const char* path) {
+    if (!backend || !path || !backend->model_load) return NULL;
+
+    struct stat st;
+    if (stat(path, &st) != 0) return NULL;
+
+    pthread_mutex_lock(&g_lock);
+    ShimModelEntry* e = find_entry(backend, path, &st)
+        ? NULL : insert_entry(backend, path, &st);
+    pthread_mutex_unlock(&g_lock);
+    return e;
+}
+
+int neuron_shim_cache_fill(ShimModelEntry* entry, int warmup_runs) {
+    if (!entry) return -1;
+    return fill_entry(entry, warmup_runs);
+}
+
+void* neuron_shim_cache_model(const ShimModelEntry* entry) {
+    return entry ? entry->model : NULL;
+}
+
+void neuron_shim_cache_release(ShimModelEntry* entry) {
+    if (!entry) return;
+
+    pthread_mutex_lock(&g_lock);
+    int last = (--entry->refcount == 0);
+    if (last) unlink_entry(entry);
+    pthread_mutex_unlock(&g_lock);
+
+    if (!last) return;
+
+    SHIM_INFO("cache", "freeing: %s", entry->path);
+    entry->backend->model_release(entry->model);
+    ShimModelEntry* successor = atomic_load(&entry->successor);
+    free(entry);
+    neuron_shim_cache_release(successor);   /* the link's reference */
+}
+
+bool neuron_shim_cache_stale(const ShimModelEntry* entry) {
+    return entry &&
+           atomic_load_explicit(&((ShimModelEntry*)entry)->successor,
+                                memory_order_acquire) != NULL;
+}
+
+ShimModelEntry* neuron_shim_cache_newest(ShimModelEntry* entry) {
+    if (!entry) return NULL;
+
+    pthread_mutex_lock(&g_lock);
+    ShimModelEntry* e = entry;
+    while (atomic_load(&e->successor)) e = atomic_load(&e->successor);
+    e->refcount++;
+    pthread_mutex_unlock(&g_lock);
+    return e;
+}
+
+/* ------------------------------------------------------------------ */
+/* Hot swap                                                            */
+/*                                                                     */
+/* One inotify instance watches the directory of every cached model.   */
+/* A file closed after writing or moved into place that matches a      */
+/* current entry is loaded and warmed up on the watcher thread, then   */
+/* published as that entry's successor.                                */
+/* ------------------------------------------------------------------ */
+#define MAX_WATCHED_DIRS 16
+#define MAX_RELOADS      8    /* entries handled per event */
+
+static int g_watch_fd     = -1;
+static int g_watch_warmup = 0;
+static struct {
+    int  wd;
+    char dir[1024];
+} g_dirs[MAX_WATCHED_DIRS];
+static int g_dir_count = 0;
+
+/* Caller holds g_lock */
+static void watch_dir_of(const char* path) {
+    if (g_watch_fd < 0) return;
+
+    char dir[1024];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char* slash = strrchr(dir, '/');
+    if (!slash)
+        snprintf(dir, sizeof(dir), ".");
+    else
+        *(slash == dir ? slash + 1 : slash) = '\0';   /* keep "/" */
+
+    for (int i = 0; i < g_dir_count; i++)
+        if (strcmp(g_dirs[i].dir, dir) == 0) return;
+    if (g_dir_count == MAX_WATCHED_DIRS) {
+        SHIM_WARN("cache", "WARNING: hot swap watches at most %d directories, "
+                  "not watching %s", MAX_WATCHED_DIRS, dir);
+        return;
+    }
+
+    int wd = inotify_add_watch(g_watch_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0) {
+        SHIM_WARN("cache", "WARNING: can't watch %s: %s", dir, strerror(errno));
+        return;
+    }
+    g_dirs[g_dir_count].wd = wd;
+    snprintf(g_dirs[g_dir_count].dir, sizeof(g_dirs[0].dir), "%s", dir);
+    g_dir_count++;
+}
+
+/* Load the file's new version and link it from 'old' (one reference held) */
+static void reload(ShimModelEntry* old) {
+    struct stat st;
+    if (stat(old->path, &st) != 0 ||
+        (st.st_size == old->size &&
+         st.st_mtim.tv_sec  == old->mtime.tv_sec &&
+         st.st_mtim.tv_nsec == old->mtime.tv_nsec)) {
+        pthread_mutex_lock(&g_lock);
+        old->reloading = false;
+        pthread_mutex_unlock(&g_lock);
+        return;   /* gone, or rewritten with the same contents' timestamp */
+    }
+
+    SHIM_INFO("cache", "hot swap: %s changed, loading", old->path);
+    ShimModelEntry* next = acquire(old->backend, old->path, g_watch_warmup);
+
+    pthread_mutex_lock(&g_lock);
+    old->reloading = false;
+    if (next && next != old)
+        atomic_store_explicit(&old->successor, next, memory_order_release);
+    pthread_mutex_unlock(&g_lock);
+
+    if (!next)
+        SHIM_WARN("cache", "WARNING: hot swap: %s failed to load, "
+                  "keeping the running version", old->path);
+    else if (next != old)
+        SHIM_INFO("cache", "hot swap: %s ready, runtimes move to it "
+                  "on their next inference", old->path);
+    else
+        neuron_shim_cache_release(next);
+}
+
+static void file_changed(int wd, const char* name) {
+    char path[1024];
+    ShimModelEntry* todo[MAX_RELOADS];
+    int n = 0;
+
+    pthread_mutex_lock(&g_lock);
+    for (int i = 0; i < g_dir_count; i++) {
+        if (g_dirs[i].wd != wd) continue;
+        snprintf(path, sizeof(path), "%s%s%s", g_dirs[i].dir,
+                 strcmp(g_dirs[i].dir, "/") == 0 ? "" : "/", name);
+        for (ShimModelEntry* e = g_entries; e && n < MAX_RELOADS; e = e->next) {
+            if (e->state != ENTRY_READY || e->reloading ||
+                atomic_load(&e->successor) || strcmp(e->path, path) != 0)
+                continue;
+            e->reloading = true;
+            e->refcount++;
+            todo[n++] = e;
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    for (int i = 0; i < n; i++) {
+        reload(todo[i]);
+        neuron_shim_cache_release(todo[i]);
+    }
+}
+
+static void* watch_thread(void* arg) {
+    (void)arg;
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    for (;;) {
+        ssize_t len = read(g_watch_fd, buf, sizeof(buf));
+        if (len < 0 && errno == EINTR) continue;
+        if (len <= 0) break;
+
+        const struct inotify_event* ev;
+        for (char* p = buf; p < buf + len; p += sizeof(*ev) + ev->len) {
+            ev = (const struct inotify_event*)p;
+            if (ev->len) file_changed(ev->wd, ev->name);
+        }
+    }
+    SHIM_WARN("cache", "WARNING: hot swap watcher stopped");
+    return NULL;
+}
+
+int neuron_shim_cache_watch(int warmup_runs) {
+    int fd = inotify_init1(IN_CLOEXEC);
+    if (fd < 0) {
+        SHIM_WARN("cache", "WARNING: hot swap disabled: inotify: %s",
+                  strerror(errno));
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_lock);
+    g_watch_fd     = fd;
+    g_watch_warmup = warmup_runs;
+    for (ShimModelEntry* e = g_entries; e; e = e->next)
+        watch_dir_of(e->path);
+    pthread_mutex_unlock(&g_lock);
+
+    pthread_attr_t attr;
+    pthread_t      thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int rc = pthread_create(&thread, &attr, watch_thread, NULL);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        SHIM_WARN("cache", "WARNING: hot swap disabled: can't start watcher");
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,189 @@
+/*
+ * neuron-shim: Model content hashing
+ *
+ * xxHash-style construction: eight independent 32-bit lanes consume
+ * 32-byte stripes (one multiply-rotate-multiply round per lane), then
+ * the lanes and the tail are folded into a 64-bit result. The lanes
+ * have no cross-dependencies, so the main loop runs at memory speed
+ * and maps directly onto 256-bit (or 2x128-bit) SIMD registers: the
+ * AVX2 and NEON stripe loops below compute exactly what the scalar one
+ * does, just all lanes at once.
+ *
+ * The output only has to be stable across runs of this shim; it is not
+ * compatible with any published xxHash variant.
+ */
+
+#include "model_hash.h"
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SHIM_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define SHIM_NEON 1
+#endif
+
+#define LANES        8
+#define STRIPE_BYTES (LANES * 4)
+
+#define P32_1 0x9E3779B1u
+#define P32_2 0x85EBCA77u
+#define P64_1 0x9E3779B185EBCA87ull
+#define P64_2 0xC2B2AE3D27D4EB4Full
+#define P64_3 0x165667B19E3779F9ull
+#define P64_4 0x85EBCA77C2B2AE63ull
+#define P64_5 0x27D4EB2F165667C5ull
+
+static inline uint32_t rotl32(uint32_t x, int r) {
+    return (x << r) | (x >> (32 - r));
+}
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;   /* little-endian targets only (aarch64, x86_64) */
+}
+
+static inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/* ------------------------------------------------------------------ */
+/* Stripe loops: acc[l] = rotl32(acc[l] + word[l] * P32_2, 13) * P32_1 */
+/* ------------------------------------------------------------------ */
+#ifndef SHIM_NEON
+static void stripes_scalar(uint32_t acc[LANES], const uint8_t* p, size_t stripes) {
+    for (size_t s = 0; s < stripes; s++, p += STRIPE_BYTES) {
+        for (int l = 0; l < LANES; l++)
+            acc[l] = rotl32(acc[l] + read32(p + 4 * l) * P32_2, 13) * P32_1;
+    }
+}
+#endif
+
+#ifdef SHIM_X86
+__attribute__((target("avx2")))
+static void stripes_avx2(uint32_t acc[LANES], const uint8_t* p, size_t stripes) {
+    const __m256i p1 = _mm256_set1_epi32((int)P32_1);
+    const __m256i p2 = _mm256_set1_epi32((int)P32_2);
+    __m256i a = _mm256_loadu_si256((const __m256i*)acc);
+    for (size_t s = 0; s < stripes; s++, p += STRIPE_BYTES) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        a = _mm256_add_epi32(a, _mm256_mullo_epi32(v, p2));
+        a = _mm256_or_si256(_mm256_slli_epi32(a, 13), _mm256_srli_epi32(a, 19));
+        a = _mm256_mullo_epi32(a, p1);
+    }
+    _mm256_storeu_si256((__m256i*)acc, a);
+}
+#endif
+
+#ifdef SHIM_NEON
+static void stripes_neon(uint32_t acc[LANES], const uint8_t* p, size_t stripes) {
+    uint32x4_t lo = vld1q_u32(acc);
+    uint32x4_t hi = vld1q_u32(acc + 4);
+    for (size_t s = 0; s < stripes; s++, p += STRIPE_BYTES) {
+        lo = vmlaq_n_u32(lo, vreinterpretq_u32_u8(vld1q_u8(p)), P32_2);
+        hi = vmlaq_n_u32(hi, vreinterpretq_u32_u8(vld1q_u8(p + 16)), P32_2);
+        lo = vmulq_n_u32(vsriq_n_u32(vshlq_n_u32(lo, 13), lo, 19), P32_1);
+        hi = vmulq_n_u32(vsriq_n_u32(vshlq_n_u32(hi, 13), hi, 19), P32_1);
+    }
+    vst1q_u32(acc, lo);
+    vst1q_u32(acc + 4, hi);
+}
+#endif
+
+/* Fold the lane accumulators plus the unstriped tail into 64 bits */
+static uint64_t hash_finish(const uint32_t acc[LANES],
+                            const uint8_t* tail, size_t tail_len,
+                            size_t total_len) {
+    uint64_t h = P64_5 + (uint64_t)total_len;
+
+    for (int l = 0; l < LANES; l++) {
+        h ^= (uint64_t)acc[l] * P64_2;
+        h  = rotl64(h, 27) * P64_1 + P64_4;
+    }
+
+    while (tail_len >= 8) {
+        h ^= rotl64(read64(tail) * P64_2, 31) * P64_1;
+        h  = rotl64(h, 27) * P64_1 + P64_4;
+        tail += 8; tail_len -= 8;
+    }
+    while (tail_len >= 4) {
+        h ^= (uint64_t)read32(tail) * P64_1;
+        h  = rotl64(h, 23) * P64_2 + P64_3;
+        tail += 4; tail_len -= 4;
+    }
+    while (tail_len > 0) {
+        h ^= (uint64_t)(*tail) * P64_5;
+        h  = rotl64(h, 11) * P64_1;
+        tail++; tail_len--;
+    }
+
+    /* Avalanche */
+    h ^= h >> 33;
+    h *= P64_2;
+    h ^= h >> 29;
+    h *= P64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t neuron_shim_hash_buffer(const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    size_t stripes = len / STRIPE_BYTES;
+
+    uint32_t acc[LANES];
+    for (int l = 0; l < LANES; l++)
+        acc[l] = P32_1 * (uint32_t)(l + 1);
+
+#if defined(SHIM_X86)
+    if (__builtin_cpu_supports("avx2"))
+        stripes_avx2(acc, p, stripes);
+    else
+        stripes_scalar(acc, p, stripes);
+#elif defined(SHIM_NEON)
+    stripes_neon(acc, p, stripes);
+#else
+    stripes_scalar(acc, p, stripes);
+#endif
+    p += stripes * STRIPE_BYTES;
+
+    return hash_finish(acc, p, len % STRIPE_BYTES, len);
+}
+
+int neuron_shim_hash_file(const char* path, uint64_t* hash) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    if (st.st_size == 0) {
+        close(fd);
+        *hash = neuron_shim_hash_buffer("", 0);
+        return 0;
+    }
+
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+    *hash = neuron_shim_hash_buffer(map, (size_t)st.st_size);
+    munmap(map, (size_t)st.st_size);
+    return 0;
+}
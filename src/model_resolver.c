@@ -12,10 +12,16 @@
  *     → /usr/share/models/person_detect.dla.onnx
  *
  * Always appends suffix. Always fails clearly if not found.
+ *
+ * Buffer-loaded models resolve by content hash inside model_dir:
+ *     <embedded .dla blob, hash 3f2a...>
+ *     → <model_dir>/3f2a....dla.onnx
  */
 
 #include "model_resolver.h"
+#include "log.h"
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
@@ -54,12 +60,14 @@ int neuron_shim_resolve_model(const char* original_path,
     }
 
     if (written < 0 || (size_t)written >= resolved_len) {
-        fprintf(stderr, "[neuron-shim] ERROR: resolved path too long\n");
+        SHIM_ERR(NULL, "ERROR: resolved path too long");
         return -1;
     }
 
     /* Check file exists */
     if (access(resolved, R_OK) != 0) {
+        /* The banner is written directly; get queued lines out first */
+        neuron_shim_log_flush();
         fprintf(stderr,
             "\n"
             "╔══════════════════════════════════════════════════════════╗\n"
@@ -100,3 +108,27 @@ int neuron_shim_resolve_model(const char* original_path,
 
     return 0;
 }
+
+void neuron_shim_blob_name(uint64_t hash, char* name, size_t name_len) {
+    snprintf(name, name_len, "%016" PRIx64 ".dla", hash);
+}
+
+int neuron_shim_resolve_blob(uint64_t hash,
+                             const char* suffix,
+                             const char* model_dir,
+                             char* resolved,
+                             size_t resolved_len) {
+    if (!suffix || !resolved || !model_dir || model_dir[0] == '\0')
+        return -1;
+
+    char name[32];
+    neuron_shim_blob_name(hash, name, sizeof(name));
+
+    size_t dir_len = strlen(model_dir);
+    const char* sep = model_dir[dir_len - 1] == '/' ? "" : "/";
+    int written = snprintf(resolved, resolved_len, "%s%s%s%s",
+                           model_dir, sep, name, suffix);
+    if (written < 0 || (size_t)written >= resolved_len) return -1;
+
+    return access(resolved, R_OK) == 0 ? 0 : -1;
+}
@@ -0,0 +1,165 @@
+/*
+ * neuron-shim: Chrome trace profiling
+ */
+
+#define _GNU_SOURCE
+#include "profile.h"
+#include "log.h"
+#include "stats.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TAG "profile"
+
+static FILE*           g_file = NULL;
+static char            g_path[1024];   /* set once the file is open */
+static int             g_pid;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* The process name goes last: every other event ends in a comma */
+static void profile_close(void) {
+    pthread_mutex_lock(&g_lock);
+    if (g_file) {
+        fprintf(g_file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+                "\"tid\":0,\"args\":{\"name\":\"neuron-shim\"}}\n]\n", g_pid);
+        fclose(g_file);
+        g_file = NULL;
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+static void expand_path(const char* spec, char* out, size_t len) {
+    size_t n = 0;
+    for (const char* p = spec; *p && n + 1 < len; p++) {
+        if (p[0] == '%' && p[1] == 'p') {
+            int w = snprintf(out + n, len - n, "%d", (int)getpid());
+            if (w < 0 || (size_t)w >= len - n) { n = len - 1; break; }
+            n += (size_t)w;
+            p++;
+        } else {
+            out[n++] = *p;
+        }
+    }
+    out[n] = '\0';
+}
+
+int neuron_shim_profile_open(const NeuronShimConfig* cfg) {
+    if (!cfg->profile_file[0]) return -1;
+
+    char path[sizeof(g_path)];
+    expand_path(cfg->profile_file, path, sizeof(path));
+    g_file = fopen(path, "w");
+    if (!g_file) {
+        SHIM_WARN(TAG, "WARNING: can't open %s, profiling disabled", path);
+        return -1;
+    }
+    setvbuf(g_file, NULL, _IOFBF, 1 << 16);
+    fputs("[\n", g_file);
+
+    g_pid = (int)getpid();
+    snprintf(g_path, sizeof(g_path), "%s", path);
+    atexit(profile_close);
+    SHIM_INFO(TAG, "Chrome trace: %s (first %d inferences per model, "
+              "or as set per model)", g_path, cfg->profile_runs);
+    return 0;
+}
+
+const char* neuron_shim_profile_path(void) {
+    return g_path[0] ? g_path : NULL;
+}
+
+int neuron_shim_profile_runs(const NeuronShimConfig* cfg,
+                             const NeuronShimModelConfig* mc) {
+    if (!g_path[0]) return 0;
+    return mc && mc->profile_runs > 0 ? mc->profile_runs : cfg->profile_runs;
+}
+
+static void put_escaped(FILE* f, const char* s) {
+    for (; *s; s++) {
+        unsigned char ch = (unsigned char)*s;
+        if (ch == '"' || ch == '\\') {
+            fputc('\\', f);
+            fputc(ch, f);
+        } else if (ch < 0x20) {
+            fprintf(f, "\\u%04x", ch);
+        } else {
+            fputc(ch, f);
+        }
+    }
+}
+
+void neuron_shim_profile_span(const char* cat, const char* name,
+                              uint64_t start_ns, uint64_t end_ns,
+                              const char* args_fmt, ...) {
+    if (!g_path[0]) return;
+    int tid = (int)syscall(SYS_gettid);
+    uint64_t dur = end_ns > start_ns ? end_ns - start_ns : 0;
+
+    pthread_mutex_lock(&g_lock);
+    if (g_file) {
+        fputs("{\"name\":\"", g_file);
+        put_escaped(g_file, name);
+        fprintf(g_file, "\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                "\"pid\":%d,\"tid\":%d", cat, start_ns / 1e3, dur / 1e3, g_pid, tid);
+        if (args_fmt) {
+            va_list ap;
+            va_start(ap, args_fmt);
+            fputs(",\"args\":{", g_file);
+            vfprintf(g_file, args_fmt, ap);
+            fputc('}', g_file);
+            va_end(ap);
+        }
+        fputs("},\n", g_file);
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+int neuron_shim_profile_merge(const char* file, uint64_t base_ns) {
+    FILE* in = fopen(file, "r");
+    if (!in) return -1;
+
+    /* Where the file's ts == 0 falls on our clock */
+    struct timespec wall;
+    clock_gettime(CLOCK_REALTIME, &wall);
+    int64_t wall_ns = (int64_t)wall.tv_sec * 1000000000ll + wall.tv_nsec;
+    int64_t base    = (int64_t)base_ns;
+    if (base > wall_ns / 2)
+        base = (int64_t)neuron_shim_now_ns() - (wall_ns - base);
+    double base_us = base / 1e3;
+
+    /* Rewrite each event's "ts", keep the rest as ORT wrote it. Spans
+     * from other threads wait until the whole file is in. */
+    char*   line = NULL;
+    size_t  cap  = 0;
+    int     n    = 0;
+    pthread_mutex_lock(&g_lock);
+    while (g_file && getline(&line, &cap, in) > 0) {
+        char* start = line + strspn(line, " \t[");
+        char* end   = strrchr(start, '}');
+        char* ts    = strstr(start, "\"ts\"");
+        if (*start != '{' || !end || !ts || ts > end) continue;
+
+        char* num = ts + 4;
+        num += strspn(num, " \t:");
+        char*  rest;
+        double us = strtod(num, &rest);
+        if (rest == num) continue;
+
+        fprintf(g_file, "%.*s%.3f%.*s,\n", (int)(num - start), start,
+                base_us + us, (int)(end + 1 - rest), rest);
+        n++;
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    free(line);
+    fclose(in);
+    unlink(file);
+    return n;
+}
@@ -0,0 +1,156 @@
+/*
+ * neuron-shim: QoS-aware inference scheduling
+ */
+
+#include "scheduler.h"
+#include "log.h"
+#include "RuntimeAPI.h"
+
+#include <stdio.h>
+#include <pthread.h>
+
+/* ------------------------------------------------------------------ */
+/* Priority gate                                                       */
+/* ------------------------------------------------------------------ */
+#define NUM_PRIORITIES (NEURONRUNTIME_PRIORITY_HIGH + 1)
+
+static pthread_mutex_t g_gate_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  g_gate_cond = PTHREAD_COND_INITIALIZER;
+static int             g_pending[NUM_PRIORITIES];  /* queued + running */
+
+static int clamp_priority(int priority) {
+    if (priority < 0) return 0;
+    if (priority >= NUM_PRIORITIES) return NUM_PRIORITIES - 1;
+    return priority;
+}
+
+static bool higher_pending(int priority) {
+    for (int p = priority + 1; p < NUM_PRIORITIES; p++)
+        if (g_pending[p] > 0) return true;
+    return false;
+}
+
+void neuron_shim_sched_enter(int priority) {
+    priority = clamp_priority(priority);
+
+    pthread_mutex_lock(&g_gate_lock);
+    /* Counted while still waiting, so lower priorities yield to us
+     * from the moment we're queued */
+    g_pending[priority]++;
+    while (higher_pending(priority))
+        pthread_cond_wait(&g_gate_cond, &g_gate_lock);
+    pthread_mutex_unlock(&g_gate_lock);
+}
+
+void neuron_shim_sched_leave(int priority) {
+    priority = clamp_priority(priority);
+
+    pthread_mutex_lock(&g_gate_lock);
+    g_pending[priority]--;
+    /* Only lower priorities can be waiting on us */
+    if (priority > 0)
+        pthread_cond_broadcast(&g_gate_cond);
+    pthread_mutex_unlock(&g_gate_lock);
+}
+
+/* ------------------------------------------------------------------ */
+/* Watchdog                                                            */
+/*                                                                     */
+/* Armed timers form an unsorted list — there's at most one per app    */
+/* thread, so a linear scan for the earliest is cheap.                 */
+/* ------------------------------------------------------------------ */
+static pthread_mutex_t g_watch_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  g_watch_cond;
+static pthread_once_t  g_watch_once = PTHREAD_ONCE_INIT;
+static ShimWatch*      g_watches    = NULL;
+static bool            g_watch_ok   = false;
+
+static bool ts_before(const struct timespec* a, const struct timespec* b) {
+    return a->tv_sec < b->tv_sec ||
+           (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+static void* watchdog_thread(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&g_watch_lock);
+    for (;;) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        ShimWatch* next = NULL;
+        for (ShimWatch* w = g_watches; w; w = w->next) {
+            if (w->fired) continue;
+            if (!ts_before(&now, &w->abort_at)) {
+                w->fired = true;
+                w->backend->abort(w->ctx);
+                continue;
+            }
+            if (!next || ts_before(&w->abort_at, &next->abort_at))
+                next = w;
+        }
+
+        if (next)
+            pthread_cond_timedwait(&g_watch_cond, &g_watch_lock, &next->abort_at);
+        else
+            pthread_cond_wait(&g_watch_cond, &g_watch_lock);
+    }
+    return NULL;
+}
+
+static void watchdog_start(void) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_watch_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    pthread_attr_t tattr;
+    pthread_t      thread;
+    pthread_attr_init(&tattr);
+    pthread_attr_setdetachstate(&tattr, PTHREAD_CREATE_DETACHED);
+    g_watch_ok = pthread_create(&thread, &tattr, watchdog_thread, NULL) == 0;
+    pthread_attr_destroy(&tattr);
+
+    if (!g_watch_ok)
+        SHIM_WARN("sched", "can't start watchdog, "
+                  "abortTime will be ignored");
+}
+
+void neuron_shim_watch_arm(ShimWatch* w, const NeuronShimBackend* backend,
+                           void* ctx, uint64_t timeout_ns) {
+    pthread_once(&g_watch_once, watchdog_start);
+
+    w->backend = backend;
+    w->ctx     = ctx;
+    w->fired   = false;
+    clock_gettime(CLOCK_MONOTONIC, &w->abort_at);
+    w->abort_at.tv_sec  += (time_t)(timeout_ns / 1000000000ull);
+    w->abort_at.tv_nsec += (long)(timeout_ns % 1000000000ull);
+    if (w->abort_at.tv_nsec >= 1000000000L) {
+        w->abort_at.tv_sec++;
+        w->abort_at.tv_nsec -= 1000000000L;
+    }
+
+    if (!g_watch_ok) return;
+
+    pthread_mutex_lock(&g_watch_lock);
+    w->next   = g_watches;
+    g_watches = w;
+    pthread_cond_signal(&g_watch_cond);
+    pthread_mutex_unlock(&g_watch_lock);
+}
+
+bool neuron_shim_watch_disarm(ShimWatch* w) {
+    if (!g_watch_ok) return false;
+
+    pthread_mutex_lock(&g_watch_lock);
+    for (ShimWatch** p = &g_watches; *p; p = &(*p)->next) {
+        if (*p == w) {
+            *p = w->next;
+            break;
+        }
+    }
+    bool fired = w->fired;
+    pthread_mutex_unlock(&g_watch_lock);
+    return fired;
+}
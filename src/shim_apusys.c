@@ -6,9 +6,14 @@
  * application or library tries to use apusys directly, these stubs
  * prevent crashes.
  *
- * Most of these are ioctl wrappers. We just return success.
+ * Most of these are ioctl wrappers. We just return success. Memory is
+ * the exception: apps pass APU buffers straight to NeuronRuntime_setInput,
+ * so they come from the shim's pooled (and, with a GPU backend, pinned)
+ * host allocator — see host_mem.h.
  */
 
+#include "host_mem.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -68,14 +73,15 @@ int apusys_cmd_wait(void* cmd, int timeout_ms) {
 int apusys_mem_alloc(void* session, size_t size, void** mem) {
     /* Actually allocate — some code may write to this */
     if (mem) {
-        *mem = calloc(1, size);
+        *mem = neuron_shim_mem_alloc(size);
         if (!*mem) return -1;
     }
     return 0;
 }
 
 int apusys_mem_free(void* session, void* mem) {
-    /* We can't safely free since we don't know if it was our alloc */
+    /* Pointers that didn't come from apusys_mem_alloc are left alone */
+    neuron_shim_mem_free(mem);
     return 0;
 }
 
@@ -18,36 +18,121 @@
 #include "RuntimeAPI.h"
 #include "backend.h"
 #include "config.h"
+#include "convert.h"
+#include "log.h"
 #include "model_resolver.h"
+#include "model_cache.h"
+#include "model_hash.h"
+#include "profile.h"
+#include "scheduler.h"
+#include "stats.h"
+#include "trace.h"
+#include "worker.h"
 
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
 
 /* ------------------------------------------------------------------ */
-/* Logging                                                             */
+/* Logging (asynchronous, see log.h)                                   */
 /* ------------------------------------------------------------------ */
-static int g_log_level = 3;
-
-#define SHIM_LOG(level, tag, fmt, ...) \
-    do { \
-        if (g_log_level >= (level)) \
-            fprintf(stderr, "[neuron-shim][%s] " fmt "\n", \
-                    (tag), ##__VA_ARGS__); \
-    } while(0)
-
-#define LOG_ERR(fmt, ...)   SHIM_LOG(1, "ERROR", fmt, ##__VA_ARGS__)
-#define LOG_WARN(fmt, ...)  SHIM_LOG(2, "WARN",  fmt, ##__VA_ARGS__)
-#define LOG_INFO(fmt, ...)  SHIM_LOG(3, "INFO",  fmt, ##__VA_ARGS__)
-#define LOG_DBG(fmt, ...)   SHIM_LOG(4, "DEBUG", fmt, ##__VA_ARGS__)
+#define LOG_ERR(fmt, ...)   SHIM_LOG(SHIM_LOG_ERROR, "ERROR", fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...)  SHIM_LOG(SHIM_LOG_WARN,  "WARN",  fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...)  SHIM_LOG(SHIM_LOG_INFO,  "INFO",  fmt, ##__VA_ARGS__)
+#define LOG_DBG(fmt, ...)   SHIM_LOG(SHIM_LOG_DEBUG, "DEBUG", fmt, ##__VA_ARGS__)
 
 /* ------------------------------------------------------------------ */
 /* Internal runtime context                                            */
 /* ------------------------------------------------------------------ */
+/*
+ * Pipeline mode keeps two copies of every tensor the app set: frame N
+ * runs on one slot while the app refills its own buffers and reads
+ * frame N-1's outputs out of the other.
+ */
+typedef struct {
+    void*  app;       /* the app's buffer, NULL = not set */
+    size_t size;
+    void*  slot[2];
+    size_t slot_size[2];
+} ShimPipeTensor;
+
+typedef struct {
+    ShimPipeTensor inputs[NEURON_SHIM_MAX_IO];
+    ShimPipeTensor outputs[NEURON_SHIM_MAX_IO];
+    int            next;       /* slot the next frame runs on */
+    bool           primed;     /* a frame is in flight on the other slot */
+} ShimPipeline;
+
+/*
+ * One thread's execution state: backend context (bindings, run options,
+ * interpreter) plus conversion staging. Threads sharing a runtime each
+ * get their own, attached to the same shared model, so they run in
+ * parallel on one copy of the weights.
+ *
+ * A new thread's context starts out with main's bindings, and keeps
+ * following them until the thread binds a buffer itself: the app may
+ * bind on one thread and run on another.
+ */
+typedef struct {
+    void*  buf;        /* what the backend context is bound to */
+    size_t size;
+    void*  app;        /* what the app passed (differs when converted) */
+    size_t app_size;
+} ShimBinding;
+
+typedef struct {
+    void*           backend_ctx;
+    ShimModelEntry* model;     /* shared model attached (one reference),
+                                * NULL if loaded privately */
+    bool            pinned;    /* hot swap failed: stay on 'model' */
+    pthread_t       thread;
+    _Atomic bool    claimed;   /* 'thread' is set */
+    bool            own_bindings;   /* the thread bound something itself */
+    unsigned        seen_gen;       /* main's bind_gen last copied */
+
+    /* What backend_ctx is bound to (staging for converted tensors),
+     * replayed onto a new context when the model is hot-swapped */
+    ShimBinding     inputs[NEURON_SHIM_MAX_IO];
+    ShimBinding     outputs[NEURON_SHIM_MAX_IO];
+
+    /* From the model's [model] section: tensors whose app buffers need
+     * converting (see convert.h). NEURON_SHIM_MAX_IO entries each, or
+     * NULL; an entry is in use when its staging buffer is set. */
+    ShimTensorConv* conv_inputs;
+    ShimTensorConv* conv_outputs;
+} ShimExec;
+
+#define MAX_EXECS 16   /* threads per runtime beyond the first */
+
 typedef struct {
-    const NeuronShimBackend* backend;
-    void*                    backend_ctx;
+    const NeuronShimBackend*     backend;
+    const NeuronShimModelConfig* config;   /* the model's [model] section, or NULL */
+
+    /* The first thread to bind or run uses 'main' (queries always do);
+     * others get an entry in 'execs', created on first use */
+    ShimExec         main;
+    ShimExec*        execs[MAX_EXECS];
+    _Atomic int      exec_count;
+    pthread_mutex_t  exec_lock;
+    bool             exec_warned;
+    _Atomic unsigned bind_gen;    /* bumped when main's bindings change */
+
+    /* From setQoSOption */
+    int      priority;      /* NeuronRuntimePriority */
+    uint64_t abort_ns;      /* 0 = never abort */
+    uint64_t deadline_ns;   /* 0 = none */
+
+    /* NeuronRuntime_inferenceAsync and pipeline mode (see worker.h) */
+    ShimWorker*   worker;     /* started on first use */
+    ShimExec*     async_exec; /* what the worker runs */
+    ShimPipeline* pipe;       /* pipeline mode, else NULL */
+
+    _Atomic int   profile_left;   /* inferences still to profile (profile.h) */
+
+    ShimRuntimeStats stats;
 } ShimRuntime;
 
 /* ------------------------------------------------------------------ */
@@ -58,21 +143,180 @@ static const NeuronShimBackend* g_backend = NULL;
 static const char*              g_suffix  = NULL;
 static pthread_once_t g_init_once = PTHREAD_ONCE_INIT;
 
+/* ------------------------------------------------------------------ */
+/* Per-model routing                                                   */
+/*                                                                     */
+/* g_backend serves every model by default. A [model] section with     */
+/* 'backend = ...' sends matching models elsewhere; such backends are  */
+/* initialised the first time a model is routed to them and then run   */
+/* side by side with the default one.                                  */
+/* ------------------------------------------------------------------ */
+#define MAX_BACKENDS 4
+
+static struct {
+    char                     name[32];
+    const NeuronShimBackend* backend;   /* initialised (and traced) */
+} g_routes[MAX_BACKENDS];
+static int             g_route_count = 0;
+static pthread_mutex_t g_route_lock  = PTHREAD_MUTEX_INITIALIZER;
+
+/* Backend 'name', set up on first use; NULL if it isn't available */
+static const NeuronShimBackend* backend_named(const char* name) {
+    /* Plugin variants (onnx-cpu) report their base name */
+    if (strcmp(name, g_backend->name) == 0 || strcmp(name, g_config->backend) == 0)
+        return g_backend;
+
+    pthread_mutex_lock(&g_route_lock);
+    const NeuronShimBackend* b = NULL;
+    int i = 0;
+    while (i < g_route_count && strcmp(g_routes[i].name, name) != 0) i++;
+
+    if (i < g_route_count) {
+        b = g_routes[i].backend;
+    } else {
+        b = neuron_shim_load_backend(name);
+        if (!b) {
+            LOG_WARN("backend %s not installed", name);
+        } else if (b->init && b->init(g_config) != 0) {
+            LOG_ERR("backend %s init failed", name);
+            b = NULL;
+        } else if (g_config->trace_file[0] != '\0') {
+            b = neuron_shim_trace_wrap(b, g_config, g_suffix);
+        }
+        if (b) LOG_INFO("backend %s: enabled for routed models", name);
+
+        /* Remember failures too, so they're only reported once */
+        if (g_route_count < MAX_BACKENDS) {
+            snprintf(g_routes[g_route_count].name,
+                     sizeof(g_routes[g_route_count].name), "%s", name);
+            g_routes[g_route_count++].backend = b;
+        }
+    }
+    pthread_mutex_unlock(&g_route_lock);
+    return b;
+}
+
+/* Backend and model suffix for the .dla at 'path' */
+static const NeuronShimBackend* route_model(const char* path,
+                                            const char** suffix) {
+    const NeuronShimModelConfig* mc = neuron_shim_config_model(g_config, path);
+    *suffix = g_suffix;
+    if (!mc) return g_backend;
+
+    const NeuronShimBackend* b = mc->backend[0] ? backend_named(mc->backend) : g_backend;
+    if (!b) {
+        LOG_WARN("%s: using %s instead", path, g_backend->name);
+        b = g_backend;
+        if (!mc->suffix[0]) return b;   /* keep the suffix g_backend wants */
+    }
+    *suffix = neuron_shim_config_model_suffix(g_config, mc);
+    return b;
+}
+
+/* ------------------------------------------------------------------ */
+/* Preloading                                                          */
+/*                                                                     */
+/* Models listed in 'preload' are reserved in the model cache during   */
+/* init, then loaded and warmed up on a background thread. A later     */
+/* loadNetworkFromFile for the same file attaches to the warm model,   */
+/* or waits for it if it is still loading. Preloaded models stay       */
+/* pinned in the cache for the life of the process.                    */
+/* ------------------------------------------------------------------ */
+#define MAX_PRELOAD 16
+
+static ShimModelEntry* g_preload[MAX_PRELOAD];
+static int             g_preload_count = 0;
+
+static void* preload_thread(void* arg) {
+    (void)arg;
+    for (int i = 0; i < g_preload_count; i++) {
+        if (neuron_shim_cache_fill(g_preload[i], g_config->warmup_runs) != 0) {
+            LOG_WARN("preload failed");
+            g_preload[i] = NULL;
+        }
+    }
+    LOG_INFO("preload: done (%d models)", g_preload_count);
+    return NULL;
+}
+
+static void start_preload(void) {
+    if (g_config->preload[0] == '\0') return;
+    if (!g_config->model_cache) {
+        LOG_WARN("preload needs model_cache, ignoring");
+        return;
+    }
+
+    char list[sizeof(g_config->preload)];
+    snprintf(list, sizeof(list), "%s", g_config->preload);
+
+    char* save = NULL;
+    for (char* p = strtok_r(list, ",", &save); p; p = strtok_r(NULL, ",", &save)) {
+        if (g_preload_count == MAX_PRELOAD) {
+            LOG_WARN("preload: more than %d models, ignoring the rest",
+                     MAX_PRELOAD);
+            break;
+        }
+
+        const char* suffix;
+        const NeuronShimBackend* backend = route_model(p, &suffix);
+        if (!backend->model_load) {
+            LOG_WARN("preload: backend %s has no shared models, skipping %s",
+                     backend->name, p);
+            continue;
+        }
+
+        char resolved[1024];
+        if (neuron_shim_resolve_model(p, suffix, g_config->model_dir,
+                                      resolved, sizeof(resolved)) != 0) {
+            LOG_WARN("preload: model not found: %s%s", p, suffix);
+            continue;
+        }
+
+        ShimModelEntry* e = neuron_shim_cache_reserve(backend, resolved);
+        if (!e) continue;   /* listed twice */
+        g_preload[g_preload_count++] = e;
+        LOG_INFO("preload: %s", resolved);
+    }
+    if (g_preload_count == 0) return;
+
+    pthread_attr_t attr;
+    pthread_t      thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, preload_thread, NULL) != 0) {
+        /* No thread: load inline rather than leave entries stuck LOADING */
+        LOG_WARN("preload: can't start thread, loading synchronously");
+        preload_thread(NULL);
+    }
+    pthread_attr_destroy(&attr);
+}
+
 static void shim_global_init(void) {
     /* Load config from files + env */
     g_config = neuron_shim_config_load();
-    g_log_level = g_config->log_level;
+    neuron_shim_log_init(g_config->log_level, g_config->log_rate_limit);
 
     LOG_INFO("=== neuron-shim initializing ===");
-    LOG_INFO("config: backend=%s suffix=%s threads=%d force_cpu=%d",
+    LOG_INFO("config: backend=%s suffix=%s threads=%d force_cpu=%d "
+             "global_thread_pool=%d",
              g_config->backend, g_config->suffix,
-             g_config->threads, g_config->force_cpu);
+             g_config->threads, g_config->force_cpu,
+             g_config->global_thread_pool);
     if (g_config->model_dir[0] != '\0')
         LOG_INFO("config: model_dir=%s", g_config->model_dir);
 
+    /* Before the backends, which ask it what to profile */
+    if (g_config->profile_file[0] != '\0')
+        neuron_shim_profile_open(g_config);
+
     /* Select backend */
     g_backend = neuron_shim_select_backend(
         strcmp(g_config->backend, "auto") == 0 ? NULL : g_config->backend);
+    if (g_backend->init && g_backend->init(g_config) != 0) {
+        LOG_ERR("backend %s init failed, falling back to stub",
+                g_backend->name);
+        g_backend = neuron_shim_backend_stub();
+    }
     LOG_INFO("active backend: %s", g_backend->name);
 
     /* Resolve suffix */
@@ -83,12 +327,310 @@ static void shim_global_init(void) {
                  g_config->model_dir, g_suffix);
     else
         LOG_INFO("model resolution: <path>.dla → <path>.dla%s", g_suffix);
+
+    /* Wrap before preload so warm-up contexts show up in the trace too */
+    if (g_config->trace_file[0] != '\0')
+        g_backend = neuron_shim_trace_wrap(g_backend, g_config, g_suffix);
+
+    if (g_config->hot_swap) {
+        if (g_config->model_cache) neuron_shim_cache_watch(g_config->warmup_runs);
+        else LOG_WARN("hot_swap needs model_cache, ignoring");
+    }
+    start_preload();
+
+    if (g_config->stats_dump[0] != '\0')
+        neuron_shim_stats_install_dump(g_config->stats_dump);
 }
 
 static inline void ensure_init(void) {
     pthread_once(&g_init_once, shim_global_init);
 }
 
+static inline bool profiling(ShimRuntime* rt) {
+    return atomic_load_explicit(&rt->profile_left, memory_order_relaxed) > 0;
+}
+
+static const char* base_name(const char* path) {
+    const char* slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+/* ------------------------------------------------------------------ */
+/* Tensor conversion                                                   */
+/* ------------------------------------------------------------------ */
+static ShimTensorConv* conv_get(ShimTensorConv* list, int index) {
+    if (!list || index < 0 || index >= NEURON_SHIM_MAX_IO) return NULL;
+    return list[index].staging ? &list[index] : NULL;
+}
+
+static void conv_free(ShimExec* e) {
+    for (int i = 0; i < NEURON_SHIM_MAX_IO; i++) {
+        if (e->conv_inputs)  neuron_shim_conv_free(&e->conv_inputs[i]);
+        if (e->conv_outputs) neuron_shim_conv_free(&e->conv_outputs[i]);
+    }
+    free(e->conv_inputs);
+    free(e->conv_outputs);
+    e->conv_inputs = e->conv_outputs = NULL;
+}
+
+static int conv_setup_list(ShimRuntime* rt, ShimExec* e,
+                           const NeuronShimTensorConv* specs,
+                           bool inputs, ShimTensorConv** out) {
+    for (int i = 0; i < NEURON_SHIM_MAX_IO; i++) {
+        if (!specs[i].enabled) continue;
+
+        ShimTensorDesc desc;
+        int rc = inputs
+            ? rt->backend->get_input_info(e->backend_ctx, i, &desc)
+            : rt->backend->get_output_info(e->backend_ctx, i, &desc);
+        if (rc != 0) {
+            LOG_ERR("%s.%d: no such tensor in the model",
+                    inputs ? "input" : "output", i);
+            return -1;
+        }
+
+        if (!*out) *out = calloc(NEURON_SHIM_MAX_IO, sizeof(ShimTensorConv));
+        if (!*out) return -1;
+
+        char what[32];
+        snprintf(what, sizeof(what), "%s.%d", inputs ? "input" : "output", i);
+        if (neuron_shim_conv_setup(&(*out)[i], &specs[i], &desc, what) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+/* Apply the runtime's [model] section, if any, to e */
+static int conv_setup(ShimRuntime* rt, ShimExec* e) {
+    conv_free(e);
+
+    const NeuronShimModelConfig* mc = rt->config;
+    if (!mc) return 0;
+
+    bool wanted = false;
+    for (int i = 0; i < NEURON_SHIM_MAX_IO; i++)
+        wanted |= mc->inputs[i].enabled || mc->outputs[i].enabled;
+    if (!wanted) return 0;
+
+    if (!rt->backend->get_input_info || !rt->backend->get_output_info) {
+        LOG_WARN("backend %s has no tensor info, ignoring conversions for [model %s]",
+                 rt->backend->name, mc->pattern);
+        return 0;
+    }
+
+    if (conv_setup_list(rt, e, mc->inputs, true, &e->conv_inputs) != 0 ||
+        conv_setup_list(rt, e, mc->outputs, false, &e->conv_outputs) != 0) {
+        conv_free(e);
+        return -1;
+    }
+    return 0;
+}
+
+static void fill_info(NeuronTensorInfo* info, const ShimTensorDesc* d) {
+    info->dimensionCount = d->rank;
+    for (uint32_t i = 0; i < d->rank && i < 8; i++)
+        info->dimensions[i] = d->dims[i];
+    info->type      = d->type;
+    info->scale     = d->scale;
+    info->zeroPoint = d->zero_point;
+    info->sizeBytes = d->size;
+}
+
+/* ------------------------------------------------------------------ */
+/* Pipeline mode                                                       */
+/* ------------------------------------------------------------------ */
+static void pipe_free(ShimRuntime* rt) {
+    if (!rt->pipe) return;
+    for (int i = 0; i < NEURON_SHIM_MAX_IO; i++) {
+        for (int k = 0; k < 2; k++) {
+            free(rt->pipe->inputs[i].slot[k]);
+            free(rt->pipe->outputs[i].slot[k]);
+        }
+    }
+    free(rt->pipe);
+    rt->pipe = NULL;
+}
+
+/* t's buffer in slot k, grown to the app buffer's size */
+static void* pipe_slot(ShimPipeTensor* t, int k) {
+    if (t->slot_size[k] < t->size) {
+        void* p = realloc(t->slot[k], t->size);
+        if (!p) return NULL;
+        t->slot[k]      = p;
+        t->slot_size[k] = t->size;
+    }
+    return t->slot[k];
+}
+
+/* ------------------------------------------------------------------ */
+/* Per-thread execution state                                          */
+/* ------------------------------------------------------------------ */
+static void execs_release(ShimRuntime* rt) {
+    int n = atomic_load(&rt->exec_count);
+    for (int i = 0; i < n; i++) {
+        rt->backend->destroy(rt->execs[i]->backend_ctx);
+        neuron_shim_cache_release(rt->execs[i]->model);
+        conv_free(rt->execs[i]);
+        free(rt->execs[i]);
+        rt->execs[i] = NULL;
+    }
+    atomic_store(&rt->exec_count, 0);
+}
+
+static int bind_input(ShimRuntime* rt, ShimExec* e, int index,
+                      const void* buffer, size_t size);
+static int bind_output(ShimRuntime* rt, ShimExec* e, int index,
+                       void* buffer, size_t size);
+
+/* Bind e to the buffers the app gave main. Called under exec_lock. */
+static int exec_seed(ShimRuntime* rt, ShimExec* e) {
+    int rc = NEURONRUNTIME_NO_ERROR;
+    for (int i = 0; rc == NEURONRUNTIME_NO_ERROR && i < NEURON_SHIM_MAX_IO; i++) {
+        const ShimBinding* in  = &rt->main.inputs[i];
+        const ShimBinding* out = &rt->main.outputs[i];
+        if (in->app)
+            rc = bind_input(rt, e, i, in->app, in->app_size);
+        if (rc == NEURONRUNTIME_NO_ERROR && out->app)
+            rc = bind_output(rt, e, i, out->app, out->app_size);
+    }
+    e->seen_gen = atomic_load(&rt->bind_gen);
+    return rc;
+}
+
+/* A fresh context attached to the runtime's shared model, bound like main */
+static ShimExec* exec_create(ShimRuntime* rt) {
+    if (!rt->main.model || !rt->backend->attach) {
+        if (!rt->exec_warned)
+            LOG_WARN("runtime %p used from several threads but its model isn't "
+                     "shared (model_cache off, buffer load or %s backend): "
+                     "threads share one context and must not overlap",
+                     (void*)rt, rt->backend->name);
+        rt->exec_warned = true;
+        return NULL;
+    }
+
+    ShimExec* e = (ShimExec*)calloc(1, sizeof(ShimExec));
+    if (!e) return NULL;
+    if (rt->backend->create(&e->backend_ctx) != 0) {
+        free(e);
+        return NULL;
+    }
+    e->model = neuron_shim_cache_newest(rt->main.model);
+    if (rt->backend->attach(e->backend_ctx, neuron_shim_cache_model(e->model)) != 0 ||
+        conv_setup(rt, e) != 0 || exec_seed(rt, e) != NEURONRUNTIME_NO_ERROR) {
+        rt->backend->destroy(e->backend_ctx);
+        neuron_shim_cache_release(e->model);
+        conv_free(e);
+        free(e);
+        return NULL;
+    }
+    return e;
+}
+
+/*
+ * Hot swap: move e onto the newest version of its model. The new
+ * context gets its own conversions (the new version may lay tensors out
+ * differently) and e's app buffers; the old one, and with it the last
+ * use of the old version by this thread, goes away.
+ */
+static void exec_swap(ShimRuntime* rt, ShimExec* e) {
+    ShimExec next = { .model = neuron_shim_cache_newest(e->model) };
+    int rc = rt->backend->create(&next.backend_ctx);
+    if (rc == 0) rc = rt->backend->attach(next.backend_ctx,
+                                          neuron_shim_cache_model(next.model));
+    if (rc == 0) rc = conv_setup(rt, &next);
+    for (int i = 0; rc == 0 && i < NEURON_SHIM_MAX_IO; i++) {
+        if (e->inputs[i].app &&
+            bind_input(rt, &next, i, e->inputs[i].app, e->inputs[i].app_size) != 0)
+            rc = -1;
+        if (rc == 0 && e->outputs[i].app &&
+            bind_output(rt, &next, i, e->outputs[i].app, e->outputs[i].app_size) != 0)
+            rc = -1;
+    }
+    if (rc != 0) {
+        LOG_ERR("hot swap failed for runtime %p, staying on the old model", (void*)rt);
+        if (next.backend_ctx) rt->backend->destroy(next.backend_ctx);
+        neuron_shim_cache_release(next.model);
+        conv_free(&next);
+        e->pinned = true;
+        return;
+    }
+
+    /* Queries, the stats hooks and exec_create() read main under the lock,
+     * so nothing can still be using the old context once it is released */
+    pthread_mutex_lock(&rt->exec_lock);
+    ShimExec old = {
+        .backend_ctx  = e->backend_ctx,
+        .model        = e->model,
+        .conv_inputs  = e->conv_inputs,
+        .conv_outputs = e->conv_outputs,
+    };
+    e->backend_ctx  = next.backend_ctx;
+    e->model        = next.model;
+    e->conv_inputs  = next.conv_inputs;
+    e->conv_outputs = next.conv_outputs;
+    memcpy(e->inputs, next.inputs, sizeof(e->inputs));
+    memcpy(e->outputs, next.outputs, sizeof(e->outputs));
+    pthread_mutex_unlock(&rt->exec_lock);
+
+    rt->backend->destroy(old.backend_ctx);
+    neuron_shim_cache_release(old.model);
+    conv_free(&old);
+    LOG_INFO("runtime %p: now on the new version of %s", (void*)rt, rt->stats.model);
+}
+
+/*
+ * The calling thread's execution state. The first thread to bind or
+ * run takes 'main'; later ones get their own, up to MAX_EXECS, after
+ * which they fall back to sharing 'main'.
+ */
+static ShimExec* exec_for(ShimRuntime* rt) {
+    pthread_t self = pthread_self();
+    if (atomic_load_explicit(&rt->main.claimed, memory_order_acquire) &&
+        pthread_equal(rt->main.thread, self))
+        return &rt->main;
+
+    int n = atomic_load_explicit(&rt->exec_count, memory_order_acquire);
+    for (int i = 0; i < n; i++)
+        if (pthread_equal(rt->execs[i]->thread, self)) return rt->execs[i];
+
+    pthread_mutex_lock(&rt->exec_lock);
+    ShimExec* e = &rt->main;
+    if (!atomic_load(&rt->main.claimed)) {
+        rt->main.thread = self;
+        atomic_store_explicit(&rt->main.claimed, true, memory_order_release);
+    } else if (n < MAX_EXECS && (e = exec_create(rt)) != NULL) {
+        e->thread = self;
+        rt->execs[n] = e;
+        atomic_store_explicit(&rt->exec_count, n + 1, memory_order_release);
+        LOG_DBG("runtime %p: execution context %d for a new thread", (void*)rt, n + 1);
+    } else {
+        e = &rt->main;
+    }
+    pthread_mutex_unlock(&rt->exec_lock);
+    return e;
+}
+
+/* Stats hook: allocator usage of the main context's model */
+static int runtime_memory(void* arg, NeuronShimMemoryStats* out) {
+    ShimRuntime* rt = (ShimRuntime*)arg;
+    pthread_mutex_lock(&rt->exec_lock);
+    int rc = rt->backend->memory_usage
+           ? rt->backend->memory_usage(rt->main.backend_ctx, out) : -1;
+    pthread_mutex_unlock(&rt->exec_lock);
+    return rc;
+}
+
+/* Stats hook: providers of the main context's model */
+static int runtime_providers(void* arg, char* out, size_t len) {
+    ShimRuntime* rt = (ShimRuntime*)arg;
+    pthread_mutex_lock(&rt->exec_lock);
+    int rc = rt->backend->providers
+           ? rt->backend->providers(rt->main.backend_ctx, out, len) : -1;
+    pthread_mutex_unlock(&rt->exec_lock);
+    return rc;
+}
+
 /* ------------------------------------------------------------------ */
 /* NeuronRuntime_create                                                */
 /* ------------------------------------------------------------------ */
@@ -102,15 +644,24 @@ int NeuronRuntime_create(const RuntimeConfig* config, NeuronRuntime* runtime) {
         return NEURONRUNTIME_OP_FAILED;
     }
 
-    rt->backend = g_backend;
+    rt->backend  = g_backend;
+    rt->priority = NEURONRUNTIME_PRIORITY_MED;
+    pthread_mutex_init(&rt->exec_lock, NULL);
 
-    int err = rt->backend->create(&rt->backend_ctx);
+    int err = rt->backend->create(&rt->main.backend_ctx);
     if (err != 0) {
         LOG_ERR("backend create failed: %d", err);
         free(rt);
         return NEURONRUNTIME_OP_FAILED;
     }
 
+    rt->stats.runtime = rt;
+    rt->stats.backend = rt->backend->name;
+    rt->stats.memory    = runtime_memory;
+    rt->stats.providers = runtime_providers;
+    rt->stats.hook_arg  = rt;
+    neuron_shim_stats_register(&rt->stats);
+
     *(ShimRuntime**)runtime = rt;
     LOG_DBG("runtime created: %p", (void*)rt);
     return NEURONRUNTIME_NO_ERROR;
@@ -124,7 +675,14 @@ int NeuronRuntime_release(NeuronRuntime runtime) {
     if (!rt) return NEURONRUNTIME_UNEXPECTED_NULL;
 
     LOG_DBG("runtime release: %p", (void*)rt);
-    rt->backend->destroy(rt->backend_ctx);
+    neuron_shim_worker_destroy(rt->worker);   /* finishes a pending run */
+    pipe_free(rt);
+    neuron_shim_stats_unregister(&rt->stats);
+    execs_release(rt);
+    rt->backend->destroy(rt->main.backend_ctx);
+    neuron_shim_cache_release(rt->main.model);  /* after destroy: ctx uses it */
+    conv_free(&rt->main);
+    pthread_mutex_destroy(&rt->exec_lock);
     free(rt);
     return NEURONRUNTIME_NO_ERROR;
 }
@@ -132,29 +690,196 @@ int NeuronRuntime_release(NeuronRuntime runtime) {
 /* ------------------------------------------------------------------ */
 /* Model loading                                                       */
 /* ------------------------------------------------------------------ */
+/*
+ * Move a runtime that hasn't loaded anything yet to the backend its
+ * model is routed to. Buffers bound before loading were given to the
+ * old backend context and have to be set again.
+ */
+static int switch_backend(ShimRuntime* rt, const NeuronShimBackend* backend) {
+    if (rt->stats.model[0] != '\0') {
+        LOG_ERR("runtime already has a model loaded on %s", rt->backend->name);
+        return -1;
+    }
+
+    void* ctx = NULL;
+    if (backend->create(&ctx) != 0) {
+        LOG_ERR("backend %s create failed", backend->name);
+        return -1;
+    }
+    pthread_mutex_lock(&rt->exec_lock);   /* runtime_memory(), runtime_providers() */
+    rt->backend->destroy(rt->main.backend_ctx);
+    rt->backend          = backend;
+    rt->main.backend_ctx = ctx;
+    pthread_mutex_unlock(&rt->exec_lock);
+    rt->stats.backend = backend->name;
+    LOG_INFO("routed to backend %s", backend->name);
+    return 0;
+}
+
+/*
+ * Load the model file 'resolved' that stands in for the app's 'path'
+ * onto rt's (already routed) backend, through the model cache if it
+ * can be shared. Resolving the path started at 'resolve_ns'.
+ */
+static int load_resolved(ShimRuntime* rt, const char* path, const char* resolved,
+                         uint64_t resolve_ns) {
+    LOG_INFO("loading: %s", resolved);
+    execs_release(rt);   /* attached to the previous model */
+    uint64_t t0 = neuron_shim_now_ns();
+    int ret;
+    if (g_config->model_cache && rt->backend->model_load && !rt->main.model) {
+        /* Share one backend model between every runtime loading this file */
+        rt->main.model = neuron_shim_cache_acquire(rt->backend, resolved);
+        ret = rt->main.model
+            ? rt->backend->attach(rt->main.backend_ctx,
+                                  neuron_shim_cache_model(rt->main.model))
+            : -1;
+        if (ret != 0) {
+            neuron_shim_cache_release(rt->main.model);
+            rt->main.model = NULL;
+        }
+    } else {
+        ret = rt->backend->load_from_file(rt->main.backend_ctx, resolved);
+    }
+    uint64_t t1 = neuron_shim_now_ns();
+    neuron_shim_hist_record(&rt->stats.load, t1 - t0);
+    if (ret != 0) {
+        LOG_ERR("backend failed to load: %s", resolved);
+        return NEURONRUNTIME_OP_FAILED;
+    }
+
+    snprintf(rt->stats.model, sizeof(rt->stats.model), "%s", resolved);
+
+    rt->config = neuron_shim_config_model(g_config, path);
+    atomic_store(&rt->profile_left, neuron_shim_profile_runs(g_config, rt->config));
+    if (profiling(rt)) {
+        char name[300];
+        snprintf(name, sizeof(name), "resolve %s", base_name(path));
+        neuron_shim_profile_span("shim", name, resolve_ns, t0, NULL);
+        snprintf(name, sizeof(name), "load %s", base_name(resolved));
+        neuron_shim_profile_span("shim", name, t0, t1, "\"backend\":\"%s\","
+                                 "\"shared\":%s", rt->backend->name,
+                                 rt->main.model ? "true" : "false");
+    }
+    if (conv_setup(rt, &rt->main) != 0) {
+        LOG_ERR("bad tensor conversion config for %s", path);
+        return NEURONRUNTIME_BAD_DATA;
+    }
+
+    pipe_free(rt);
+    if (rt->config && rt->config->pipeline) {
+        rt->pipe = (ShimPipeline*)calloc(1, sizeof(ShimPipeline));
+        if (!rt->pipe) return NEURONRUNTIME_OP_FAILED;
+        LOG_INFO("pipeline mode: inference returns the previous frame's outputs");
+    }
+    return NEURONRUNTIME_NO_ERROR;
+}
+
 int NeuronRuntime_loadNetworkFromFile(NeuronRuntime runtime, const char* path) {
     ShimRuntime* rt = (ShimRuntime*)runtime;
     if (!rt || !path) return NEURONRUNTIME_UNEXPECTED_NULL;
 
     LOG_INFO("loadNetwork: %s", path);
 
+    const char* suffix;
+    const NeuronShimBackend* backend = route_model(path, &suffix);
+    if (backend != rt->backend && switch_backend(rt, backend) != 0)
+        return NEURONRUNTIME_OP_FAILED;
+
     /* Resolve: model.dla → model.dla.onnx (or redirect via model_dir) */
+    uint64_t t0 = neuron_shim_now_ns();
     char resolved[1024];
-    int rc = neuron_shim_resolve_model(path, g_suffix, g_config->model_dir,
+    int rc = neuron_shim_resolve_model(path, suffix, g_config->model_dir,
                                         resolved, sizeof(resolved));
     if (rc != 0) {
-        LOG_ERR("model not found: %s%s", path, g_suffix);
+        LOG_ERR("model not found: %s%s", path, suffix);
         return NEURONRUNTIME_BAD_DATA;
     }
 
-    LOG_INFO("loading: %s", resolved);
-    int ret = rt->backend->load_from_file(rt->backend_ctx, resolved);
-    if (ret != 0) {
-        LOG_ERR("backend failed to load: %s", resolved);
-        return NEURONRUNTIME_OP_FAILED;
+    return load_resolved(rt, path, resolved, t0);
+}
+
+/*
+ * Buffer loads
+ *
+ * Apps that embed their .dla hand the same blob (usually straight out
+ * of .rodata) to every runtime they create. Its content hash names the
+ * replacement model, "<model_dir>/<hash>.dla<suffix>", which then loads
+ * like any file: mmapped by the backend and shared through the model
+ * cache.
+ *
+ * Blobs in read-only mappings (.rodata, a PROT_READ mmap) can't change
+ * under us, so their hashes are memoized by (address, size, sampled head
+ * and tail) and repeat loads don't re-read them. Anything writable, like
+ * a heap buffer, may be reused for a different model of the same size
+ * (fine-tuned variants usually match at both ends too), so it is hashed
+ * in full on every load.
+ */
+#define BLOB_MEMO  16
+#define BLOB_PROBE 4096   /* bytes sampled at each end */
+
+static struct {
+    const void* buf;
+    size_t      size;
+    uint64_t    sample;
+    uint64_t    hash;
+} g_blobs[BLOB_MEMO];
+static unsigned        g_blob_next = 0;
+static pthread_mutex_t g_blob_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t blob_sample(const void* buf, size_t size) {
+    size_t n = size < BLOB_PROBE ? size : BLOB_PROBE;
+    return neuron_shim_hash_buffer(buf, n) ^
+           neuron_shim_hash_buffer((const char*)buf + size - n, n) * 31;
+}
+
+/* Whether [buf, buf + size) lies in one mapping without write access */
+static bool blob_readonly(const void* buf, size_t size) {
+    FILE* f = fopen("/proc/self/maps", "r");
+    if (!f) return false;
+
+    uintptr_t lo = (uintptr_t)buf, hi = lo + size;
+    bool ro = false;
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long start, end;
+        char perms[5];
+        if (sscanf(line, "%lx-%lx %4s", &start, &end, perms) != 3) continue;
+        if (lo >= start && lo < end) {
+            ro = hi <= end && perms[0] == 'r' && perms[1] != 'w';
+            break;
+        }
     }
+    fclose(f);
+    return ro;
+}
 
-    return NEURONRUNTIME_NO_ERROR;
+static uint64_t blob_hash(const void* buf, size_t size) {
+    if (!blob_readonly(buf, size)) return neuron_shim_hash_buffer(buf, size);
+
+    uint64_t sample = blob_sample(buf, size);
+
+    pthread_mutex_lock(&g_blob_lock);
+    for (int i = 0; i < BLOB_MEMO; i++) {
+        if (g_blobs[i].buf == buf && g_blobs[i].size == size &&
+            g_blobs[i].sample == sample) {
+            uint64_t hash = g_blobs[i].hash;
+            pthread_mutex_unlock(&g_blob_lock);
+            return hash;
+        }
+    }
+    pthread_mutex_unlock(&g_blob_lock);
+
+    uint64_t hash = neuron_shim_hash_buffer(buf, size);
+
+    pthread_mutex_lock(&g_blob_lock);
+    unsigned slot = g_blob_next++ % BLOB_MEMO;
+    g_blobs[slot].buf    = buf;
+    g_blobs[slot].size   = size;
+    g_blobs[slot].sample = sample;
+    g_blobs[slot].hash   = hash;
+    pthread_mutex_unlock(&g_blob_lock);
+    return hash;
 }
 
 int NeuronRuntime_loadNetworkFromBuffer(NeuronRuntime runtime,
@@ -163,13 +888,119 @@ int NeuronRuntime_loadNetworkFromBuffer(NeuronRuntime runtime,
     if (!rt || !buffer) return NEURONRUNTIME_UNEXPECTED_NULL;
 
     LOG_INFO("loadNetworkFromBuffer: %zu bytes", size);
-    int ret = rt->backend->load_from_buffer(rt->backend_ctx, buffer, size);
+
+    if (g_config->model_dir[0] && size > 0) {
+        uint64_t t0 = neuron_shim_now_ns();
+        uint64_t hash = blob_hash(buffer, size);
+        char name[32];
+        neuron_shim_blob_name(hash, name, sizeof(name));
+
+        const char* suffix;
+        const NeuronShimBackend* backend = route_model(name, &suffix);
+
+        char resolved[1024];
+        if (neuron_shim_resolve_blob(hash, suffix, g_config->model_dir,
+                                     resolved, sizeof(resolved)) == 0) {
+            if (backend != rt->backend && switch_backend(rt, backend) != 0)
+                return NEURONRUNTIME_OP_FAILED;
+            return load_resolved(rt, name, resolved, t0);
+        }
+        LOG_WARN("no %s%s in %s, passing the buffer to %s as is",
+                 name, suffix, g_config->model_dir, rt->backend->name);
+    }
+
+    uint64_t t0 = neuron_shim_now_ns();
+    int ret = rt->backend->load_from_buffer(rt->main.backend_ctx, buffer, size);
+    neuron_shim_hist_record(&rt->stats.load, neuron_shim_now_ns() - t0);
+    if (ret == 0)
+        snprintf(rt->stats.model, sizeof(rt->stats.model), "<buffer, %zu bytes>", size);
     return ret == 0 ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_OP_FAILED;
 }
 
 /* ------------------------------------------------------------------ */
 /* Input / Output                                                      */
 /* ------------------------------------------------------------------ */
+/* An inference started with NeuronRuntime_inferenceAsync owns its
+ * thread's buffers (pipeline mode only ever binds its own copies) */
+static bool busy(ShimRuntime* rt, const ShimExec* e, const char* what) {
+    if (rt->pipe || !rt->worker || rt->async_exec != e ||
+        !neuron_shim_worker_pending(rt->worker))
+        return false;
+    LOG_ERR("%s: async inference pending, call NeuronRuntime_wait first", what);
+    return true;
+}
+
+/* Record a pipeline-mode buffer; it is bound, as a slot copy, per frame */
+static int pipe_set(ShimPipeTensor* list, int index, void* buffer, size_t size) {
+    if (index < 0 || index >= NEURON_SHIM_MAX_IO) {
+        LOG_ERR("pipeline mode: tensor %d out of range", index);
+        return NEURONRUNTIME_BAD_DATA;
+    }
+    list[index].app  = buffer;
+    list[index].size = size;
+    return NEURONRUNTIME_NO_ERROR;
+}
+
+/* Record what e is bound to; main's bindings are read by other threads */
+static void bind_record(ShimRuntime* rt, ShimExec* e, ShimBinding* slot,
+                        ShimBinding b) {
+    if (e != &rt->main) {
+        *slot = b;
+        return;
+    }
+    pthread_mutex_lock(&rt->exec_lock);
+    *slot = b;
+    atomic_fetch_add(&rt->bind_gen, 1);
+    pthread_mutex_unlock(&rt->exec_lock);
+}
+
+static int bind_input(ShimRuntime* rt, ShimExec* e, int index,
+                      const void* buffer, size_t size) {
+    void*  app      = (void*)buffer;
+    size_t app_size = size;
+
+    /* Converted tensors: the backend reads staging, filled at inference */
+    ShimTensorConv* conv = conv_get(e->conv_inputs, index);
+    if (conv) {
+        if (size < conv->app.sizeBytes) {
+            LOG_ERR("setInput[%d]: %zu bytes, need %zu", index, size,
+                    conv->app.sizeBytes);
+            return NEURONRUNTIME_BAD_DATA;
+        }
+        conv->app_buf = (void*)buffer;
+        buffer = conv->staging;
+        size   = conv->model.size;
+    }
+    int ret = rt->backend->set_input(e->backend_ctx, index, buffer, size);
+    if (ret == 0 && index >= 0 && index < NEURON_SHIM_MAX_IO)
+        bind_record(rt, e, &e->inputs[index],
+                    (ShimBinding){ (void*)buffer, size, app, app_size });
+    return ret == 0 ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_OP_FAILED;
+}
+
+static int bind_output(ShimRuntime* rt, ShimExec* e, int index,
+                       void* buffer, size_t size) {
+    void*  app      = buffer;
+    size_t app_size = size;
+
+    ShimTensorConv* conv = conv_get(e->conv_outputs, index);
+    if (conv) {
+        if (size < conv->app.sizeBytes) {
+            LOG_ERR("setOutput[%d]: %zu bytes, need %zu", index, size,
+                    conv->app.sizeBytes);
+            return NEURONRUNTIME_BAD_DATA;
+        }
+        conv->app_buf = buffer;
+        buffer = conv->staging;
+        size   = conv->model.size;
+    }
+    int ret = rt->backend->set_output(e->backend_ctx, index, buffer, size);
+    if (ret == 0 && index >= 0 && index < NEURON_SHIM_MAX_IO)
+        bind_record(rt, e, &e->outputs[index],
+                    (ShimBinding){ buffer, size, app, app_size });
+    return ret == 0 ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_OP_FAILED;
+}
+
 int NeuronRuntime_setInput(NeuronRuntime runtime,
                            int index, const void* buffer,
                            size_t size, int padding) {
@@ -177,8 +1008,20 @@ int NeuronRuntime_setInput(NeuronRuntime runtime,
     if (!rt) return NEURONRUNTIME_UNEXPECTED_NULL;
     (void)padding;
     LOG_DBG("setInput[%d] %zu bytes", index, size);
-    return rt->backend->set_input(rt->backend_ctx, index, buffer, size) == 0
-        ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_OP_FAILED;
+    ShimExec* e = exec_for(rt);
+    if (busy(rt, e, "setInput")) return NEURONRUNTIME_BAD_STATE;
+    e->own_bindings = true;
+    uint64_t t0 = neuron_shim_now_ns();
+
+    int ret = rt->pipe
+        ? pipe_set(rt->pipe->inputs, index, (void*)buffer, size)
+        : bind_input(rt, e, index, buffer, size);
+    uint64_t t1 = neuron_shim_now_ns();
+    neuron_shim_hist_record(&rt->stats.set_input, t1 - t0);
+    if (profiling(rt))
+        neuron_shim_profile_span("shim", "setInput", t0, t1,
+                                 "\"index\":%d,\"bytes\":%zu", index, size);
+    return ret;
 }
 
 int NeuronRuntime_setOutput(NeuronRuntime runtime,
@@ -188,36 +1031,90 @@ int NeuronRuntime_setOutput(NeuronRuntime runtime,
     if (!rt) return NEURONRUNTIME_UNEXPECTED_NULL;
     (void)padding;
     LOG_DBG("setOutput[%d] %zu bytes", index, size);
-    return rt->backend->set_output(rt->backend_ctx, index, buffer, size) == 0
-        ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_OP_FAILED;
+    ShimExec* e = exec_for(rt);
+    if (busy(rt, e, "setOutput")) return NEURONRUNTIME_BAD_STATE;
+    e->own_bindings = true;
+    uint64_t t0 = neuron_shim_now_ns();
+
+    int ret = rt->pipe
+        ? pipe_set(rt->pipe->outputs, index, buffer, size)
+        : bind_output(rt, e, index, buffer, size);
+    uint64_t t1 = neuron_shim_now_ns();
+    neuron_shim_hist_record(&rt->stats.set_output, t1 - t0);
+    if (profiling(rt))
+        neuron_shim_profile_span("shim", "setOutput", t0, t1,
+                                 "\"index\":%d,\"bytes\":%zu", index, size);
+    return ret;
 }
 
+/*
+ * Queries read main's context under exec_lock: a hot swap on the thread
+ * that owns main may replace it at any time.
+ */
 int NeuronRuntime_getInputCount(NeuronRuntime runtime, uint32_t* count) {
     ShimRuntime* rt = (ShimRuntime*)runtime;
     if (!rt || !count) return NEURONRUNTIME_UNEXPECTED_NULL;
-    return rt->backend->get_input_count(rt->backend_ctx, count) == 0
-        ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_OP_FAILED;
+    pthread_mutex_lock(&rt->exec_lock);
+    int rc = rt->backend->get_input_count(rt->main.backend_ctx, count);
+    pthread_mutex_unlock(&rt->exec_lock);
+    return rc == 0 ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_OP_FAILED;
 }
 
 int NeuronRuntime_getOutputCount(NeuronRuntime runtime, uint32_t* count) {
     ShimRuntime* rt = (ShimRuntime*)runtime;
     if (!rt || !count) return NEURONRUNTIME_UNEXPECTED_NULL;
-    return rt->backend->get_output_count(rt->backend_ctx, count) == 0
-        ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_OP_FAILED;
+    pthread_mutex_lock(&rt->exec_lock);
+    int rc = rt->backend->get_output_count(rt->main.backend_ctx, count);
+    pthread_mutex_unlock(&rt->exec_lock);
+    return rc == 0 ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_OP_FAILED;
+}
+
+static int query_size(ShimRuntime* rt, bool input, int index, size_t* size) {
+    ShimTensorConv* conv = conv_get(input ? rt->main.conv_inputs
+                                          : rt->main.conv_outputs, index);
+    if (conv) {
+        *size = conv->app.sizeBytes;
+        return 0;
+    }
+    return input ? rt->backend->get_input_size(rt->main.backend_ctx, index, size)
+                 : rt->backend->get_output_size(rt->main.backend_ctx, index, size);
 }
 
 int NeuronRuntime_getInputSize(NeuronRuntime runtime, int index, size_t* size) {
     ShimRuntime* rt = (ShimRuntime*)runtime;
     if (!rt || !size) return NEURONRUNTIME_UNEXPECTED_NULL;
-    return rt->backend->get_input_size(rt->backend_ctx, index, size) == 0
-        ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_OP_FAILED;
+    pthread_mutex_lock(&rt->exec_lock);
+    int rc = query_size(rt, true, index, size);
+    pthread_mutex_unlock(&rt->exec_lock);
+    return rc == 0 ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_OP_FAILED;
 }
 
 int NeuronRuntime_getOutputSize(NeuronRuntime runtime, int index, size_t* size) {
     ShimRuntime* rt = (ShimRuntime*)runtime;
     if (!rt || !size) return NEURONRUNTIME_UNEXPECTED_NULL;
-    return rt->backend->get_output_size(rt->backend_ctx, index, size) == 0
-        ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_OP_FAILED;
+    pthread_mutex_lock(&rt->exec_lock);
+    int rc = query_size(rt, false, index, size);
+    pthread_mutex_unlock(&rt->exec_lock);
+    return rc == 0 ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_OP_FAILED;
+}
+
+/* Converted tensors report the app's side, others the model's */
+static int query_info(ShimRuntime* rt, bool input, int index, NeuronTensorInfo* info) {
+    ShimTensorConv* conv = conv_get(input ? rt->main.conv_inputs
+                                          : rt->main.conv_outputs, index);
+    if (conv) {
+        *info = conv->app;
+        return 0;
+    }
+    int (*get_info)(void*, int, ShimTensorDesc*) =
+        input ? rt->backend->get_input_info : rt->backend->get_output_info;
+    if (get_info) {
+        ShimTensorDesc desc;
+        if (get_info(rt->main.backend_ctx, index, &desc) != 0) return -1;
+        fill_info(info, &desc);
+        return 0;
+    }
+    return query_size(rt, input, index, &info->sizeBytes);
 }
 
 int NeuronRuntime_getInputInfo(NeuronRuntime runtime,
@@ -225,8 +1122,10 @@ int NeuronRuntime_getInputInfo(NeuronRuntime runtime,
     ShimRuntime* rt = (ShimRuntime*)runtime;
     if (!rt || !info) return NEURONRUNTIME_UNEXPECTED_NULL;
     memset(info, 0, sizeof(*info));
-    return rt->backend->get_input_size(rt->backend_ctx, index, &info->sizeBytes) == 0
-        ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_OP_FAILED;
+    pthread_mutex_lock(&rt->exec_lock);
+    int rc = query_info(rt, true, index, info);
+    pthread_mutex_unlock(&rt->exec_lock);
+    return rc == 0 ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_OP_FAILED;
 }
 
 int NeuronRuntime_getOutputInfo(NeuronRuntime runtime,
@@ -234,36 +1133,240 @@ int NeuronRuntime_getOutputInfo(NeuronRuntime runtime,
     ShimRuntime* rt = (ShimRuntime*)runtime;
     if (!rt || !info) return NEURONRUNTIME_UNEXPECTED_NULL;
     memset(info, 0, sizeof(*info));
-    return rt->backend->get_output_size(rt->backend_ctx, index, &info->sizeBytes) == 0
-        ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_OP_FAILED;
+    pthread_mutex_lock(&rt->exec_lock);
+    int rc = query_info(rt, false, index, info);
+    pthread_mutex_unlock(&rt->exec_lock);
+    return rc == 0 ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_OP_FAILED;
 }
 
 /* ------------------------------------------------------------------ */
 /* Inference                                                           */
 /* ------------------------------------------------------------------ */
-int NeuronRuntime_inference(NeuronRuntime runtime) {
-    ShimRuntime* rt = (ShimRuntime*)runtime;
-    if (!rt) return NEURONRUNTIME_UNEXPECTED_NULL;
+static void convert(ShimTensorConv* conv, int index, bool to_model, bool prof) {
+    uint64_t t0 = prof ? neuron_shim_now_ns() : 0;
+    if (to_model) neuron_shim_conv_to_model(conv);
+    else          neuron_shim_conv_to_app(conv);
+    if (prof)
+        neuron_shim_profile_span("shim", to_model ? "convert in" : "convert out",
+                                 t0, neuron_shim_now_ns(),
+                                 "\"index\":%d,\"bytes\":%zu", index,
+                                 conv->app.sizeBytes);
+}
+
+static int run_inference(ShimRuntime* rt, ShimExec* e) {
+    /* A replaced model file has finished loading in the background */
+    if (!e->pinned && neuron_shim_cache_stale(e->model)) exec_swap(rt, e);
+
+    /* Bound on another thread since this one last ran */
+    if (e != &rt->main && !e->own_bindings &&
+        e->seen_gen != atomic_load(&rt->bind_gen)) {
+        pthread_mutex_lock(&rt->exec_lock);
+        int rc = exec_seed(rt, e);
+        pthread_mutex_unlock(&rt->exec_lock);
+        if (rc != NEURONRUNTIME_NO_ERROR) return rc;
+    }
 
     LOG_DBG("inference begin");
-    int ret = rt->backend->invoke(rt->backend_ctx);
+    bool prof = profiling(rt);
+    uint64_t t0 = neuron_shim_now_ns();
+
+    /* Outside the priority gate: this is shim CPU work, not backend work */
+    if (e->conv_inputs)
+        for (int i = 0; i < NEURON_SHIM_MAX_IO; i++)
+            if (e->conv_inputs[i].staging)
+                convert(&e->conv_inputs[i], i, true, prof);
+
+    /* Yield to higher-priority runtimes that are queued or running */
+    bool gated = g_config->qos_scheduler;
+    if (gated) neuron_shim_sched_enter(rt->priority);
+
+    /* abortTime counts from when the inference actually starts */
+    ShimWatch watch;
+    bool armed = rt->abort_ns && rt->backend->abort;
+    if (armed) neuron_shim_watch_arm(&watch, rt->backend, e->backend_ctx,
+                                     rt->abort_ns);
+
+    uint64_t invoke_ns = prof ? neuron_shim_now_ns() : 0;
+    int ret = rt->backend->invoke(e->backend_ctx);
+    if (prof)
+        neuron_shim_profile_span("shim", "invoke", invoke_ns, neuron_shim_now_ns(),
+                                 "\"backend\":\"%s\"", rt->backend->name);
+
+    bool aborted = armed && neuron_shim_watch_disarm(&watch);
+    if (gated) neuron_shim_sched_leave(rt->priority);
+
+    if (e->conv_outputs && ret == 0 && !aborted)
+        for (int i = 0; i < NEURON_SHIM_MAX_IO; i++)
+            if (e->conv_outputs[i].staging)
+                convert(&e->conv_outputs[i], i, false, prof);
+
+    /* Includes time spent waiting on the priority gate */
+    uint64_t elapsed = neuron_shim_now_ns() - t0;
+    neuron_shim_hist_record(&rt->stats.inference, elapsed);
+    if (prof) {
+        neuron_shim_profile_span("shim", "inference", t0, t0 + elapsed,
+                                 "\"runtime\":\"%p\",\"status\":%d", (void*)rt, ret);
+        if (atomic_fetch_sub(&rt->profile_left, 1) == 1)
+            LOG_INFO("profiling done: %s", rt->stats.model);
+    }
+
     LOG_DBG("inference done: %d", ret);
+    if (aborted) {
+        LOG_WARN("inference aborted: exceeded abortTime %llu ns",
+                 (unsigned long long)rt->abort_ns);
+        return NEURONRUNTIME_OP_FAILED;
+    }
+    if (rt->deadline_ns && elapsed > rt->deadline_ns)
+        LOG_DBG("inference missed deadline: %llu ns > %llu ns",
+                (unsigned long long)elapsed,
+                (unsigned long long)rt->deadline_ns);
     return ret == 0 ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_OP_FAILED;
 }
 
+static int worker_job(void* arg) {
+    ShimRuntime* rt = (ShimRuntime*)arg;
+    return run_inference(rt, rt->async_exec);
+}
+
+static bool ensure_worker(ShimRuntime* rt) {
+    if (!rt->worker) rt->worker = neuron_shim_worker_create(worker_job, rt);
+    return rt->worker != NULL;
+}
+
+/*
+ * Pipeline mode: snapshot the app's inputs into the free slot, collect
+ * the frame in flight, start this one on the free slot and hand the
+ * collected outputs to the app. The first frame returns zeroed outputs.
+ */
+static int pipe_inference(ShimRuntime* rt) {
+    ShimPipeline* pp = rt->pipe;
+    int k = pp->next;
+
+    /* Overlaps with the previous frame, still running on slot !k */
+    bool prof = profiling(rt);
+    uint64_t t0 = neuron_shim_now_ns();
+    for (int i = 0; i < NEURON_SHIM_MAX_IO; i++) {
+        ShimPipeTensor* t = &pp->inputs[i];
+        if (!t->app) continue;
+        void* slot = pipe_slot(t, k);
+        if (!slot) return NEURONRUNTIME_OP_FAILED;
+        memcpy(slot, t->app, t->size);
+    }
+    for (int i = 0; i < NEURON_SHIM_MAX_IO; i++)
+        if (pp->outputs[i].app && !pipe_slot(&pp->outputs[i], k))
+            return NEURONRUNTIME_OP_FAILED;
+    if (prof)
+        neuron_shim_profile_span("shim", "pipeline copy in", t0, neuron_shim_now_ns(),
+                                 "\"slot\":%d", k);
+
+    int prev = NEURONRUNTIME_NO_ERROR;
+    if (pp->primed) neuron_shim_worker_wait(rt->worker, &prev);
+    pp->primed = false;
+
+    /* Backend bindings only change while nothing runs */
+    int ret = NEURONRUNTIME_NO_ERROR;
+    for (int i = 0; i < NEURON_SHIM_MAX_IO && ret == NEURONRUNTIME_NO_ERROR; i++)
+        if (pp->inputs[i].app)
+            ret = bind_input(rt, &rt->main, i, pp->inputs[i].slot[k], pp->inputs[i].size);
+    for (int i = 0; i < NEURON_SHIM_MAX_IO && ret == NEURONRUNTIME_NO_ERROR; i++)
+        if (pp->outputs[i].app)
+            ret = bind_output(rt, &rt->main, i, pp->outputs[i].slot[k], pp->outputs[i].size);
+    if (ret != NEURONRUNTIME_NO_ERROR) return ret;
+    rt->async_exec = &rt->main;
+    if (!ensure_worker(rt) || neuron_shim_worker_submit(rt->worker) != 0)
+        return NEURONRUNTIME_OP_FAILED;
+
+    /* Frame N-1's outputs, copied while frame N runs */
+    t0 = neuron_shim_now_ns();
+    for (int i = 0; i < NEURON_SHIM_MAX_IO; i++) {
+        ShimPipeTensor* t = &pp->outputs[i];
+        if (!t->app) continue;
+        if (t->slot_size[!k] >= t->size)
+            memcpy(t->app, t->slot[!k], t->size);
+        else
+            memset(t->app, 0, t->size);   /* nothing ran on that slot yet */
+    }
+    if (prof)
+        neuron_shim_profile_span("shim", "pipeline copy out", t0, neuron_shim_now_ns(),
+                                 "\"slot\":%d", !k);
+
+    pp->primed = true;
+    pp->next   = !k;
+    return prev;
+}
+
+int NeuronRuntime_inference(NeuronRuntime runtime) {
+    ShimRuntime* rt = (ShimRuntime*)runtime;
+    if (!rt) return NEURONRUNTIME_UNEXPECTED_NULL;
+    if (rt->pipe) return pipe_inference(rt);
+    ShimExec* e = exec_for(rt);
+    if (busy(rt, e, "inference")) return NEURONRUNTIME_BAD_STATE;
+    return run_inference(rt, e);
+}
+
+int NeuronRuntime_inferenceAsync(NeuronRuntime runtime) {
+    ShimRuntime* rt = (ShimRuntime*)runtime;
+    if (!rt) return NEURONRUNTIME_UNEXPECTED_NULL;
+    if (rt->pipe) {
+        LOG_ERR("inferenceAsync: runtime is in pipeline mode");
+        return NEURONRUNTIME_BAD_STATE;
+    }
+    ShimExec* e = exec_for(rt);
+    if (!ensure_worker(rt)) return NEURONRUNTIME_OP_FAILED;
+    if (neuron_shim_worker_pending(rt->worker)) {
+        LOG_ERR("inferenceAsync: async inference pending, call NeuronRuntime_wait first");
+        return NEURONRUNTIME_BAD_STATE;
+    }
+    rt->async_exec = e;
+    return neuron_shim_worker_submit(rt->worker) == 0
+        ? NEURONRUNTIME_NO_ERROR : NEURONRUNTIME_BAD_STATE;
+}
+
+int NeuronRuntime_wait(NeuronRuntime runtime) {
+    ShimRuntime* rt = (ShimRuntime*)runtime;
+    if (!rt) return NEURONRUNTIME_UNEXPECTED_NULL;
+
+    int ret;
+    if (rt->pipe || !rt->worker || neuron_shim_worker_wait(rt->worker, &ret) != 0) {
+        LOG_ERR("wait: no inferenceAsync pending");
+        return NEURONRUNTIME_BAD_STATE;
+    }
+    return ret;
+}
+
 /* ------------------------------------------------------------------ */
-/* QoS — all no-ops                                                    */
+/* QoS                                                                 */
+/*                                                                     */
+/* priority  → scheduler gate (see scheduler.h)                        */
+/* abortTime → watchdog → backend abort (ORT RunOptionsSetTerminate)   */
+/* deadline  → soft: only reported when missed                         */
+/* boostValue has no equivalent: thread pools are sized when a session */
+/* is created and are shared between runtimes, so it is ignored.       */
 /* ------------------------------------------------------------------ */
 int NeuronRuntime_setQoSOption(NeuronRuntime runtime, const QoSOptions* qos) {
-    (void)runtime; (void)qos;
+    ShimRuntime* rt = (ShimRuntime*)runtime;
+    if (!rt || !qos) return NEURONRUNTIME_UNEXPECTED_NULL;
+
+    rt->priority    = (int)qos->priority;
+    rt->abort_ns    = qos->abortTime;
+    rt->deadline_ns = qos->deadline;
+
+    if (rt->abort_ns && !rt->backend->abort)
+        LOG_WARN("backend %s can't abort inferences, abortTime ignored",
+                 rt->backend->name);
+    LOG_DBG("QoS: priority=%d abort=%llu ns deadline=%llu ns boost=%u",
+            rt->priority, (unsigned long long)rt->abort_ns,
+            (unsigned long long)rt->deadline_ns, qos->boostValue);
     return NEURONRUNTIME_NO_ERROR;
 }
 
+/* Returns a NeuronShimProfiledQoSData owned by the runtime */
 int NeuronRuntime_getProfiledQoSData(NeuronRuntime runtime, QoSOptions* qos) {
-    (void)runtime;
-    if (qos) {
-        qos->profiledQoSData = NULL;
-        qos->profiledQoSDataSize = 0;
-    }
+    ShimRuntime* rt = (ShimRuntime*)runtime;
+    if (!rt || !qos) return NEURONRUNTIME_UNEXPECTED_NULL;
+
+    neuron_shim_stats_snapshot(&rt->stats);
+    qos->profiledQoSData     = &rt->stats.snapshot;
+    qos->profiledQoSDataSize = sizeof(rt->stats.snapshot);
     return NEURONRUNTIME_NO_ERROR;
 }
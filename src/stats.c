@@ -0,0 +1,242 @@
+/*
+ * neuron-shim: Per-runtime latency statistics
+ */
+
+#include "stats.h"
+#include "log.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ------------------------------------------------------------------ */
+/* Histogram                                                           */
+/*                                                                     */
+/* Values 0..3 get their own bucket. Above that, each power of two     */
+/* [2^k, 2^(k+1)) is split into 4 equal sub-buckets.                   */
+/* ------------------------------------------------------------------ */
+#define MAX_MSB 40
+
+static int bucket_of(uint64_t v) {
+    if (v < 4) return (int)v;
+    int msb = 63 - __builtin_clzll(v);
+    if (msb > MAX_MSB) return SHIM_HIST_BUCKETS - 1;
+    int sub = (int)((v >> (msb - 2)) & 3);
+    return 4 + (msb - 2) * 4 + sub;
+}
+
+static uint64_t bucket_mid(int idx) {
+    if (idx < 4) return (uint64_t)idx;
+    int msb = (idx - 4) / 4 + 2;
+    int sub = (idx - 4) % 4;
+    uint64_t width = 1ull << (msb - 2);
+    return (uint64_t)(4 + sub) * width + width / 2;
+}
+
+void neuron_shim_hist_record(ShimHistogram* h, uint64_t ns) {
+    atomic_fetch_add_explicit(&h->buckets[bucket_of(ns)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum_ns, ns, memory_order_relaxed);
+
+    uint64_t max = atomic_load_explicit(&h->max_ns, memory_order_relaxed);
+    while (ns > max &&
+           !atomic_compare_exchange_weak_explicit(&h->max_ns, &max, ns,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed))
+        ;
+}
+
+void neuron_shim_hist_summary(const ShimHistogram* h, NeuronShimLatencyStats* out) {
+    /* Copy first so the percentiles agree with one consistent count */
+    uint64_t counts[SHIM_HIST_BUCKETS];
+    uint64_t total = 0;
+    for (int i = 0; i < SHIM_HIST_BUCKETS; i++) {
+        counts[i] = atomic_load_explicit(&h->buckets[i], memory_order_relaxed);
+        total += counts[i];
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->count  = total;
+    out->max_ns = atomic_load_explicit(&h->max_ns, memory_order_relaxed);
+    if (total == 0) return;
+    out->mean_ns = atomic_load_explicit(&h->sum_ns, memory_order_relaxed) / total;
+
+    const struct { uint64_t* dst; uint64_t permille; } q[] = {
+        { &out->p50_ns, 500 }, { &out->p90_ns, 900 }, { &out->p99_ns, 990 },
+    };
+    uint64_t seen = 0;
+    size_t   next = 0;
+    for (int i = 0; i < SHIM_HIST_BUCKETS && next < 3; i++) {
+        seen += counts[i];
+        while (next < 3 && seen * 1000 >= total * q[next].permille) {
+            uint64_t v = bucket_mid(i);
+            *q[next].dst = v < out->max_ns ? v : out->max_ns;
+            next++;
+        }
+    }
+}
+
+static void summarize(const ShimRuntimeStats* s, NeuronShimProfiledQoSData* d) {
+    d->version = NEURON_SHIM_QOS_DATA_VERSION;
+    d->size    = sizeof(*d);
+    snprintf(d->backend, sizeof(d->backend), "%s", s->backend ? s->backend : "");
+    neuron_shim_hist_summary(&s->inference,  &d->inference);
+    neuron_shim_hist_summary(&s->set_input,  &d->set_input);
+    neuron_shim_hist_summary(&s->set_output, &d->set_output);
+    neuron_shim_hist_summary(&s->load,       &d->load);
+
+    memset(&d->memory, 0, sizeof(d->memory));
+    if (s->memory && s->memory(s->hook_arg, &d->memory) != 0)
+        memset(&d->memory, 0, sizeof(d->memory));
+
+    d->eps[0] = '\0';
+    if (s->providers && s->providers(s->hook_arg, d->eps, sizeof(d->eps)) != 0)
+        d->eps[0] = '\0';
+}
+
+void neuron_shim_stats_snapshot(ShimRuntimeStats* s) {
+    summarize(s, &s->snapshot);
+}
+
+/* ------------------------------------------------------------------ */
+/* Registry                                                            */
+/* ------------------------------------------------------------------ */
+static pthread_mutex_t   g_reg_lock = PTHREAD_MUTEX_INITIALIZER;
+static ShimRuntimeStats* g_reg      = NULL;
+
+void neuron_shim_stats_register(ShimRuntimeStats* s) {
+    pthread_mutex_lock(&g_reg_lock);
+    s->next = g_reg;
+    g_reg   = s;
+    pthread_mutex_unlock(&g_reg_lock);
+}
+
+void neuron_shim_stats_unregister(ShimRuntimeStats* s) {
+    pthread_mutex_lock(&g_reg_lock);
+    for (ShimRuntimeStats** p = &g_reg; *p; p = &(*p)->next) {
+        if (*p == s) {
+            *p = s->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_reg_lock);
+}
+
+/* ------------------------------------------------------------------ */
+/* SIGUSR1 dump                                                        */
+/*                                                                     */
+/* The handler only writes a byte to a pipe; a helper thread does the  */
+/* formatting and file I/O outside signal context.                     */
+/* ------------------------------------------------------------------ */
+static int  g_dump_pipe[2] = { -1, -1 };
+static char g_dump_path[512];
+
+static void dump_line(FILE* f, const char* what, const NeuronShimLatencyStats* l) {
+    if (l->count == 0) return;
+    fprintf(f, "  %-10s count=%llu mean=%.1fus p50=%.1fus p90=%.1fus "
+            "p99=%.1fus max=%.1fus\n", what,
+            (unsigned long long)l->count, l->mean_ns / 1e3,
+            l->p50_ns / 1e3, l->p90_ns / 1e3, l->p99_ns / 1e3, l->max_ns / 1e3);
+}
+
+static void dump_all(void) {
+    FILE* f = strcmp(g_dump_path, "-") == 0 ? stderr : fopen(g_dump_path, "w");
+    if (!f) {
+        SHIM_WARN("stats", "can't open %s: %s",
+                  g_dump_path, strerror(errno));
+        return;
+    }
+
+    pthread_mutex_lock(&g_reg_lock);
+    int n = 0;
+    for (ShimRuntimeStats* s = g_reg; s; s = s->next, n++) {
+        NeuronShimProfiledQoSData d;
+        summarize(s, &d);
+
+        fprintf(f, "runtime %p backend=%s eps=%s model=%s\n", s->runtime,
+                d.backend, d.eps[0] ? d.eps : "-", s->model[0] ? s->model : "-");
+        dump_line(f, "inference",  &d.inference);
+        dump_line(f, "setInput",   &d.set_input);
+        dump_line(f, "setOutput",  &d.set_output);
+        dump_line(f, "load",       &d.load);
+        if (d.memory.host_peak || d.memory.device_peak)
+            fprintf(f, "  %-10s host=%.1fMB peak=%.1fMB device=%.1fMB peak=%.1fMB\n",
+                    "memory", d.memory.host_bytes / 1048576.0,
+                    d.memory.host_peak / 1048576.0, d.memory.device_bytes / 1048576.0,
+                    d.memory.device_peak / 1048576.0);
+    }
+    pthread_mutex_unlock(&g_reg_lock);
+    fprintf(f, "# %d runtimes\n", n);
+
+    if (f == stderr) fflush(f);
+    else fclose(f);
+}
+
+static void* dump_thread(void* arg) {
+    (void)arg;
+    char c;
+    for (;;) {
+        ssize_t n = read(g_dump_pipe[0], &c, 1);
+        if (n == 1) dump_all();
+        else if (n < 0 && errno != EINTR) break;
+    }
+    return NULL;
+}
+
+static void on_sigusr1(int sig) {
+    (void)sig;
+    int saved = errno;
+    ssize_t r = write(g_dump_pipe[1], "d", 1);   /* drops if pipe is full */
+    (void)r;
+    errno = saved;
+}
+
+int neuron_shim_stats_install_dump(const char* path) {
+    struct sigaction old;
+    if (sigaction(SIGUSR1, NULL, &old) != 0) return -1;
+    if (old.sa_handler != SIG_DFL || (old.sa_flags & SA_SIGINFO)) {
+        SHIM_WARN("stats", "SIGUSR1 already handled by the "
+                  "app, stats dump disabled");
+        return -1;
+    }
+
+    snprintf(g_dump_path, sizeof(g_dump_path), "%s", path);
+    if (pipe(g_dump_pipe) != 0) return -1;
+    fcntl(g_dump_pipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(g_dump_pipe[1], F_SETFD, FD_CLOEXEC);
+    fcntl(g_dump_pipe[1], F_SETFL, O_NONBLOCK);
+
+    /* Keep SIGUSR1 off the dump thread so the handler runs elsewhere */
+    sigset_t block, prev;
+    sigemptyset(&block);
+    sigaddset(&block, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &block, &prev);
+
+    pthread_attr_t attr;
+    pthread_t      thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int rc = pthread_create(&thread, &attr, dump_thread, NULL);
+    pthread_attr_destroy(&attr);
+    pthread_sigmask(SIG_SETMASK, &prev, NULL);
+
+    if (rc != 0) {
+        close(g_dump_pipe[0]);
+        close(g_dump_pipe[1]);
+        return -1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_sigusr1;
+    sa.sa_flags   = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR1, &sa, NULL);
+
+    SHIM_INFO("stats", "kill -USR1 %d dumps stats to %s",
+              (int)getpid(), path);
+    return 0;
+}
@@ -0,0 +1,334 @@
+/*
+ * neuron-shim: Call trace recording
+ *
+ * The wrapper backend forwards every call to the real one and appends a
+ * fixed-size record (plus optional payload) to a buffered FILE under a
+ * mutex. Tracing is a diagnostic mode, so a short critical section on
+ * the inference path is acceptable; the buffer is flushed when a
+ * context is destroyed and at exit.
+ *
+ * With per-model routing several backends can be active; each gets its
+ * own wrapper vtable, and contexts/models remember which backend they
+ * forward to. Only create() and model_load() have nothing to look at,
+ * so those get one thunk per wrapper slot.
+ */
+
+#include "trace.h"
+#include "log.h"
+#include "stats.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TAG "trace"
+#define MAX_WRAPS 4
+
+typedef struct {
+    const NeuronShimBackend* backend;
+    void*    inner;
+    uint32_t id;
+    uint32_t inputs_seen;    /* set_input calls, for sampling */
+} TraceCtx;
+
+typedef struct {
+    const NeuronShimBackend* backend;
+    void* inner;
+    char  path[1024];
+} TraceModel;
+
+static const NeuronShimBackend* g_inner[MAX_WRAPS];
+static NeuronShimBackend        g_wrap[MAX_WRAPS];
+static int                      g_wrap_count;
+static FILE*                    g_file;
+static uint64_t                 g_start_ns;
+static int                      g_sample_every;
+static _Atomic uint32_t         g_next_id = 1;
+static pthread_mutex_t          g_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* ------------------------------------------------------------------ */
+/* Writer                                                              */
+/* ------------------------------------------------------------------ */
+static void emit(uint8_t type, uint32_t runtime, int index, uint64_t t_ns,
+                 uint64_t value, int status, const void* payload, size_t len) {
+    NeuronShimTraceRecord r = {
+        .type    = type,
+        .index   = (uint16_t)(index < 0 ? 0 : index),
+        .runtime = runtime,
+        .t_ns    = t_ns - g_start_ns,
+        .value   = value,
+        .payload = (uint32_t)len,
+        .status  = status,
+    };
+
+    pthread_mutex_lock(&g_lock);
+    fwrite(&r, sizeof(r), 1, g_file);
+    if (len) fwrite(payload, 1, len, g_file);
+    pthread_mutex_unlock(&g_lock);
+}
+
+static void emit_now(uint8_t type, uint32_t runtime, int index,
+                     uint64_t value, int status) {
+    emit(type, runtime, index, neuron_shim_now_ns(), value, status, NULL, 0);
+}
+
+static void trace_flush(void) {
+    pthread_mutex_lock(&g_lock);
+    fflush(g_file);
+    pthread_mutex_unlock(&g_lock);
+}
+
+/* ------------------------------------------------------------------ */
+/* Wrapped calls                                                       */
+/* ------------------------------------------------------------------ */
+static int trace_create(int slot, void** ctx) {
+    TraceCtx* t = calloc(1, sizeof(*t));
+    if (!t) return -1;
+
+    t->backend = g_inner[slot];
+    int rc = t->backend->create(&t->inner);
+    if (rc != 0) {
+        free(t);
+        return rc;
+    }
+    t->id = atomic_fetch_add(&g_next_id, 1);
+    emit_now(TRACE_CREATE, t->id, 0, 0, 0);
+    *ctx = t;
+    return 0;
+}
+
+static void trace_destroy(void* ctx) {
+    TraceCtx* t = ctx;
+    t->backend->destroy(t->inner);
+    emit_now(TRACE_DESTROY, t->id, 0, 0, 0);
+    trace_flush();
+    free(t);
+}
+
+static int trace_load_from_file(void* ctx, const char* path) {
+    TraceCtx* t = ctx;
+    uint64_t t0 = neuron_shim_now_ns();
+    int rc = t->backend->load_from_file(t->inner, path);
+    emit(TRACE_LOAD_FILE, t->id, 0, t0, neuron_shim_now_ns() - t0, rc,
+         path, strlen(path));
+    return rc;
+}
+
+static int trace_load_from_buffer(void* ctx, const void* buf, size_t size) {
+    TraceCtx* t = ctx;
+    int rc = t->backend->load_from_buffer(t->inner, buf, size);
+    emit_now(TRACE_LOAD_BUFFER, t->id, 0, size, rc);
+    return rc;
+}
+
+/* Models are wrapped too, so attach() can record which file a context
+ * ended up on — the cache hands out model pointers, not paths. */
+static int trace_model_load(int slot, const char* path, void** model) {
+    TraceModel* m = calloc(1, sizeof(*m));
+    if (!m) return -1;
+
+    m->backend = g_inner[slot];
+    int rc = m->backend->model_load(path, &m->inner);
+    if (rc != 0) {
+        free(m);
+        return rc;
+    }
+    snprintf(m->path, sizeof(m->path), "%s", path);
+    *model = m;
+    return 0;
+}
+
+static void trace_model_release(void* model) {
+    TraceModel* m = model;
+    m->backend->model_release(m->inner);
+    free(m);
+}
+
+static int trace_attach(void* ctx, void* model) {
+    TraceCtx*   t = ctx;
+    TraceModel* m = model;
+    int rc = t->backend->attach(t->inner, m->inner);
+    emit(TRACE_ATTACH, t->id, 0, neuron_shim_now_ns(), 0, rc,
+         m->path, strlen(m->path));
+    return rc;
+}
+
+static int trace_get_input_count(void* ctx, uint32_t* count) {
+    TraceCtx* t = ctx;
+    return t->backend->get_input_count(t->inner, count);
+}
+
+static int trace_get_output_count(void* ctx, uint32_t* count) {
+    TraceCtx* t = ctx;
+    return t->backend->get_output_count(t->inner, count);
+}
+
+static int trace_get_input_size(void* ctx, int index, size_t* size) {
+    TraceCtx* t = ctx;
+    return t->backend->get_input_size(t->inner, index, size);
+}
+
+static int trace_get_output_size(void* ctx, int index, size_t* size) {
+    TraceCtx* t = ctx;
+    return t->backend->get_output_size(t->inner, index, size);
+}
+
+static int trace_get_input_info(void* ctx, int index, ShimTensorDesc* desc) {
+    TraceCtx* t = ctx;
+    return t->backend->get_input_info(t->inner, index, desc);
+}
+
+static int trace_get_output_info(void* ctx, int index, ShimTensorDesc* desc) {
+    TraceCtx* t = ctx;
+    return t->backend->get_output_info(t->inner, index, desc);
+}
+
+static int trace_set_input(void* ctx, int index, const void* buf, size_t size) {
+    TraceCtx* t = ctx;
+    uint64_t t0 = neuron_shim_now_ns();
+    int rc = t->backend->set_input(t->inner, index, buf, size);
+
+    bool sample = g_sample_every > 0 &&
+                  t->inputs_seen++ % (uint32_t)g_sample_every == 0 &&
+                  size <= UINT32_MAX;
+    emit(TRACE_SET_INPUT, t->id, index, t0, size, rc,
+         buf, sample ? size : 0);
+    return rc;
+}
+
+static int trace_set_output(void* ctx, int index, void* buf, size_t size) {
+    TraceCtx* t = ctx;
+    int rc = t->backend->set_output(t->inner, index, buf, size);
+    emit_now(TRACE_SET_OUTPUT, t->id, index, size, rc);
+    return rc;
+}
+
+static int trace_invoke(void* ctx) {
+    TraceCtx* t = ctx;
+    uint64_t t0 = neuron_shim_now_ns();
+    int rc = t->backend->invoke(t->inner);
+    emit(TRACE_INVOKE, t->id, 0, t0, neuron_shim_now_ns() - t0, rc, NULL, 0);
+    return rc;
+}
+
+static void trace_abort(void* ctx) {
+    TraceCtx* t = ctx;
+    t->backend->abort(t->inner);
+    emit_now(TRACE_ABORT, t->id, 0, 0, 0);
+}
+
+/* Not calls the app made: passed through unrecorded */
+static int trace_memory_usage(void* ctx, NeuronShimMemoryStats* out) {
+    TraceCtx* t = ctx;
+    return t->backend->memory_usage(t->inner, out);
+}
+
+static int trace_providers(void* ctx, char* out, size_t len) {
+    TraceCtx* t = ctx;
+    return t->backend->providers(t->inner, out, len);
+}
+
+#define TRACE_SLOT(n) \
+    static int trace_create_##n(void** ctx) { return trace_create(n, ctx); } \
+    static int trace_model_load_##n(const char* path, void** model) { \
+        return trace_model_load(n, path, model); \
+    }
+TRACE_SLOT(0)
+TRACE_SLOT(1)
+TRACE_SLOT(2)
+TRACE_SLOT(3)
+
+static int (*const g_create_slot[MAX_WRAPS])(void**) = {
+    trace_create_0, trace_create_1, trace_create_2, trace_create_3,
+};
+static int (*const g_model_load_slot[MAX_WRAPS])(const char*, void**) = {
+    trace_model_load_0, trace_model_load_1, trace_model_load_2, trace_model_load_3,
+};
+
+/* ------------------------------------------------------------------ */
+/* Setup                                                               */
+/* ------------------------------------------------------------------ */
+static int trace_open(const NeuronShimBackend* inner, const NeuronShimConfig* cfg,
+                      const char* suffix) {
+    g_file = fopen(cfg->trace_file, "wb");
+    if (!g_file) {
+        SHIM_WARN(TAG, "can't open %s, tracing disabled", cfg->trace_file);
+        return -1;
+    }
+    setvbuf(g_file, NULL, _IOFBF, 1 << 16);
+
+    struct timespec wall;
+    clock_gettime(CLOCK_REALTIME, &wall);
+    g_start_ns = neuron_shim_now_ns();
+
+    NeuronShimTraceHeader h = {
+        .version       = NEURON_SHIM_TRACE_VERSION,
+        .record_size   = sizeof(NeuronShimTraceRecord),
+        .start_unix_ns = (uint64_t)wall.tv_sec * 1000000000ull +
+                         (uint64_t)wall.tv_nsec,
+    };
+    memcpy(h.magic, NEURON_SHIM_TRACE_MAGIC, sizeof(h.magic));
+    snprintf(h.backend, sizeof(h.backend), "%s", inner->name);
+    snprintf(h.suffix, sizeof(h.suffix), "%s", suffix);
+    fwrite(&h, sizeof(h), 1, g_file);
+
+    g_sample_every = cfg->trace_sample_inputs;
+    atexit(trace_flush);
+    SHIM_INFO(TAG, "recording calls to %s (input samples: %s)",
+              cfg->trace_file, g_sample_every > 0 ? "on" : "off");
+    return 0;
+}
+
+const NeuronShimBackend* neuron_shim_trace_wrap(const NeuronShimBackend* inner,
+                                                const NeuronShimConfig* cfg,
+                                                const char* suffix) {
+    static pthread_mutex_t setup = PTHREAD_MUTEX_INITIALIZER;
+    const NeuronShimBackend* out = inner;
+
+    pthread_mutex_lock(&setup);
+    int slot = 0;
+    while (slot < g_wrap_count && g_inner[slot] != inner) slot++;
+
+    if (slot < g_wrap_count) {
+        out = &g_wrap[slot];
+    } else if (slot == MAX_WRAPS) {
+        SHIM_WARN(TAG, "more than %d backends, not tracing %s",
+                  MAX_WRAPS, inner->name);
+    } else if (g_file || trace_open(inner, cfg, suffix) == 0) {
+        g_inner[slot] = inner;
+
+        /* Keep optional entry points optional */
+        g_wrap[slot] = (NeuronShimBackend){
+            .name             = inner->name,
+            .init             = inner->init,
+            .create           = g_create_slot[slot],
+            .destroy          = trace_destroy,
+            .load_from_file   = trace_load_from_file,
+            .load_from_buffer = trace_load_from_buffer,
+            .model_load       = inner->model_load    ? g_model_load_slot[slot] : NULL,
+            .model_release    = inner->model_release ? trace_model_release : NULL,
+            .attach           = inner->attach        ? trace_attach        : NULL,
+            .get_input_count  = trace_get_input_count,
+            .get_output_count = trace_get_output_count,
+            .get_input_size   = trace_get_input_size,
+            .get_output_size  = trace_get_output_size,
+            .get_input_info   = inner->get_input_info  ? trace_get_input_info  : NULL,
+            .get_output_info  = inner->get_output_info ? trace_get_output_info : NULL,
+            .set_input        = trace_set_input,
+            .set_output       = trace_set_output,
+            .invoke           = trace_invoke,
+            .abort            = inner->abort ? trace_abort : NULL,
+            .memory_usage     = inner->memory_usage ? trace_memory_usage : NULL,
+            .providers        = inner->providers ? trace_providers : NULL,
+        };
+        g_wrap_count = slot + 1;
+        out = &g_wrap[slot];
+        SHIM_INFO(TAG, "tracing backend %s", inner->name);
+    }
+    pthread_mutex_unlock(&setup);
+    return out;
+}
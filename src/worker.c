@@ -0,0 +1,112 @@
+/*
+ * neuron-shim: Per-runtime inference worker
+ */
+
+#include "worker.h"
+#include "log.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+typedef enum {
+    WORKER_IDLE,
+    WORKER_QUEUED,
+    WORKER_DONE,      /* result not collected yet */
+} WorkerState;
+
+struct ShimWorker {
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    WorkerState     state;
+    bool            quit;
+    int             result;
+    int           (*job)(void* arg);
+    void*           arg;
+};
+
+static void* worker_main(void* arg) {
+    ShimWorker* w = (ShimWorker*)arg;
+
+    pthread_mutex_lock(&w->lock);
+    for (;;) {
+        while (w->state != WORKER_QUEUED && !w->quit)
+            pthread_cond_wait(&w->cond, &w->lock);
+        if (w->state != WORKER_QUEUED) break;   /* quit, nothing queued */
+
+        pthread_mutex_unlock(&w->lock);
+        int result = w->job(w->arg);
+        pthread_mutex_lock(&w->lock);
+
+        w->result = result;
+        w->state  = WORKER_DONE;
+        pthread_cond_broadcast(&w->cond);
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+ShimWorker* neuron_shim_worker_create(int (*job)(void* arg), void* arg) {
+    ShimWorker* w = (ShimWorker*)calloc(1, sizeof(ShimWorker));
+    if (!w) return NULL;
+
+    w->job = job;
+    w->arg = arg;
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->cond, NULL);
+    if (pthread_create(&w->thread, NULL, worker_main, w) != 0) {
+        SHIM_ERR(NULL, "ERROR: can't start inference worker");
+        pthread_cond_destroy(&w->cond);
+        pthread_mutex_destroy(&w->lock);
+        free(w);
+        return NULL;
+    }
+    return w;
+}
+
+void neuron_shim_worker_destroy(ShimWorker* w) {
+    if (!w) return;
+
+    pthread_mutex_lock(&w->lock);
+    w->quit = true;
+    pthread_cond_broadcast(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+    pthread_join(w->thread, NULL);   /* runs a queued job to completion */
+
+    pthread_cond_destroy(&w->cond);
+    pthread_mutex_destroy(&w->lock);
+    free(w);
+}
+
+int neuron_shim_worker_submit(ShimWorker* w) {
+    pthread_mutex_lock(&w->lock);
+    if (w->state != WORKER_IDLE) {
+        pthread_mutex_unlock(&w->lock);
+        return -1;
+    }
+    w->state = WORKER_QUEUED;
+    pthread_cond_broadcast(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+    return 0;
+}
+
+bool neuron_shim_worker_pending(ShimWorker* w) {
+    pthread_mutex_lock(&w->lock);
+    bool pending = w->state != WORKER_IDLE;
+    pthread_mutex_unlock(&w->lock);
+    return pending;
+}
+
+int neuron_shim_worker_wait(ShimWorker* w, int* result) {
+    pthread_mutex_lock(&w->lock);
+    if (w->state == WORKER_IDLE) {
+        pthread_mutex_unlock(&w->lock);
+        return -1;
+    }
+    while (w->state != WORKER_DONE)
+        pthread_cond_wait(&w->cond, &w->lock);
+    *result  = w->result;
+    w->state = WORKER_IDLE;
+    pthread_mutex_unlock(&w->lock);
+    return 0;
+}
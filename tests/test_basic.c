@@ -3,13 +3,75 @@
  *
  * Run with:
  *   NEURON_SHIM_BACKEND=stub ./shim_test
+ *
+ * With the onnx backend, a model whose [model] section sets
+ * batch_window_us makes the batch check below go through one batched
+ * Run(); each runtime must still get exactly its own outputs.
  */
 
 #include "RuntimeAPI.h"
+#include "cpu_affinity.h"
+#include "host_mem.h"
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
+/* One runtime of the batch check, with a fill pattern of its own */
+typedef struct {
+    NeuronRuntime rt;
+    uint32_t      in_count, out_count;
+    uint8_t*      in[8];
+    size_t        in_size[8];
+    uint8_t*      out[8];
+    uint8_t*      expect[8];
+    size_t        out_size[8];
+    int           ret;
+} BatchMember;
+
+static int batch_member_init(BatchMember* b, const char* model_path, uint8_t fill) {
+    memset(b, 0, sizeof(*b));
+    if (NeuronRuntime_create(&(RuntimeConfig){0}, &b->rt) != 0 ||
+        NeuronRuntime_loadNetworkFromFile(b->rt, model_path) != 0)
+        return -1;
+    NeuronRuntime_getInputCount(b->rt, &b->in_count);
+    NeuronRuntime_getOutputCount(b->rt, &b->out_count);
+    if (b->in_count > 8 || b->out_count > 8) return -1;
+
+    for (uint32_t i = 0; i < b->in_count; i++) {
+        NeuronRuntime_getInputSize(b->rt, (int)i, &b->in_size[i]);
+        b->in[i] = (uint8_t*)malloc(b->in_size[i]);
+        if (!b->in[i]) return -1;
+        memset(b->in[i], fill, b->in_size[i]);
+        if (NeuronRuntime_setInput(b->rt, (int)i, b->in[i], b->in_size[i], -1) != 0)
+            return -1;
+    }
+    for (uint32_t i = 0; i < b->out_count; i++) {
+        NeuronRuntime_getOutputSize(b->rt, (int)i, &b->out_size[i]);
+        b->out[i]    = (uint8_t*)calloc(1, b->out_size[i]);
+        b->expect[i] = (uint8_t*)calloc(1, b->out_size[i]);
+        if (!b->out[i] || !b->expect[i]) return -1;
+        if (NeuronRuntime_setOutput(b->rt, (int)i, b->out[i], b->out_size[i], -1) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+static void batch_member_free(BatchMember* b) {
+    if (b->rt) NeuronRuntime_release(b->rt);
+    for (int i = 0; i < 8; i++) {
+        free(b->in[i]);
+        free(b->out[i]);
+        free(b->expect[i]);
+    }
+}
+
+static void* batch_member_run(void* arg) {
+    BatchMember* b = (BatchMember*)arg;
+    b->ret = NeuronRuntime_inference(b->rt);
+    return NULL;
+}
+
 int main(int argc, char** argv) {
     const char* model_path = argc > 1 ? argv[1] : "/tmp/test_model.dla";
     int ret;
@@ -35,6 +97,15 @@ int main(int argc, char** argv) {
     NeuronRuntime_getOutputCount(runtime, &out_count);
     printf("tensors: %u inputs, %u outputs\n", in_count, out_count);
 
+    /* Tensor info must agree with the plain size query */
+    NeuronTensorInfo info;
+    size_t in0_size = 0;
+    ret = NeuronRuntime_getInputInfo(runtime, 0, &info);
+    NeuronRuntime_getInputSize(runtime, 0, &in0_size);
+    printf("info:    %s (input[0] %zu bytes, %u dims)\n",
+           ret == 0 && info.sizeBytes == in0_size ? "OK" : "FAIL",
+           info.sizeBytes, info.dimensionCount);
+
     /* Set up dummy I/O */
     size_t in_size = 224 * 224 * 3;   /* typical image input */
     size_t out_size = 1001;            /* typical classification output */
@@ -47,7 +118,7 @@ int main(int argc, char** argv) {
     ret = NeuronRuntime_setOutput(runtime, 0, output_buf, out_size * sizeof(float), -1);
     printf("setOutput: %s\n", ret == 0 ? "OK" : "FAIL");
 
-    /* QoS (should be no-op) */
+    /* QoS: priority only gates against other runtimes */
     QoSOptions qos = {
         .priority = NEURONRUNTIME_PRIORITY_HIGH,
         .boostValue = 100,
@@ -66,6 +137,85 @@ int main(int argc, char** argv) {
     }
     printf("output:  %s\n", all_zero ? "all zeros (stub)" : "has values (real backend)");
 
+    /* Profiled latency for the one inference above */
+    ret = NeuronRuntime_getProfiledQoSData(runtime, &qos);
+    const NeuronShimProfiledQoSData* prof =
+        (const NeuronShimProfiledQoSData*)qos.profiledQoSData;
+    int prof_ok = ret == 0 && prof &&
+                  qos.profiledQoSDataSize == sizeof(*prof) &&
+                  prof->version == NEURON_SHIM_QOS_DATA_VERSION &&
+                  prof->inference.count == 1 &&
+                  (!all_zero || prof->memory.host_peak == 0);  /* stub: no arenas */
+    printf("profile: %s (inference p50=%.1fus)\n", prof_ok ? "OK" : "FAIL",
+           prof ? prof->inference.p50_ns / 1e3 : 0.0);
+
+    /* Async inference: the buffers are the shim's until wait */
+    output_buf[0] = 1.0f;
+    int async_ok = NeuronRuntime_inferenceAsync(runtime) == 0 &&
+                   NeuronRuntime_inferenceAsync(runtime) == NEURONRUNTIME_BAD_STATE &&
+                   NeuronRuntime_setInput(runtime, 0, input_buf, in_size, -1) ==
+                       NEURONRUNTIME_BAD_STATE &&
+                   NeuronRuntime_wait(runtime) == 0 &&
+                   NeuronRuntime_wait(runtime) == NEURONRUNTIME_BAD_STATE;
+    async_ok = async_ok && (!all_zero || output_buf[0] == 0.0f);
+    printf("async:   %s\n", async_ok ? "OK" : "FAIL");
+
+    /* APU buffer allocator: reuse, interior lookups, double free */
+    char* a = neuron_shim_mem_alloc(5000);
+    int mem_ok = a && a[4999] == 0 &&
+                 neuron_shim_mem_kind(a + 100, 4000) >= 0 &&
+                 neuron_shim_mem_kind(a, 1 << 20) < 0 &&
+                 neuron_shim_mem_kind(&ret, sizeof(ret)) < 0 &&
+                 neuron_shim_mem_free(a) == 0 &&
+                 neuron_shim_mem_free(a) != 0;
+    char* b = neuron_shim_mem_alloc(6000);   /* same 8 KB class */
+    mem_ok = mem_ok && b == a && neuron_shim_mem_free(b) == 0;
+    printf("hostmem: %s\n", mem_ok ? "OK" : "FAIL");
+
+    /* CPU sets: every spec is clipped to the CPUs we may run on */
+    static NeuronShimCpuSet all, big, one;
+    int cpu_ok = neuron_shim_cpuset_parse("0-1023", &all) == 0 && all.count > 0 &&
+                 neuron_shim_cpuset_parse("big", &big) == 0 &&
+                 big.count > 0 && big.count <= all.count &&
+                 neuron_shim_cpuset_parse("", &one) == 0 && one.count == 0 &&
+                 neuron_shim_cpuset_parse("3-1", &one) != 0 &&
+                 neuron_shim_cpuset_parse("fast", &one) != 0;
+    char spec[16];
+    snprintf(spec, sizeof(spec), "%d", all.cpus[all.count - 1]);
+    cpu_ok = cpu_ok && neuron_shim_cpuset_parse(spec, &one) == 0 &&
+             one.count == 1 && one.cpus[0] == all.cpus[all.count - 1];
+    printf("cpuset: %s (%d CPUs, %d big)\n", cpu_ok ? "OK" : "FAIL",
+           all.count, big.count);
+
+    /* Two runtimes on one model, run alone for reference, then together
+     * (batched when the model has a batch window) */
+    static BatchMember mb[2];
+    int batch_ok = batch_member_init(&mb[0], model_path, 1) == 0 &&
+                   batch_member_init(&mb[1], model_path, 2) == 0;
+    for (int k = 0; batch_ok && k < 2; k++) {
+        batch_ok = NeuronRuntime_inference(mb[k].rt) == 0;
+        for (uint32_t i = 0; batch_ok && i < mb[k].out_count; i++) {
+            memcpy(mb[k].expect[i], mb[k].out[i], mb[k].out_size[i]);
+            memset(mb[k].out[i], 0xAB, mb[k].out_size[i]);
+        }
+    }
+    if (batch_ok) {
+        pthread_t th[2];
+        for (int k = 0; k < 2; k++)
+            pthread_create(&th[k], NULL, batch_member_run, &mb[k]);
+        for (int k = 0; k < 2; k++)
+            pthread_join(th[k], NULL);
+        for (int k = 0; k < 2; k++) {
+            batch_ok = batch_ok && mb[k].ret == 0;
+            for (uint32_t i = 0; batch_ok && i < mb[k].out_count; i++)
+                batch_ok = memcmp(mb[k].out[i], mb[k].expect[i], mb[k].out_size[i]) == 0;
+        }
+    }
+    batch_member_free(&mb[0]);
+    batch_member_free(&mb[1]);
+    printf("batch:   %s\n", batch_ok ? "OK" : "FAIL");
+    if (!batch_ok) return 1;
+
     /* Cleanup */
     NeuronRuntime_release(runtime);
     printf("\nrelease: OK\n");
@@ -0,0 +1,254 @@
+/*
+ * shim_bench — latency / throughput benchmark through the public API
+ *
+ * Loads a model via NeuronRuntime_loadNetworkFromFile exactly like an
+ * app would (same config, model resolution, backend selection), then
+ * runs warm-up plus timed inferences on T threads, each with its own
+ * runtime.
+ *
+ * Usage:
+ *   NEURON_SHIM_BACKEND=onnx ./shim_bench [-t threads] [-w warmup]
+ *                                         [-n iterations] model.dla
+ *
+ * The last line of output is a single key=value RESULT line, meant for
+ * scripts comparing backends / EPs / SKUs.
+ */
+
+#include "RuntimeAPI.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#define MAX_THREADS 64
+#define MAX_IO      32
+
+typedef struct {
+    int         id;
+    const char* model;
+    int         warmup;
+    int         iterations;
+
+    /* Results */
+    int       ok;
+    uint64_t  load_ns;
+    uint64_t  first_ns;
+    uint64_t* samples;     /* iterations entries */
+    uint64_t  start_ns;    /* timed window, for throughput */
+    uint64_t  end_ns;
+    char      backend[16];
+    char      eps[64];      /* providers that registered, from the QoS data */
+} BenchThread;
+
+static pthread_barrier_t g_start;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void* bench_thread(void* arg) {
+    BenchThread* b = (BenchThread*)arg;
+    NeuronRuntime rt = NULL;
+    RuntimeConfig config = {0};
+    void*    in_bufs[MAX_IO]  = { 0 };
+    void*    out_bufs[MAX_IO] = { 0 };
+    uint32_t in_count = 0, out_count = 0;
+    uint64_t t0;
+
+    if (NeuronRuntime_create(&config, &rt) != NEURONRUNTIME_NO_ERROR) {
+        fprintf(stderr, "thread %d: create failed\n", b->id);
+        goto wait;
+    }
+
+    t0 = now_ns();
+    if (NeuronRuntime_loadNetworkFromFile(rt, b->model) != NEURONRUNTIME_NO_ERROR) {
+        fprintf(stderr, "thread %d: load failed\n", b->id);
+        goto wait;
+    }
+    b->load_ns = now_ns() - t0;
+
+    /* Random (not zero) inputs so sparse-aware kernels don't flatter us */
+    NeuronRuntime_getInputCount(rt, &in_count);
+    NeuronRuntime_getOutputCount(rt, &out_count);
+    if (in_count > MAX_IO) in_count = MAX_IO;
+    if (out_count > MAX_IO) out_count = MAX_IO;
+
+    unsigned seed = (unsigned)b->id * 2654435761u;
+    for (uint32_t i = 0; i < in_count; i++) {
+        size_t size = 0;
+        NeuronRuntime_getInputSize(rt, (int)i, &size);
+        in_bufs[i] = malloc(size ? size : 1);
+        for (size_t j = 0; j < size; j++)
+            ((uint8_t*)in_bufs[i])[j] = (uint8_t)rand_r(&seed);
+        NeuronRuntime_setInput(rt, (int)i, in_bufs[i], size, -1);
+    }
+    for (uint32_t i = 0; i < out_count; i++) {
+        size_t size = 0;
+        NeuronRuntime_getOutputSize(rt, (int)i, &size);
+        out_bufs[i] = malloc(size ? size : 1);
+        NeuronRuntime_setOutput(rt, (int)i, out_bufs[i], size, -1);
+    }
+
+    t0 = now_ns();
+    if (NeuronRuntime_inference(rt) != NEURONRUNTIME_NO_ERROR) {
+        fprintf(stderr, "thread %d: inference failed\n", b->id);
+        goto wait;
+    }
+    b->first_ns = now_ns() - t0;
+
+    for (int i = 0; i < b->warmup; i++)
+        NeuronRuntime_inference(rt);
+
+    QoSOptions qos = {0};
+    if (NeuronRuntime_getProfiledQoSData(rt, &qos) == NEURONRUNTIME_NO_ERROR &&
+        qos.profiledQoSData) {
+        const NeuronShimProfiledQoSData* prof = qos.profiledQoSData;
+        snprintf(b->backend, sizeof(b->backend), "%s", prof->backend);
+        if (prof->version >= 3)
+            snprintf(b->eps, sizeof(b->eps), "%s", prof->eps);
+    }
+    b->ok = 1;
+
+wait:
+    /* Every thread must reach the barrier, even after a failure */
+    pthread_barrier_wait(&g_start);
+
+    b->start_ns = now_ns();
+    for (int i = 0; b->ok && i < b->iterations; i++) {
+        t0 = now_ns();
+        if (NeuronRuntime_inference(rt) != NEURONRUNTIME_NO_ERROR) {
+            fprintf(stderr, "thread %d: inference %d failed\n", b->id, i);
+            b->ok = 0;
+            break;
+        }
+        b->samples[i] = now_ns() - t0;
+    }
+    b->end_ns = now_ns();
+
+    if (rt) NeuronRuntime_release(rt);
+    for (uint32_t i = 0; i < MAX_IO; i++) {
+        free(in_bufs[i]);
+        free(out_bufs[i]);
+    }
+    return NULL;
+}
+
+static int cmp_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static double ms(uint64_t ns) { return ns / 1e6; }
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [-t threads] [-w warmup] [-n iterations] model.dla\n"
+            "  -t  threads, one runtime each (default 1, max %d)\n"
+            "  -w  warm-up inferences per thread, untimed (default 10)\n"
+            "  -n  timed inferences per thread (default 100)\n",
+            argv0, MAX_THREADS);
+}
+
+int main(int argc, char** argv) {
+    int threads = 1, warmup = 10, iterations = 100, opt;
+
+    while ((opt = getopt(argc, argv, "t:w:n:h")) != -1) {
+        switch (opt) {
+        case 't': threads    = atoi(optarg); break;
+        case 'w': warmup     = atoi(optarg); break;
+        case 'n': iterations = atoi(optarg); break;
+        default:  usage(argv[0]); return 2;
+        }
+    }
+    if (optind != argc - 1 || threads < 1 || threads > MAX_THREADS ||
+        warmup < 0 || iterations < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+    const char* model = argv[optind];
+
+    BenchThread bt[MAX_THREADS];
+    pthread_t   tid[MAX_THREADS];
+    pthread_barrier_init(&g_start, NULL, (unsigned)threads + 1);
+
+    for (int i = 0; i < threads; i++) {
+        memset(&bt[i], 0, sizeof(bt[i]));
+        bt[i].id         = i;
+        bt[i].model      = model;
+        bt[i].warmup     = warmup;
+        bt[i].iterations = iterations;
+        bt[i].samples    = calloc((size_t)iterations, sizeof(uint64_t));
+        pthread_create(&tid[i], NULL, bench_thread, &bt[i]);
+    }
+
+    /* Loads and warm-up all finish before any timed run starts */
+    pthread_barrier_wait(&g_start);
+
+    for (int i = 0; i < threads; i++)
+        pthread_join(tid[i], NULL);
+    pthread_barrier_destroy(&g_start);
+
+    /* Merge samples from threads that completed */
+    size_t    total = 0;
+    uint64_t* all = calloc((size_t)threads * (size_t)iterations, sizeof(uint64_t));
+    uint64_t  load_max = 0, first_max = 0;
+    uint64_t  start = UINT64_MAX, end = 0;
+    const char* backend = "?";
+    const char* eps = "-";
+    int ok_threads = 0;
+    for (int i = 0; i < threads; i++) {
+        if (!bt[i].ok) continue;
+        ok_threads++;
+        memcpy(all + total, bt[i].samples, (size_t)iterations * sizeof(uint64_t));
+        total += (size_t)iterations;
+        if (bt[i].load_ns  > load_max)  load_max  = bt[i].load_ns;
+        if (bt[i].first_ns > first_max) first_max = bt[i].first_ns;
+        if (bt[i].backend[0]) backend = bt[i].backend;
+        if (bt[i].eps[0])     eps     = bt[i].eps;
+        if (bt[i].start_ns < start) start = bt[i].start_ns;
+        if (bt[i].end_ns   > end)   end   = bt[i].end_ns;
+    }
+    if (total == 0) {
+        fprintf(stderr, "no thread completed\n");
+        return 1;
+    }
+    qsort(all, total, sizeof(uint64_t), cmp_u64);
+
+    uint64_t sum = 0;
+    for (size_t i = 0; i < total; i++) sum += all[i];
+    uint64_t p50 = all[(total - 1) * 50 / 100];
+    uint64_t p99 = all[(total - 1) * 99 / 100];
+    double   fps = total / ((end - start) / 1e9);
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    long rss_kb = ru.ru_maxrss;   /* KiB on Linux */
+
+    printf("\n=== shim_bench: %s ===\n", model);
+    printf("backend:        %s (eps %s)\n", backend, eps);
+    printf("threads:        %d (%d ok), warm-up %d, iterations %d each\n",
+           threads, ok_threads, warmup, iterations);
+    printf("load:           %.2f ms (slowest thread)\n", ms(load_max));
+    printf("first infer:    %.2f ms (slowest thread)\n", ms(first_max));
+    printf("latency:        mean %.3f  p50 %.3f  p99 %.3f  max %.3f ms\n",
+           ms(sum / total), ms(p50), ms(p99), ms(all[total - 1]));
+    printf("throughput:     %.1f inferences/s\n", fps);
+    printf("peak RSS:       %.1f MiB\n", rss_kb / 1024.0);
+
+    printf("RESULT backend=%s ep=%s threads=%d iterations=%zu load_ms=%.3f "
+           "first_ms=%.3f p50_ms=%.3f p99_ms=%.3f max_ms=%.3f fps=%.1f "
+           "rss_kb=%ld\n",
+           backend, eps, ok_threads, total, ms(load_max), ms(first_max),
+           ms(p50), ms(p99), ms(all[total - 1]), fps, rss_kb);
+
+    for (int i = 0; i < threads; i++) free(bt[i].samples);
+    free(all);
+    return ok_threads == threads ? 0 : 1;
+}
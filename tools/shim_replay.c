@@ -0,0 +1,325 @@
+/*
+ * shim_replay — play back a trace recorded with trace_file
+ *
+ * Every runtime in the trace gets its own thread and NeuronRuntime,
+ * and repeats its recorded call sequence through the public API:
+ * create, load (same .dla path), setInput/setOutput with the recorded
+ * sizes, inference, release. By default each call waits until its
+ * original offset from the start of the trace, so runtime count, frame
+ * cadence and burstiness match the field; -f replays as fast as
+ * possible instead, -s scales the timeline.
+ *
+ * Inputs are the sampled bytes when the trace has them (the most recent
+ * sample for that tensor is reused), zeros otherwise.
+ *
+ * Usage:
+ *   NEURON_SHIM_BACKEND=onnx ./shim_replay [-f] [-s speed] trace.bin
+ *
+ * Recorded paths are resolved model files; the recording's suffix is
+ * stripped to get back the .dla path, which is then resolved again with
+ * this machine's config (NEURON_SHIM_MODEL_DIR can point it elsewhere).
+ */
+
+#include "RuntimeAPI.h"
+#include "trace.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_RUNTIMES 256
+#define MAX_IO       32
+
+typedef struct {
+    NeuronShimTraceRecord rec;
+    void*                 payload;
+} Event;
+
+typedef struct {
+    uint32_t id;
+    Event*   events;
+    size_t   count, cap;
+
+    /* Results */
+    int      ok;
+    size_t   inferences;
+    uint64_t recorded_ns;     /* sum of recorded invoke durations */
+    uint64_t replayed_ns;     /* sum of replayed inference calls */
+    uint64_t late_ns;         /* worst lag behind the recorded timeline */
+} Runtime;
+
+static Runtime  g_rt[MAX_RUNTIMES];
+static int      g_rt_count;
+static char     g_suffix[sizeof(((NeuronShimTraceHeader*)0)->suffix)];
+static int      g_fast;
+static double   g_speed = 1.0;
+static uint64_t g_start_ns;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static Runtime* runtime_for(uint32_t id) {
+    for (int i = 0; i < g_rt_count; i++)
+        if (g_rt[i].id == id) return &g_rt[i];
+    if (g_rt_count == MAX_RUNTIMES) return NULL;
+    g_rt[g_rt_count].id = id;
+    return &g_rt[g_rt_count++];
+}
+
+/* ------------------------------------------------------------------ */
+/* Trace parsing                                                       */
+/* ------------------------------------------------------------------ */
+static int read_trace(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    NeuronShimTraceHeader h;
+    if (fread(&h, sizeof(h), 1, f) != 1 ||
+        memcmp(h.magic, NEURON_SHIM_TRACE_MAGIC, sizeof(h.magic)) != 0 ||
+        h.version != NEURON_SHIM_TRACE_VERSION ||
+        h.record_size != sizeof(NeuronShimTraceRecord)) {
+        fprintf(stderr, "%s: not a version %d neuron-shim trace\n",
+                path, NEURON_SHIM_TRACE_VERSION);
+        fclose(f);
+        return -1;
+    }
+    memcpy(g_suffix, h.suffix, sizeof(g_suffix));
+    g_suffix[sizeof(g_suffix) - 1] = '\0';
+    printf("trace: recorded on backend %.16s, suffix %s\n", h.backend, g_suffix);
+
+    NeuronShimTraceRecord r;
+    size_t total = 0;
+    while (fread(&r, sizeof(r), 1, f) == 1) {
+        void* payload = NULL;
+        if (r.payload) {
+            /* +1 keeps path payloads NUL-terminated */
+            payload = calloc(1, (size_t)r.payload + 1);
+            if (!payload || fread(payload, 1, r.payload, f) != r.payload) {
+                free(payload);
+                fprintf(stderr, "%s: truncated after %zu records\n", path, total);
+                break;
+            }
+        }
+
+        Runtime* rt = runtime_for(r.runtime);
+        if (!rt) {
+            fprintf(stderr, "more than %d runtimes, ignoring the rest\n",
+                    MAX_RUNTIMES);
+            free(payload);
+            break;
+        }
+        if (rt->count == rt->cap) {
+            rt->cap = rt->cap ? rt->cap * 2 : 64;
+            rt->events = realloc(rt->events, rt->cap * sizeof(Event));
+        }
+        rt->events[rt->count++] = (Event){ r, payload };
+        total++;
+    }
+    fclose(f);
+
+    printf("trace: %zu calls across %d runtimes\n", total, g_rt_count);
+    return total ? 0 : -1;
+}
+
+/* ------------------------------------------------------------------ */
+/* Replay                                                              */
+/* ------------------------------------------------------------------ */
+static void wait_until(Runtime* rt, uint64_t t_ns) {
+    if (g_fast) return;
+
+    uint64_t due = g_start_ns + (uint64_t)((double)t_ns / g_speed);
+    uint64_t now = now_ns();
+    if (now >= due) {
+        if (now - due > rt->late_ns) rt->late_ns = now - due;
+        return;
+    }
+    struct timespec ts = {
+        .tv_sec  = (time_t)(due / 1000000000ull),
+        .tv_nsec = (long)(due % 1000000000ull),
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+}
+
+/* Turn a recorded resolved path back into the .dla the app passed.
+ * Models routed to another backend were resolved with its suffix. */
+static void dla_path(const char* recorded, char* out, size_t len) {
+    const char* suffixes[] = { g_suffix, ".onnx", ".tflite" };
+    size_t n = strlen(recorded);
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); i++) {
+        size_t s = strlen(suffixes[i]);
+        if (s && n > s && strcmp(recorded + n - s, suffixes[i]) == 0) {
+            n -= s;
+            break;
+        }
+    }
+    snprintf(out, len, "%.*s", (int)n, recorded);
+}
+
+static int ensure_buf(void** bufs, size_t* sizes, int index, size_t size) {
+    if (index < 0 || index >= MAX_IO) return -1;
+    if (sizes[index] < size) {
+        void* p = realloc(bufs[index], size);
+        if (!p) return -1;
+        memset((char*)p + sizes[index], 0, size - sizes[index]);
+        bufs[index]  = p;
+        sizes[index] = size;
+    }
+    return 0;
+}
+
+static void* replay_thread(void* arg) {
+    Runtime*      rt = arg;
+    NeuronRuntime h  = NULL;
+    void*         in_bufs[MAX_IO]  = { 0 };
+    void*         out_bufs[MAX_IO] = { 0 };
+    size_t        in_sizes[MAX_IO] = { 0 }, out_sizes[MAX_IO] = { 0 };
+    char          path[1024];
+
+    rt->ok = 1;
+    for (size_t i = 0; i < rt->count && rt->ok; i++) {
+        const NeuronShimTraceRecord* r = &rt->events[i].rec;
+        const void* payload = rt->events[i].payload;
+        int ret = NEURONRUNTIME_NO_ERROR;
+
+        /* Calls that failed in the field are not expected to work here */
+        if (r->status != 0 && r->type != TRACE_INVOKE) continue;
+
+        wait_until(rt, r->t_ns);
+        switch (r->type) {
+        case TRACE_CREATE: {
+            RuntimeConfig config = {0};
+            ret = NeuronRuntime_create(&config, &h);
+            break;
+        }
+        case TRACE_LOAD_FILE:
+        case TRACE_ATTACH:
+            if (!h || !payload) break;
+            dla_path(payload, path, sizeof(path));
+            ret = NeuronRuntime_loadNetworkFromFile(h, path);
+            break;
+        case TRACE_LOAD_BUFFER:
+            fprintf(stderr, "runtime %u: loaded from a %llu-byte buffer, "
+                    "which traces don't capture; skipping it\n",
+                    rt->id, (unsigned long long)r->value);
+            rt->ok = 0;
+            break;
+        case TRACE_SET_INPUT:
+            if (ensure_buf(in_bufs, in_sizes, r->index, r->value) != 0) break;
+            if (payload) memcpy(in_bufs[r->index], payload, r->payload);
+            ret = NeuronRuntime_setInput(h, r->index, in_bufs[r->index],
+                                         r->value, -1);
+            break;
+        case TRACE_SET_OUTPUT:
+            if (ensure_buf(out_bufs, out_sizes, r->index, r->value) != 0) break;
+            ret = NeuronRuntime_setOutput(h, r->index, out_bufs[r->index],
+                                          r->value, -1);
+            break;
+        case TRACE_INVOKE: {
+            uint64_t t0 = now_ns();
+            ret = NeuronRuntime_inference(h);
+            rt->replayed_ns += now_ns() - t0;
+            rt->recorded_ns += r->value;
+            rt->inferences++;
+            break;
+        }
+        case TRACE_DESTROY:
+            if (h) NeuronRuntime_release(h);
+            h = NULL;
+            break;
+        default:
+            break;      /* ABORT: the replayed watchdog decides on its own */
+        }
+
+        if (ret != NEURONRUNTIME_NO_ERROR && r->type != TRACE_INVOKE) {
+            fprintf(stderr, "runtime %u: call %zu (type %u) failed: %d\n",
+                    rt->id, i, r->type, ret);
+            rt->ok = 0;
+        }
+    }
+
+    if (h) NeuronRuntime_release(h);
+    for (int i = 0; i < MAX_IO; i++) {
+        free(in_bufs[i]);
+        free(out_bufs[i]);
+    }
+    return NULL;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [-f] [-s speed] trace.bin\n"
+            "  -f  replay as fast as possible, ignoring recorded timing\n"
+            "  -s  timeline speed factor (default 1.0 = original cadence)\n",
+            argv0);
+}
+
+int main(int argc, char** argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "fs:h")) != -1) {
+        switch (opt) {
+        case 'f': g_fast  = 1; break;
+        case 's': g_speed = atof(optarg); break;
+        default:  usage(argv[0]); return 2;
+        }
+    }
+    if (optind != argc - 1 || g_speed <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (read_trace(argv[optind]) != 0) return 1;
+
+    pthread_t tid[MAX_RUNTIMES];
+    g_start_ns = now_ns();
+    for (int i = 0; i < g_rt_count; i++)
+        pthread_create(&tid[i], NULL, replay_thread, &g_rt[i]);
+    for (int i = 0; i < g_rt_count; i++)
+        pthread_join(tid[i], NULL);
+    uint64_t wall = now_ns() - g_start_ns;
+
+    printf("\n=== shim_replay: %s (%s) ===\n", argv[optind],
+           g_fast ? "max speed" : "recorded cadence");
+    printf("%-8s %10s %14s %14s %12s\n",
+           "runtime", "inferences", "recorded ms", "replayed ms", "max lag ms");
+
+    int      ok = 0;
+    size_t   total = 0;
+    uint64_t rec_sum = 0, rep_sum = 0;
+    for (int i = 0; i < g_rt_count; i++) {
+        Runtime* rt = &g_rt[i];
+        ok += rt->ok;
+        total   += rt->inferences;
+        rec_sum += rt->recorded_ns;
+        rep_sum += rt->replayed_ns;
+        if (!rt->inferences) continue;  /* e.g. preload warm-up contexts */
+        printf("%-8u %10zu %14.3f %14.3f %12.3f%s\n", rt->id, rt->inferences,
+               rt->recorded_ns / 1e6 / rt->inferences,
+               rt->replayed_ns / 1e6 / rt->inferences,
+               rt->late_ns / 1e6, rt->ok ? "" : "  (failed)");
+    }
+    printf("mean latency: recorded %.3f ms, replayed %.3f ms\n",
+           total ? rec_sum / 1e6 / total : 0.0,
+           total ? rep_sum / 1e6 / total : 0.0);
+    printf("RESULT runtimes=%d ok=%d inferences=%zu wall_ms=%.3f "
+           "recorded_mean_ms=%.3f replayed_mean_ms=%.3f\n",
+           g_rt_count, ok, total, wall / 1e6,
+           total ? rec_sum / 1e6 / total : 0.0,
+           total ? rep_sum / 1e6 / total : 0.0);
+
+    for (int i = 0; i < g_rt_count; i++) {
+        for (size_t j = 0; j < g_rt[i].count; j++)
+            free(g_rt[i].events[j].payload);
+        free(g_rt[i].events);
+    }
+    return ok == g_rt_count ? 0 : 1;
+}